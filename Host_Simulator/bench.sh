@@ -0,0 +1,127 @@
+#!/bin/sh
+################################################################################
+# \file bench.sh
+# \version 1.0
+#
+# \brief
+# Protocol benchmark of the SPI master and SPI slave applications on the host
+# simulator.
+#
+# Builds the applications once per protocol variant, each into its own build
+# directory, and runs every variant at every SPI clock and bit error rate of
+# the matrix below with no pause between reads. Each run starts from
+# SENSOR_DETECT, so the detection, the slave command dispatch and the frame
+# or packet coding are all exercised; bit errors add retransmits and resets.
+# The results of all runs are written to build/protocol_bench/results.csv,
+# see the -o option of spi_sim.
+#
+# Given the results.csv of an earlier run, the transactions per second and
+# the 99th percentile latency of every run are compared with it, which gives
+# a regression check for protocol changes. Changes beyond BENCH_TOLERANCE
+# percent are marked with "!".
+#
+# The bit errors come from a fixed seed, but the devices run on host threads
+# and the host scheduler shows in the results. Simulated time runs at a
+# quarter of host time to keep that small; still, the transactions per
+# second of repeated runs differ by about 10%, and by up to 30% with bit
+# errors, and the 99th percentile more than that. Compare against a baseline
+# taken on the same host and rerun the marked entries before trusting them.
+#
+# Usage: bench.sh [baseline.csv]
+#   BENCH_RUN_S       simulated seconds per run (default 1)
+#   BENCH_TIME_SCALE  spi_sim -s, simulated against host time (default 0.25)
+#   BENCH_TOLERANCE   change in percent not marked (default 30)
+#   MAKE              make program (default make)
+#
+################################################################################
+# \copyright
+# Copyright 2018-2020 Cypress Semiconductor Corporation
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+################################################################################
+
+set -e
+
+cd "$(dirname "$0")"
+
+BENCH_DIR=build/protocol_bench
+RESULTS=$BENCH_DIR/results.csv
+RUN_S=${BENCH_RUN_S:-1}
+TIME_SCALE=${BENCH_TIME_SCALE:-0.25}
+TOLERANCE=${BENCH_TOLERANCE:-30}
+MAKE=${MAKE:-make}
+
+# Protocol variants: name, master defines, slave count. Packets carry one
+# command per chip select window, pipelined packets one command and the
+# previous response, frames every command of a state change at once and up
+# to a frame of samples per read.
+VARIANTS="
+packets|-DSPI_BATCHED_FRAMES=0|1
+pipelined|-DSPI_BATCHED_FRAMES=0 -DSPI_PIPELINED_TRANSFERS=1|1
+frames|-DSPI_PACKED_SAMPLES=0|1
+packed|-DSPI_PACKED_SAMPLES=1|1
+packed-3|-DSPI_PACKED_SAMPLES=1 -DSPI_SENSOR_COUNT=3|3
+"
+CLOCKS="1000000 4000000 12000000"
+ERROR_RATES="0 0.001"
+
+mkdir -p $BENCH_DIR
+rm -f $RESULTS
+
+echo "$VARIANTS" | while IFS='|' read -r name defines slaves; do
+    [ -n "$name" ] || continue
+    $MAKE -s BUILD=$BENCH_DIR/$name MASTER_DEFINES="$defines -DSLEEP_TIMEOUT=0" \
+          $BENCH_DIR/$name/spi_sim
+    for clock in $CLOCKS; do
+        for rate in $ERROR_RATES; do
+            echo "$name at $clock Hz, bit error rate $rate"
+            $BENCH_DIR/$name/spi_sim -d $RUN_S -s $TIME_SCALE -c $clock -e $rate \
+                                     -k $slaves -o $RESULTS -b $name > /dev/null
+        done
+    done
+done
+
+echo
+echo "Results in $(pwd)/$RESULTS"
+
+# Totals of each run, with the change against the baseline if one is given
+awk -F, -v baseline="$1" -v tolerance="$TOLERANCE" '
+    BEGIN {
+        if (baseline != "") {
+            while ((getline line < baseline) > 0) {
+                split(line, f, ",")
+                if (f[6] == "all") {
+                    tps[f[1] "," f[2] "," f[3]] = f[9]
+                    p99[f[1] "," f[2] "," f[3]] = f[12]
+                }
+            }
+        }
+        printf "\n  %-10s %9s %6s %10s %9s", "name", "clock", "errors", "trans/s", "p99 ms"
+        if (baseline != "") {
+            printf " %9s %9s", "trans/s", "p99"
+        }
+        printf "\n"
+    }
+    $6 == "all" {
+        key = $1 "," $2 "," $3
+        printf "  %-10s %9d %6s %10.1f %9.3f", $1, $2, $3, $9, $12
+        if ((key in tps) && tps[key] > 0 && p99[key] > 0) {
+            dt = 100 * ($9 / tps[key] - 1)
+            dp = 100 * ($12 / p99[key] - 1)
+            printf " %+8.1f%%%s %+8.1f%%%s", dt, (dt < -tolerance) ? "!" : " ",
+                   dp, (dp > tolerance) ? "!" : " "
+        }
+        printf "\n"
+    }
+' $RESULTS
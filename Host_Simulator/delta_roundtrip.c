@@ -0,0 +1,200 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file delta_roundtrip.c
+ *
+ * @brief
+ * Host round trip check of the sample block coding of SPI_Common/spi_delta.c.
+ *
+ * Encodes sample blocks the way the slave answers a packed burst read, into
+ * the room of one reply record, decodes them the way the master does and
+ * compares the result with the input. The blocks cover slowly changing
+ * temperatures as the slave reports them, steps at the int16_t limits and
+ * random samples, and damaged blocks must be rejected. For each kind the tool prints the bytes per sample on the
+ * wire against two for plain burst reads and four for data packets, and it
+ * exits with status 1 if any block does not come back unchanged.
+ *
+ * Usage: delta_roundtrip
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "spi_delta.h"
+#include "spi_protocol.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+#define ROUNDTRIP_SAMPLES                     (100000)
+#define ROUNDTRIP_PI                          (3.14159265358979323846)
+
+/******************************************************************************
+ *                                Variables Definitions
+ ******************************************************************************/
+static int16_t roundtrip_input[ROUNDTRIP_SAMPLES];
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ Function name: roundtrip_run
+
+ Function Description:
+ @brief    Sends roundtrip_input through the coding in blocks of at most one
+           reply record and prints the size of the encoding.
+
+ @param    *name   kind of samples
+ @param    count   number of samples in roundtrip_input
+
+ @return   int     number of blocks that did not come back unchanged
+ ******************************************************************************/
+static int roundtrip_run( const char *name, uint32_t count )
+{
+    uint8_t  data[PACKED_SAMPLES_MAX];
+    int16_t  output[PACKED_SAMPLES_MAX];
+    uint32_t offset = 0;
+    uint32_t bytes  = 0;
+    uint32_t blocks = 0;
+    uint32_t encoded, decoded, length, i;
+    int      failures = 0;
+
+    while ( offset < count )
+    {
+        length = spi_delta_encode( &roundtrip_input[offset],
+                                   MIN( count - offset, PACKED_SAMPLES_MAX ),
+                                   data, sizeof( data ), &encoded );
+        if ( ( 0 == encoded ) ||
+             !spi_delta_decode( data, length, output, PACKED_SAMPLES_MAX, &decoded ) ||
+             ( decoded != encoded ) )
+        {
+            failures++;
+            break;
+        }
+        for ( i = 0; i < decoded; i++ )
+        {
+            if ( output[i] != roundtrip_input[offset + i] )
+            {
+                failures++;
+                break;
+            }
+        }
+        /* Each block also costs its record header and count of samples left */
+        bytes  += length + sizeof( frame_record ) + 1;
+        offset += encoded;
+        blocks++;
+    }
+
+    printf( "  %-22s %8u %8u %12.2f %8s\n", name, count, blocks,
+            (double)bytes / count, failures ? "FAILED" : "ok" );
+    return failures;
+}
+
+/*******************************************************************************
+ Function name: roundtrip_damaged
+
+ Function Description:
+ @brief    Checks that the decoder rejects a block cut inside a sample and a
+           block stepping out of the int16_t range, as a damaged reply would.
+
+ @return   int     number of damaged blocks that were accepted
+ ******************************************************************************/
+static int roundtrip_damaged( void )
+{
+    static const int16_t limits[] = { INT16_MAX, INT16_MIN };
+    /* A step of +1 from INT16_MAX */
+    static const uint8_t overflow[] = { 0xFE, 0xFF, 0x03, 0x02 };
+    uint8_t  data[PACKED_SAMPLES_MAX];
+    int16_t  output[PACKED_SAMPLES_MAX];
+    uint32_t encoded, decoded, length;
+    int      failures = 0;
+
+    length = spi_delta_encode( limits, 2, data, sizeof( data ), &encoded );
+    if ( spi_delta_decode( data, length - 1, output, PACKED_SAMPLES_MAX, &decoded ) )
+    {
+        failures++;
+    }
+    if ( spi_delta_decode( overflow, sizeof( overflow ), output, PACKED_SAMPLES_MAX, &decoded ) )
+    {
+        failures++;
+    }
+    if ( spi_delta_decode( data, length, output, 1, &decoded ) )
+    {
+        failures++;
+    }
+
+    printf( "  %-22s %8u %8u %12s %8s\n", "damaged", 3, 3, "-", failures ? "FAILED" : "ok" );
+    return failures;
+}
+
+int main( void )
+{
+    unsigned int seed = 1;
+    int          failures = 0;
+    uint32_t     i;
+
+    printf( "  %-22s %8s %8s %12s %8s\n", "samples", "count", "blocks", "bytes/sample", "result" );
+
+    /* Readings every 100 ms of a room drifting by 2 C over a minute,
+       averaged over four noisy conversions as the slave reports them */
+    for ( i = 0; i < ROUNDTRIP_SAMPLES; i++ )
+    {
+        roundtrip_input[i] = (int16_t)lround( 2500.0 + 200.0 * sin( 2.0 * ROUNDTRIP_PI * i / 600.0 ) )
+                             + (int16_t)( rand_r( &seed ) % 3 ) - 1;
+    }
+    failures += roundtrip_run( "slow temperature", ROUNDTRIP_SAMPLES );
+
+    /* Largest steps, both directions */
+    for ( i = 0; i < ROUNDTRIP_SAMPLES; i++ )
+    {
+        roundtrip_input[i] = ( i & 1 ) ? INT16_MIN : INT16_MAX;
+    }
+    failures += roundtrip_run( "int16 limits", ROUNDTRIP_SAMPLES );
+
+    for ( i = 0; i < ROUNDTRIP_SAMPLES; i++ )
+    {
+        roundtrip_input[i] = (int16_t)rand_r( &seed );
+    }
+    failures += roundtrip_run( "random", ROUNDTRIP_SAMPLES );
+
+    failures += roundtrip_damaged();
+
+    printf( "\n  plain burst reads take 2 bytes/sample, data packets 4\n" );
+    return failures ? 1 : 0;
+}
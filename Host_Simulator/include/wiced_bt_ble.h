@@ -0,0 +1,96 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+/*******************************************************************************
+ * @file wiced_bt_ble.h
+ *
+ * @brief
+ * Host build of the BLE advertising interface.
+ *
+ * The advertisement data is kept but not put on air; a central simulated by
+ * sim_bt.c connects to a device as soon as it starts connectable
+ * advertisements.
+ ******************************************************************************/
+
+#ifndef WICED_BT_BLE_H
+#define WICED_BT_BLE_H
+
+#include "wiced.h"
+#include "wiced_bt_dev.h"
+
+/* Advertisement data types */
+#define BTM_BLE_ADVERT_TYPE_FLAG              (0x01)
+#define BTM_BLE_ADVERT_TYPE_128SRV_COMPLETE   (0x07)
+#define BTM_BLE_ADVERT_TYPE_NAME_COMPLETE     (0x09)
+
+/* Bits of BTM_BLE_ADVERT_TYPE_FLAG */
+#define BTM_BLE_GENERAL_DISCOVERABLE_FLAG     (0x1 << 1)
+#define BTM_BLE_BREDR_NOT_SUPPORTED           (0x1 << 2)
+
+/* Longest advertisement payload */
+#define BTM_BLE_ADVERT_DATA_MAX_LEN           (31)
+
+#define BLE_ADDR_PUBLIC                       (0x00)
+#define BLE_ADDR_RANDOM                       (0x01)
+
+typedef uint8_t  wiced_bt_ble_address_type_t;
+typedef uint8_t *wiced_bt_device_address_ptr_t;
+typedef uint8_t  wiced_bt_ble_advert_type_t;
+
+typedef enum
+{
+    BTM_BLE_ADVERT_OFF,
+    BTM_BLE_ADVERT_DIRECTED_HIGH,
+    BTM_BLE_ADVERT_DIRECTED_LOW,
+    BTM_BLE_ADVERT_UNDIRECTED_HIGH,
+    BTM_BLE_ADVERT_UNDIRECTED_LOW,
+    BTM_BLE_ADVERT_NONCONN_HIGH,
+    BTM_BLE_ADVERT_NONCONN_LOW,
+    BTM_BLE_ADVERT_DISCOVERABLE_HIGH,
+    BTM_BLE_ADVERT_DISCOVERABLE_LOW
+} wiced_bt_ble_advert_mode_t;
+
+/* One element of the advertisement data */
+typedef struct
+{
+    uint8_t                    *p_data;
+    uint16_t                    len;
+    wiced_bt_ble_advert_type_t  advert_type;
+} wiced_bt_ble_advert_elem_t;
+
+wiced_result_t wiced_bt_ble_set_raw_advertisement_data( uint8_t num_elem,
+                                                        wiced_bt_ble_advert_elem_t *p_data );
+wiced_result_t wiced_bt_start_advertisements( wiced_bt_ble_advert_mode_t advert_mode,
+                                              wiced_bt_ble_address_type_t directed_advertisement_bdaddr_type,
+                                              wiced_bt_device_address_ptr_t directed_advertisement_bdaddr_ptr );
+
+#endif /* WICED_BT_BLE_H */
@@ -0,0 +1,135 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+/*******************************************************************************
+ * @file wiced_bt_cfg.h
+ *
+ * @brief
+ * Host build of the Bluetooth stack configuration.
+ *
+ * The settings and buffer pool structures carry the fields and constants the
+ * code examples set, under the names of the SDK, so that their wiced_bt_cfg.c
+ * compiles unchanged. wiced_bt_stack_init() records the settings; the stub
+ * stack in sim_bt.c holds the ATT MTU exchange to gatt_cfg.max_mtu_size.
+ ******************************************************************************/
+
+#ifndef WICED_BT_CFG_H
+#define WICED_BT_CFG_H
+
+#include "wiced.h"
+#include "wiced_bt_ble.h"
+#include "wiced_bt_dev.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+#define WICED_BT_CFG_NUM_BUF_POOLS                        (4)
+
+#define WICED_BT_CFG_DEFAULT_CONN_MIN_INTERVAL            (24)
+#define WICED_BT_CFG_DEFAULT_CONN_MAX_INTERVAL            (40)
+#define WICED_BT_CFG_DEFAULT_CONN_LATENCY                 (0)
+#define WICED_BT_CFG_DEFAULT_CONN_SUPERVISION_TIMEOUT     (700)
+#define WICED_BT_CFG_DEFAULT_HIGH_DUTY_ADV_MIN_INTERVAL   (48)
+#define WICED_BT_CFG_DEFAULT_HIGH_DUTY_ADV_MAX_INTERVAL   (48)
+#define WICED_BT_CFG_DEFAULT_RANDOM_ADDRESS_NEVER_CHANGE  (0)
+
+#define BTM_SEC_NONE                                      (0)
+
+#define BTM_BLE_SCAN_MODE_NONE                            (0)
+#define BTM_BLE_SCAN_MODE_PASSIVE                         (1)
+#define BTM_BLE_SCAN_MODE_ACTIVE                          (2)
+
+#define BTM_BLE_ADVERT_CHNL_37                            (0x01 << 0)
+#define BTM_BLE_ADVERT_CHNL_38                            (0x01 << 1)
+#define BTM_BLE_ADVERT_CHNL_39                            (0x01 << 2)
+
+#define APPEARANCE_GENERIC_THERMOMETER                    (768)
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+typedef uint8_t wiced_bt_dev_class_t[3];
+
+typedef struct
+{
+    uint8_t     scan_mode;
+    uint16_t    conn_min_interval;
+    uint16_t    conn_max_interval;
+    uint16_t    conn_latency;
+    uint16_t    conn_supervision_timeout;
+} wiced_bt_cfg_ble_scan_settings_t;
+
+typedef struct
+{
+    uint8_t     channel_map;
+    uint16_t    high_duty_min_interval;
+    uint16_t    high_duty_max_interval;
+    uint16_t    high_duty_duration;
+    uint16_t    low_duty_min_interval;
+    uint16_t    low_duty_max_interval;
+    uint16_t    low_duty_duration;
+} wiced_bt_cfg_ble_advert_settings_t;
+
+typedef struct
+{
+    uint16_t    appearance;
+    uint8_t     client_max_links;
+    uint8_t     server_max_links;
+    uint16_t    max_attr_len;
+    uint16_t    max_mtu_size;
+} wiced_bt_cfg_gatt_settings_t;
+
+typedef struct
+{
+    uint8_t                             *device_name;
+    wiced_bt_dev_class_t                 device_class;
+    uint8_t                              security_requirement_mask;
+    uint16_t                             max_simultaneous_links;
+    wiced_bt_cfg_ble_scan_settings_t     ble_scan_cfg;
+    wiced_bt_cfg_ble_advert_settings_t   ble_advert_cfg;
+    wiced_bt_cfg_gatt_settings_t         gatt_cfg;
+    uint8_t                              addr_resolution_db_size;
+    uint8_t                              max_number_of_buffer_pools;
+    uint8_t                              rpa_refresh_timeout;
+    uint16_t                             ble_white_list_size;
+    int8_t                               default_ble_power_level;
+} wiced_bt_cfg_settings_t;
+
+typedef struct
+{
+    uint16_t    buf_size;
+    uint16_t    buf_count;
+} wiced_bt_cfg_buf_pool_t;
+
+#endif /* WICED_BT_CFG_H */
@@ -0,0 +1,105 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file wiced_bt_dev.h
+ *
+ * @brief
+ * Host build of the Bluetooth device management definitions.
+ *
+ * Only the management events the code examples react to are modelled.
+ ******************************************************************************/
+
+#ifndef WICED_BT_DEV_H
+#define WICED_BT_DEV_H
+
+#include "wiced.h"
+
+typedef uint8_t wiced_bt_device_address_t[6];
+
+/* Bluetooth management events */
+typedef enum
+{
+    BTM_ENABLED_EVT,
+    BTM_DISABLED_EVT,
+    BTM_POWER_MANAGEMENT_STATUS_EVT,
+    BTM_PIN_REQUEST_EVT,
+    BTM_USER_CONFIRMATION_REQUEST_EVT,
+    BTM_PASSKEY_NOTIFICATION_EVT,
+    BTM_PASSKEY_REQUEST_EVT,
+    BTM_KEYPRESS_NOTIFICATION_EVT,
+    BTM_PAIRING_IO_CAPABILITIES_BR_EDR_REQUEST_EVT,
+    BTM_PAIRING_IO_CAPABILITIES_BR_EDR_RESPONSE_EVT,
+    BTM_PAIRING_IO_CAPABILITIES_BLE_REQUEST_EVT,
+    BTM_PAIRING_COMPLETE_EVT,
+    BTM_ENCRYPTION_STATUS_EVT,
+    BTM_SECURITY_REQUEST_EVT,
+    BTM_SECURITY_FAILED_EVT,
+    BTM_SECURITY_ABORTED_EVT,
+    BTM_READ_LOCAL_OOB_DATA_COMPLETE_EVT,
+    BTM_REMOTE_OOB_DATA_REQUEST_EVT,
+    BTM_PAIRED_DEVICE_LINK_KEYS_UPDATE_EVT,
+    BTM_PAIRED_DEVICE_LINK_KEYS_REQUEST_EVT,
+    BTM_LOCAL_IDENTITY_KEYS_UPDATE_EVT,
+    BTM_LOCAL_IDENTITY_KEYS_REQUEST_EVT,
+    BTM_BLE_SCAN_STATE_CHANGED_EVT,
+    BTM_BLE_ADVERT_STATE_CHANGED_EVT,
+    BTM_SMP_REMOTE_OOB_DATA_REQUEST_EVT,
+    BTM_SMP_SC_REMOTE_OOB_DATA_REQUEST_EVT,
+    BTM_SMP_SC_LOCAL_OOB_DATA_NOTIFICATION_EVT,
+    BTM_SCO_CONNECTED_EVT,
+    BTM_SCO_DISCONNECTED_EVT,
+    BTM_SCO_CONNECTION_REQUEST_EVT,
+    BTM_SCO_CONNECTION_CHANGE_EVT,
+    BTM_BLE_CONNECTION_PARAM_UPDATE,
+} wiced_bt_management_evt_t;
+
+/* Event data of BTM_ENABLED_EVT */
+typedef struct
+{
+    wiced_result_t          status;
+} wiced_bt_dev_enabled_t;
+
+/* Management event data */
+typedef union
+{
+    wiced_bt_dev_enabled_t  enabled;
+    uint8_t                 ble_advert_state_changed;
+} wiced_bt_management_evt_data_t;
+
+/* Bluetooth management callback */
+typedef wiced_result_t (wiced_bt_management_cback_t)(
+                                    wiced_bt_management_evt_t event,
+                                    wiced_bt_management_evt_data_t *p_event_data );
+
+#endif /* WICED_BT_DEV_H */
@@ -0,0 +1,245 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+/*******************************************************************************
+ * @file wiced_bt_gatt.h
+ *
+ * @brief
+ * Host build of the GATT server interface.
+ *
+ * The GATT database uses the layout of the SDK: each attribute is its handle,
+ * permissions, length and, for writable attributes, a maximum length byte,
+ * followed by its UUID and value. The stub stack in sim_bt.c walks the
+ * database to find the characteristics, plays a central against the server
+ * and delivers the notifications to the harness. Callbacks run on the
+ * application thread of the device, as the stack callbacks do on the device.
+ ******************************************************************************/
+
+#ifndef WICED_BT_GATT_H
+#define WICED_BT_GATT_H
+
+#include "wiced.h"
+#include "wiced_bt_dev.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+#define LO_UINT16( a )                        ( (uint8_t)( ( a ) & 0xFF ) )
+#define HI_UINT16( a )                        ( (uint8_t)( ( ( a ) >> 8 ) & 0xFF ) )
+
+/* Attribute UUIDs */
+#define GATT_UUID_PRI_SERVICE                 (0x2800)
+#define GATT_UUID_CHAR_DECLARE                (0x2803)
+#define GATT_UUID_CHAR_CLIENT_CONFIG          (0x2902)
+
+/* Bits of the client characteristic configuration descriptor */
+#define GATT_CLIENT_CONFIG_NONE               (0x0000)
+#define GATT_CLIENT_CONFIG_NOTIFICATION       (0x0001)
+#define GATT_CLIENT_CONFIG_INDICATION         (0x0002)
+
+/* Default ATT MTU until the client exchanges a larger one */
+#define GATT_DEF_BLE_MTU_SIZE                 (23)
+/* Bytes of a notification PDU ahead of the value */
+#define GATT_NOTIFICATION_HEADER_SIZE         (3)
+
+/* Characteristic properties */
+#define GATTDB_CHAR_PROP_BROADCAST            (0x1 << 0)
+#define GATTDB_CHAR_PROP_READ                 (0x1 << 1)
+#define GATTDB_CHAR_PROP_WRITE_NO_RESPONSE    (0x1 << 2)
+#define GATTDB_CHAR_PROP_WRITE                (0x1 << 3)
+#define GATTDB_CHAR_PROP_NOTIFY               (0x1 << 4)
+#define GATTDB_CHAR_PROP_INDICATE             (0x1 << 5)
+
+/* Attribute permissions */
+#define GATTDB_PERM_NONE                      (0x00)
+#define GATTDB_PERM_VARIABLE_LENGTH           (0x1 << 0)
+#define GATTDB_PERM_READABLE                  (0x1 << 1)
+#define GATTDB_PERM_WRITE_CMD                 (0x1 << 2)
+#define GATTDB_PERM_WRITE_REQ                 (0x1 << 3)
+#define GATTDB_PERM_AUTH_READABLE             (0x1 << 4)
+#define GATTDB_PERM_RELIABLE_WRITE            (0x1 << 5)
+#define GATTDB_PERM_AUTH_WRITABLE             (0x1 << 6)
+#define GATTDB_PERM_WRITABLE                  ( GATTDB_PERM_WRITE_CMD | GATTDB_PERM_WRITE_REQ | \
+                                                GATTDB_PERM_AUTH_WRITABLE )
+#define GATTDB_PERM_MASK                      (0x7F)
+#define GATTDB_PERM_SERVICE_UUID_128          (0x1 << 7)
+
+/* GATT database entries */
+#define PRIMARY_SERVICE_UUID128( handle, service )                             \
+    LO_UINT16( handle ), HI_UINT16( handle ), GATTDB_PERM_READABLE, 18,        \
+    LO_UINT16( GATT_UUID_PRI_SERVICE ), HI_UINT16( GATT_UUID_PRI_SERVICE ),    \
+    service
+
+#define CHARACTERISTIC_UUID128( handle, handle_value, uuid, properties, permission ) \
+    LO_UINT16( handle ), HI_UINT16( handle ), GATTDB_PERM_READABLE, 21,        \
+    LO_UINT16( GATT_UUID_CHAR_DECLARE ), HI_UINT16( GATT_UUID_CHAR_DECLARE ),  \
+    ( properties ), LO_UINT16( handle_value ), HI_UINT16( handle_value ), uuid, \
+    LO_UINT16( handle_value ), HI_UINT16( handle_value ),                      \
+    (uint8_t)( ( permission ) | GATTDB_PERM_SERVICE_UUID_128 ), 16, uuid
+
+#define CHARACTERISTIC_UUID128_WRITABLE( handle, handle_value, uuid, properties, permission ) \
+    LO_UINT16( handle ), HI_UINT16( handle ), GATTDB_PERM_READABLE, 21,        \
+    LO_UINT16( GATT_UUID_CHAR_DECLARE ), HI_UINT16( GATT_UUID_CHAR_DECLARE ),  \
+    ( properties ), LO_UINT16( handle_value ), HI_UINT16( handle_value ), uuid, \
+    LO_UINT16( handle_value ), HI_UINT16( handle_value ),                      \
+    (uint8_t)( ( permission ) | GATTDB_PERM_SERVICE_UUID_128 ), 17, 0, uuid
+
+#define CHAR_DESCRIPTOR_UUID16_WRITABLE( handle, uuid, permission )           \
+    LO_UINT16( handle ), HI_UINT16( handle ), ( permission ), 3, 0,            \
+    LO_UINT16( uuid ), HI_UINT16( uuid )
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+/* Result of a GATT operation */
+typedef enum
+{
+    WICED_BT_GATT_SUCCESS               = 0x00,
+    WICED_BT_GATT_INVALID_HANDLE        = 0x01,
+    WICED_BT_GATT_READ_NOT_PERMIT       = 0x02,
+    WICED_BT_GATT_WRITE_NOT_PERMIT      = 0x03,
+    WICED_BT_GATT_INVALID_PDU           = 0x04,
+    WICED_BT_GATT_INVALID_OFFSET        = 0x07,
+    WICED_BT_GATT_INVALID_ATTR_LEN      = 0x0D,
+    WICED_BT_GATT_ERROR                 = 0x85,
+    WICED_BT_GATT_ILLEGAL_PARAMETER     = 0x87,
+    WICED_BT_GATT_BUSY                  = 0x8A,
+    WICED_BT_GATT_CONGESTED             = 0x8F,
+    WICED_BT_GATT_OUT_OF_RANGE          = 0xFF
+} wiced_bt_gatt_status_t;
+
+/* GATT events */
+typedef enum
+{
+    GATT_CONNECTION_STATUS_EVT,
+    GATT_OPERATION_CPLT_EVT,
+    GATT_DISCOVERY_RESULT_EVT,
+    GATT_DISCOVERY_CPLT_EVT,
+    GATT_ATTRIBUTE_REQUEST_EVT,
+    GATT_CONGESTION_EVT
+} wiced_bt_gatt_evt_t;
+
+/* Kinds of attribute request of a client */
+typedef enum
+{
+    GATTS_REQ_TYPE_READ = 1,
+    GATTS_REQ_TYPE_WRITE,
+    GATTS_REQ_TYPE_PREP_WRITE,
+    GATTS_REQ_TYPE_WRITE_EXEC,
+    GATTS_REQ_TYPE_MTU,
+    GATTS_REQ_TYPE_CONF
+} wiced_bt_gatt_request_type_t;
+
+typedef enum
+{
+    BT_TRANSPORT_BR_EDR = 1,
+    BT_TRANSPORT_LE
+} wiced_bt_transport_t;
+
+/* Data of GATT_CONNECTION_STATUS_EVT */
+typedef struct
+{
+    uint8_t                *bd_addr;
+    uint8_t                 addr_type;
+    uint16_t                conn_id;
+    wiced_bool_t            connected;
+    uint8_t                 link_role;
+    wiced_bt_transport_t    transport;
+    uint16_t                reason;
+} wiced_bt_gatt_connection_status_t;
+
+/* Read request: the server copies up to *p_val_len bytes from offset */
+typedef struct
+{
+    uint16_t                handle;
+    uint16_t                offset;
+    uint8_t                *p_val;
+    uint16_t               *p_val_len;
+    wiced_bool_t            is_long;
+} wiced_bt_gatt_read_t;
+
+/* Write request */
+typedef struct
+{
+    uint16_t                handle;
+    wiced_bool_t            is_prep;
+    uint16_t                offset;
+    uint16_t                val_len;
+    uint8_t                *p_val;
+} wiced_bt_gatt_write_t;
+
+typedef union
+{
+    wiced_bt_gatt_read_t    read_req;
+    wiced_bt_gatt_write_t   write_req;
+    uint16_t                mtu;
+    uint16_t                handle;
+} wiced_bt_gatt_request_data_t;
+
+/* Data of GATT_ATTRIBUTE_REQUEST_EVT */
+typedef struct
+{
+    uint16_t                        conn_id;
+    wiced_bt_gatt_request_type_t    request_type;
+    wiced_bt_gatt_request_data_t    data;
+} wiced_bt_gatt_attribute_request_t;
+
+/* Data of GATT_CONGESTION_EVT */
+typedef struct
+{
+    uint16_t                conn_id;
+    wiced_bool_t            congested;
+} wiced_bt_gatt_congestion_event_t;
+
+typedef union
+{
+    wiced_bt_gatt_connection_status_t   connection_status;
+    wiced_bt_gatt_attribute_request_t   attribute_request;
+    wiced_bt_gatt_congestion_event_t    congestion;
+} wiced_bt_gatt_event_data_t;
+
+/* GATT event callback */
+typedef wiced_bt_gatt_status_t (wiced_bt_gatt_cback_t)( wiced_bt_gatt_evt_t event,
+                                                        wiced_bt_gatt_event_data_t *p_event_data );
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+wiced_bt_gatt_status_t wiced_bt_gatt_register( wiced_bt_gatt_cback_t *p_gatt_cback );
+wiced_bt_gatt_status_t wiced_bt_gatt_db_init( const uint8_t *p_gatt_db, uint32_t size );
+wiced_bt_gatt_status_t wiced_bt_gatt_send_notification( uint16_t conn_id, uint16_t attr_handle,
+                                                        uint16_t val_len, uint8_t *p_val );
+
+#endif /* WICED_BT_GATT_H */
@@ -0,0 +1,55 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file wiced_bt_stack.h
+ *
+ * @brief
+ * Host build of the Bluetooth stack entry points.
+ *
+ * wiced_bt_stack_init() records the stack settings of the calling device and
+ * queues BTM_ENABLED_EVT on its application thread, exactly like the stack
+ * does once the controller is up. The buffer pools are not interpreted.
+ ******************************************************************************/
+
+#ifndef WICED_BT_STACK_H
+#define WICED_BT_STACK_H
+
+#include "wiced_bt_cfg.h"
+#include "wiced_bt_dev.h"
+
+wiced_result_t wiced_bt_stack_init( wiced_bt_management_cback_t *p_bt_management_cback,
+                                    const wiced_bt_cfg_settings_t *p_bt_cfg_settings,
+                                    const wiced_bt_cfg_buf_pool_t *p_bt_cfg_buf_pools );
+
+#endif /* WICED_BT_STACK_H */
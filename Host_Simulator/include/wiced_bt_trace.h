@@ -0,0 +1,70 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file wiced_bt_trace.h
+ *
+ * @brief
+ * Host build of the debug trace macros.
+ *
+ * Traces are written to stdout prefixed with the simulated time and the name
+ * of the device that produced them. They are dropped unless the simulator was
+ * started with tracing enabled, since formatting them costs host time that
+ * would otherwise show up in the measured latencies.
+ ******************************************************************************/
+
+#ifndef WICED_BT_TRACE_H
+#define WICED_BT_TRACE_H
+
+#include "wiced.h"
+
+typedef enum
+{
+    WICED_ROUTE_DEBUG_NONE  =  0x00,
+    WICED_ROUTE_DEBUG_TO_WICED_UART,
+    WICED_ROUTE_DEBUG_TO_HCI_UART,
+    WICED_ROUTE_DEBUG_TO_DBG_UART,
+    WICED_ROUTE_DEBUG_TO_PUART
+} wiced_debug_uart_types_t;
+
+void wiced_set_debug_uart( wiced_debug_uart_types_t uart );
+
+void sim_trace( const char *fmt, ... ) __attribute__((format(printf, 1, 2)));
+
+#ifdef WICED_BT_TRACE_ENABLE
+#define WICED_BT_TRACE(...)                   sim_trace(__VA_ARGS__)
+#else
+#define WICED_BT_TRACE(...)
+#endif
+
+#endif /* WICED_BT_TRACE_H */
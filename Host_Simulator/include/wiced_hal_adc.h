@@ -0,0 +1,90 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file wiced_hal_adc.h
+ *
+ * @brief
+ * Host build of the ADC driver.
+ *
+ * Channel voltages come from the analog model in sim_thermistor.c.
+ ******************************************************************************/
+
+#ifndef WICED_HAL_ADC_H
+#define WICED_HAL_ADC_H
+
+#include "wiced.h"
+
+typedef enum
+{
+    ADC_INPUT_P17,
+    ADC_INPUT_P16,
+    ADC_INPUT_P15,
+    ADC_INPUT_P14,
+    ADC_INPUT_P13,
+    ADC_INPUT_P12,
+    ADC_INPUT_P11,
+    ADC_INPUT_P10,
+    ADC_INPUT_P9,
+    ADC_INPUT_P8,
+    ADC_INPUT_P1,
+    ADC_INPUT_P0,
+    ADC_INPUT_VDDIO,
+    ADC_INPUT_VDD_CORE,
+    ADC_INPUT_ADC_BGREF,
+    ADC_INPUT_ADC_REFGND,
+    ADC_INPUT_P38,
+    ADC_INPUT_P37,
+    ADC_INPUT_P36,
+    ADC_INPUT_P35,
+    ADC_INPUT_P34,
+    ADC_INPUT_P33,
+    ADC_INPUT_P32,
+    ADC_INPUT_P31,
+    ADC_INPUT_P30,
+    ADC_INPUT_P29,
+    ADC_INPUT_P28,
+    ADC_INPUT_P23,
+    ADC_INPUT_P22,
+    ADC_INPUT_P21,
+    ADC_INPUT_P19,
+    ADC_INPUT_P18,
+    ADC_INPUT_CHANNEL_MASK = 0x3f,
+} ADC_INPUT_CHANNEL_SEL;
+
+void     wiced_hal_adc_init( void );
+uint32_t wiced_hal_adc_read_voltage( ADC_INPUT_CHANNEL_SEL channel );
+uint16_t wiced_hal_adc_read_raw_sample( ADC_INPUT_CHANNEL_SEL channel,
+                                        uint32_t reserved );
+
+#endif /* WICED_HAL_ADC_H */
@@ -0,0 +1,98 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file wiced_hal_gpio.h
+ *
+ * @brief
+ * Host build of the GPIO driver.
+ *
+ * Every simulated device owns a bank of pins. Pins of different devices are
+ * joined with sim_gpio_connect(); driving an output propagates the level to
+ * all connected inputs and fires their edge interrupts on the receiving
+ * device's application thread.
+ ******************************************************************************/
+
+#ifndef WICED_HAL_GPIO_H
+#define WICED_HAL_GPIO_H
+
+#include "wiced.h"
+
+/* Pin configuration */
+#define GPIO_INPUT_ENABLE                     (0x0200)
+#define GPIO_OUTPUT_ENABLE                    (0x0000)
+#define GPIO_OUTPUT_DISABLE                   (0x4000)
+#define GPIO_PULL_UP_DOWN_NONE                (0x0000)
+#define GPIO_PULL_UP                          (0x0400)
+#define GPIO_PULL_DOWN                        (0x0800)
+#define GPIO_INTERRUPT_ENABLE_MASK            (0x0008)
+#define GPIO_EN_INT_MASK                      (0x0018)
+#define GPIO_EN_INT_LEVEL_HIGH                (0x0008)
+#define GPIO_EN_INT_LEVEL_LOW                 (0x0018)
+#define GPIO_EN_INT_RISING_EDGE               (0x0000 | GPIO_INTERRUPT_ENABLE_MASK | 0x0100)
+#define GPIO_EN_INT_FALLING_EDGE              (0x0010 | GPIO_INTERRUPT_ENABLE_MASK | 0x0100)
+#define GPIO_EN_INT_BOTH_EDGE                 (0x0020 | GPIO_INTERRUPT_ENABLE_MASK | 0x0100)
+
+/* Output levels */
+#define GPIO_PIN_OUTPUT_LOW                   (0)
+#define GPIO_PIN_OUTPUT_HIGH                  (1)
+
+/* GPIO pins */
+typedef enum
+{
+    WICED_P00 = 0,  WICED_P01,  WICED_P02,  WICED_P03,  WICED_P04,
+    WICED_P05,      WICED_P06,  WICED_P07,  WICED_P08,  WICED_P09,
+    WICED_P10,      WICED_P11,  WICED_P12,  WICED_P13,  WICED_P14,
+    WICED_P15,      WICED_P16,  WICED_P17,  WICED_P18,  WICED_P19,
+    WICED_P20,      WICED_P21,  WICED_P22,  WICED_P23,  WICED_P24,
+    WICED_P25,      WICED_P26,  WICED_P27,  WICED_P28,  WICED_P29,
+    WICED_P30,      WICED_P31,  WICED_P32,  WICED_P33,  WICED_P34,
+    WICED_P35,      WICED_P36,  WICED_P37,  WICED_P38,  WICED_P39,
+    WICED_GPIO_MAX_PINS
+} wiced_bt_gpio_numbers_t;
+
+typedef void (wiced_hal_gpio_interrupt_handler_t)( void *data, uint8_t port_pin );
+
+void     wiced_hal_gpio_init( void );
+void     wiced_hal_gpio_configure_pin( uint32_t pin, uint32_t config, uint32_t outputVal );
+uint32_t wiced_hal_gpio_get_pin_config( uint32_t pin );
+void     wiced_hal_gpio_set_pin_output( uint32_t pin, uint32_t val );
+uint32_t wiced_hal_gpio_get_pin_output( uint32_t pin );
+uint32_t wiced_hal_gpio_get_pin_input_status( uint32_t pin );
+void     wiced_hal_gpio_register_pin_for_interrupt( uint16_t pin,
+                                                    wiced_hal_gpio_interrupt_handler_t *userfn,
+                                                    void *usrdata );
+uint32_t wiced_hal_gpio_get_pin_interrupt_status( uint32_t pin );
+void     wiced_hal_gpio_clear_pin_interrupt_status( uint32_t pin );
+
+#endif /* WICED_HAL_GPIO_H */
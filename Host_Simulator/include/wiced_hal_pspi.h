@@ -0,0 +1,109 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file wiced_hal_pspi.h
+ *
+ * @brief
+ * Host build of the peripheral SPI driver.
+ *
+ * A device that initialises the block with a non-zero clock is a master, a
+ * clock of 0 makes it a slave. Master transfers are clocked over the virtual
+ * bus in sim_pspi.c: every byte shifted out lands in the RX FIFO of the slave
+ * whose chip select is asserted, and every byte shifted in is taken from that
+ * slave's TX FIFO.
+ ******************************************************************************/
+
+#ifndef WICED_HAL_PSPI_H
+#define WICED_HAL_PSPI_H
+
+#include "wiced.h"
+
+typedef enum
+{
+    SPI1,
+    SPI2
+} spi_interface_t;
+
+typedef enum
+{
+    SPI_MSB_FIRST,
+    SPI_LSB_FIRST
+} SPI_ENDIAN;
+
+typedef enum
+{
+    SPI_SS_ACTIVE_LOW,
+    SPI_SS_ACTIVE_HIGH
+} SPI_SS_POLARITY;
+
+typedef enum
+{
+    SPI_MODE_0,
+    SPI_MODE_1,
+    SPI_MODE_2,
+    SPI_MODE_3
+} SPI_MODE;
+
+typedef enum
+{
+    SPIFFY_SUCCESS,
+    SPIFFY_ERROR
+} SPIFFY_STATUS;
+
+void          wiced_hal_pspi_init( spi_interface_t spi, uint32_t clkSpeed,
+                                   SPI_ENDIAN endian, SPI_SS_POLARITY polarity,
+                                   SPI_MODE mode );
+void          wiced_hal_pspi_reset( spi_interface_t spi );
+
+/* Master side */
+void          wiced_hal_pspi_tx_data( spi_interface_t spi, uint32_t txLen,
+                                      const uint8_t *txBuf );
+void          wiced_hal_pspi_rx_data( spi_interface_t spi, uint32_t rxLen,
+                                      uint8_t *rxBuf );
+void          wiced_hal_pspi_exchange_data( spi_interface_t spi, uint32_t len,
+                                            const uint8_t *txBuf, uint8_t *rxBuf );
+
+/* Slave side */
+SPIFFY_STATUS wiced_hal_pspi_slave_tx_data( spi_interface_t spi, uint32_t txLen,
+                                            const uint8_t *txBuf );
+SPIFFY_STATUS wiced_hal_pspi_slave_rx_data( spi_interface_t spi, uint32_t rxLen,
+                                            uint8_t *rxBuf );
+void          wiced_hal_pspi_slave_enable_rx( spi_interface_t spi );
+void          wiced_hal_pspi_slave_disable_rx( spi_interface_t spi );
+void          wiced_hal_pspi_slave_enable_tx( spi_interface_t spi );
+void          wiced_hal_pspi_slave_disable_tx( spi_interface_t spi );
+uint32_t      wiced_hal_pspi_slave_get_rx_fifo_count( spi_interface_t spi );
+uint32_t      wiced_hal_pspi_slave_get_tx_fifo_count( spi_interface_t spi );
+
+#endif /* WICED_HAL_PSPI_H */
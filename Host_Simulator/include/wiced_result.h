@@ -0,0 +1,130 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file wiced_result.h
+ *
+ * @brief
+ * Host build of the WICED result codes.
+ ******************************************************************************/
+
+#ifndef WICED_RESULT_H
+#define WICED_RESULT_H
+
+typedef enum
+{
+    WICED_SUCCESS                   = 0x00,
+    WICED_DELETED                   = 0x01,
+    WICED_POOL_ERROR                = 0x02,
+    WICED_PTR_ERROR                 = 0x03,
+    WICED_WAIT_ERROR                = 0x04,
+    WICED_SIZE_ERROR                = 0x05,
+    WICED_GROUP_ERROR               = 0x06,
+    WICED_NO_EVENTS                 = 0x07,
+    WICED_OPTION_ERROR              = 0x08,
+    WICED_QUEUE_ERROR               = 0x09,
+    WICED_QUEUE_EMPTY               = 0x0A,
+    WICED_QUEUE_FULL                = 0x0B,
+    WICED_SEMAPHORE_ERROR           = 0x0C,
+    WICED_NO_INSTANCE               = 0x0D,
+    WICED_THREAD_ERROR              = 0x0E,
+    WICED_PRIORITY_ERROR            = 0x0F,
+    WICED_START_ERROR               = 0x10,
+    WICED_DELETE_ERROR              = 0x11,
+    WICED_RESUME_ERROR              = 0x12,
+    WICED_CALLER_ERROR              = 0x13,
+    WICED_SUSPEND_ERROR             = 0x14,
+    WICED_TIMER_ERROR               = 0x15,
+    WICED_TICK_ERROR                = 0x16,
+    WICED_ACTIVATE_ERROR            = 0x17,
+    WICED_THRESH_ERROR              = 0x18,
+    WICED_SUSPEND_LIFTED            = 0x19,
+    WICED_WAIT_ABORTED              = 0x1A,
+    WICED_WAIT_ABORT_ERROR          = 0x1B,
+    WICED_MUTEX_ERROR               = 0x1C,
+    WICED_NOT_AVAILABLE             = 0x1D,
+    WICED_NOT_OWNED                 = 0x1E,
+    WICED_INHERIT_ERROR             = 0x1F,
+    WICED_NOT_DONE                  = 0x20,
+    WICED_CEILING_EXCEEDED          = 0x21,
+    WICED_INVALID_CEILING           = 0x22,
+    WICED_STA_JOIN_FAILED           = 0x23,
+    WICED_SLEEP_ERROR               = 0x24,
+    WICED_PENDING                   = 0x25,
+    WICED_TIMEOUT                   = 0x26,
+    WICED_PARTIAL_RESULTS           = 0x27,
+    WICED_ERROR                     = 0x28,
+    WICED_BADARG                    = 0x29,
+    WICED_BADOPTION                 = 0x2A,
+    WICED_UNSUPPORTED               = 0x2B,
+    WICED_OUT_OF_HEAP_SPACE         = 0x2C,
+    WICED_NOTUP                     = 0x2D,
+    WICED_UNFINISHED                = 0x2E,
+    WICED_CONNECTION_LOST           = 0x2F,
+    WICED_NOT_FOUND                 = 0x30,
+    WICED_PACKET_BUFFER_CORRUPT     = 0x31,
+    WICED_ROUTING_ERROR             = 0x32,
+    WICED_BADVALUE                  = 0x33,
+    WICED_WOULD_BLOCK               = 0x34,
+    WICED_ABORTED                   = 0x35,
+    WICED_CONNECTION_RESET          = 0x36,
+    WICED_CONNECTION_CLOSED         = 0x37,
+    WICED_NOT_CONNECTED             = 0x38,
+    WICED_ADDRESS_IN_USE            = 0x39,
+    WICED_NETWORK_INTERFACE_ERROR   = 0x3A,
+    WICED_ALREADY_CONNECTED         = 0x3B,
+    WICED_INVALID_INTERFACE         = 0x3C,
+    WICED_SOCKET_CREATE_FAIL        = 0x3D,
+    WICED_INVALID_SOCKET            = 0x3E,
+    WICED_CORRUPT_PACKET_BUFFER     = 0x3F,
+    WICED_UNKNOWN_NETWORK_TYPE      = 0x40,
+
+    WICED_BT_SUCCESS                = 0x00,
+    WICED_BT_ERROR                  = 0x28,
+    WICED_BT_PENDING                = 0x25,
+    WICED_BT_BUSY                   = 0x65,
+    WICED_BT_NO_RESOURCES           = 0x66,
+    WICED_BT_UNSUPPORTED            = 0x67,
+    WICED_BT_ILLEGAL_VALUE          = 0x68,
+    WICED_BT_WRONG_MODE             = 0x69,
+} wiced_result_t;
+
+typedef wiced_result_t wiced_bt_dev_status_t;
+
+typedef enum
+{
+    WICED_FALSE = 0,
+    WICED_TRUE  = 1
+} wiced_bool_t;
+
+#endif /* WICED_RESULT_H */
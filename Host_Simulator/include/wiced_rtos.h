@@ -0,0 +1,97 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file wiced_rtos.h
+ *
+ * @brief
+ * Host build of the WICED RTOS abstraction on top of POSIX threads.
+ *
+ * Threads inherit the simulated device of the thread that started them, so
+ * the HAL calls they make act on the right device. Delays and timeouts are in
+ * simulated milliseconds, see sim_sleep_us().
+ ******************************************************************************/
+
+#ifndef WICED_RTOS_H
+#define WICED_RTOS_H
+
+#include "wiced.h"
+
+#define WICED_NO_WAIT                         (0)
+#define WICED_WAIT_FOREVER                    (0xFFFFFFFF)
+
+typedef enum
+{
+    ALLOW_THREAD_TO_SLEEP,
+    KEEP_THREAD_ACTIVE
+} wiced_delay_type_t;
+
+typedef struct sim_thread     wiced_thread_t;
+typedef struct sim_queue      wiced_queue_t;
+typedef struct sim_mutex      wiced_mutex_t;
+typedef struct sim_semaphore  wiced_semaphore_t;
+
+typedef void (*wiced_thread_function_t)( uint32_t arg );
+
+wiced_thread_t    *wiced_rtos_create_thread( void );
+wiced_result_t     wiced_rtos_init_thread( wiced_thread_t *thread, uint8_t priority,
+                                           const char *name,
+                                           wiced_thread_function_t function,
+                                           uint32_t stack_size, void *arg );
+wiced_result_t     wiced_rtos_delay_milliseconds( uint32_t milliseconds,
+                                                  wiced_delay_type_t delay_type );
+wiced_result_t     wiced_rtos_delay_microseconds( uint32_t microseconds );
+
+wiced_queue_t     *wiced_rtos_create_queue( void );
+wiced_result_t     wiced_rtos_init_queue( wiced_queue_t *queue, const char *name,
+                                          uint32_t message_size,
+                                          uint32_t number_of_messages );
+wiced_result_t     wiced_rtos_push_to_queue( wiced_queue_t *queue, void *message,
+                                             uint32_t timeout_ms );
+wiced_result_t     wiced_rtos_pop_from_queue( wiced_queue_t *queue, void *message,
+                                              uint32_t timeout_ms );
+wiced_result_t     wiced_rtos_get_queue_occupancy( wiced_queue_t *queue,
+                                                   uint32_t *count );
+
+wiced_mutex_t     *wiced_rtos_create_mutex( void );
+wiced_result_t     wiced_rtos_init_mutex( wiced_mutex_t *mutex );
+wiced_result_t     wiced_rtos_lock_mutex( wiced_mutex_t *mutex );
+wiced_result_t     wiced_rtos_unlock_mutex( wiced_mutex_t *mutex );
+
+wiced_semaphore_t *wiced_rtos_create_semaphore( void );
+wiced_result_t     wiced_rtos_init_semaphore( wiced_semaphore_t *semaphore );
+wiced_result_t     wiced_rtos_set_semaphore( wiced_semaphore_t *semaphore );
+wiced_result_t     wiced_rtos_get_semaphore( wiced_semaphore_t *semaphore,
+                                             uint32_t timeout_ms );
+
+#endif /* WICED_RTOS_H */
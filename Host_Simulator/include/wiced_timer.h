@@ -0,0 +1,85 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file wiced_timer.h
+ *
+ * @brief
+ * Host build of the application timers.
+ *
+ * As on the device, timer callbacks are serialised on the owning device's
+ * application thread, so a BT callback that never returns also starves every
+ * timer of that device.
+ ******************************************************************************/
+
+#ifndef WICED_TIMER_H
+#define WICED_TIMER_H
+
+#include "wiced.h"
+
+#define TIMER_PARAM_TYPE                      uint32_t
+#define WICED_TIMER_PARAM_TYPE                TIMER_PARAM_TYPE
+
+typedef enum
+{
+    WICED_SECONDS_TIMER = 1,
+    WICED_MILLI_SECONDS_TIMER,
+    WICED_SECONDS_PERIODIC_TIMER,
+    WICED_MILLI_SECONDS_PERIODIC_TIMER
+} wiced_timer_type_t;
+
+typedef void (*wiced_timer_callback_fp)( TIMER_PARAM_TYPE cb_params );
+
+typedef struct wiced_timer
+{
+    struct wiced_timer     *next;
+    struct sim_device      *owner;
+    wiced_timer_callback_fp cback;
+    TIMER_PARAM_TYPE        cback_param;
+    wiced_timer_type_t      type;
+    uint64_t                period_us;
+    uint64_t                deadline_us;
+    wiced_bool_t            in_use;
+} wiced_timer_t;
+
+wiced_result_t wiced_init_timer( wiced_timer_t *p_timer, wiced_timer_callback_fp TimerCb,
+                                 TIMER_PARAM_TYPE cBackparam, wiced_timer_type_t type );
+wiced_result_t wiced_start_timer( wiced_timer_t *p_timer, uint32_t timeout );
+wiced_result_t wiced_stop_timer( wiced_timer_t *p_timer );
+wiced_bool_t   wiced_is_timer_in_use( wiced_timer_t *p_timer );
+wiced_result_t wiced_deinit_timer( wiced_timer_t *p_timer );
+
+/* Free running system time */
+uint64_t       clock_SystemTimeMicroseconds64( void );
+
+#endif /* WICED_TIMER_H */
@@ -0,0 +1,82 @@
+#!/bin/sh
+################################################################################
+# \file ram_report.sh
+# \version 1.0
+#
+# \brief
+# Static RAM of the SPI master and SPI slave applications per subsystem.
+#
+# Lists the initialized and zeroed data (data and bss) of every object file
+# of an application, which is one subsystem each: the application itself,
+# the sample buffers of the slave, the log, the frame code and so on. Below
+# each file its variables of at least REPORT_MIN_BYTES are listed, such as
+# the sensor table and the static pools of the master, so the cost of one
+# more sensor or a larger pool can be read off directly. Thread stacks and
+# RTOS objects are allocated by the RTOS and are not included; see the stack
+# high water marks in the statistics dump of each application.
+#
+# The host build has 8 byte pointers and pads differently from the Cortex-M
+# firmware, so pointer heavy structures come out larger than on the device.
+# The firmware makefiles run the script on the linked ELF file with the ARM
+# nm after every build (POSTBUILD), which gives the RAM of the device by
+# variable in build/<target>/<config>/ram_report.txt of each application.
+#
+# Usage: ram_report.sh <directory or object>...
+#   NM                nm program (default nm)
+#   REPORT_MIN_BYTES  smallest variable listed (default 32)
+#
+################################################################################
+# \copyright
+# Copyright 2018-2020 Cypress Semiconductor Corporation
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+################################################################################
+
+set -e
+
+NM=${NM:-nm}
+MIN_BYTES=${REPORT_MIN_BYTES:-32}
+
+for target in "$@"; do
+    if [ -d "$target" ]; then
+        files=$(find "$target" -name '*.o' | sort)
+        echo "Static RAM of $target, bytes"
+    else
+        files=$target
+        echo "Static RAM of $(basename "$target"), bytes"
+    fi
+    for file in $files; do
+        # Data and bss symbols with their sizes: "<size> <type> <name>"
+        $NM -S -t d --size-sort -r "$file" | awk -v file="${file#$target/}" -v min="$MIN_BYTES" '
+            NF == 4 && $3 ~ /^[bBdDcC]$/ {
+                size = $2 + 0
+                total += size
+                if (size >= min) {
+                    vars[++n] = sprintf("      %-28s %7d", $4, size)
+                }
+            }
+            END {
+                if (total > 0) {
+                    printf "  %-30s %7d\n", file, total
+                    for (i = 1; i <= n; i++) {
+                        print vars[i]
+                    }
+                }
+                printf "#total %d\n", total
+            }'
+    done | awk '
+        /^#total / { sum += $2; next }
+        { print }
+        END { printf "  %-30s %7d\n\n", "total", sum }'
+done
@@ -0,0 +1,323 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file sim.h
+ *
+ * @brief
+ * Host side simulator for the SPI master and SPI slave applications.
+ *
+ * The simulator runs the unmodified application sources on Linux. Each
+ * application image is a simulated device with its own application thread,
+ * GPIO bank and pSPI block. The WICED HAL, RTOS and stack entry points the
+ * applications call are implemented on top of this interface and act on the
+ * device of the calling thread.
+ ******************************************************************************/
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "wiced.h"
+#include "wiced_bt_cfg.h"
+#include "wiced_bt_dev.h"
+#include "wiced_bt_gatt.h"
+#include "wiced_hal_gpio.h"
+#include "wiced_hal_pspi.h"
+#include "wiced_timer.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+/* Largest pSPI FIFO the bus model accepts */
+#define SIM_FIFO_MAX_DEPTH                    (1024)
+/* Bytes of MOSI/MISO kept per chip select window for the window hook, enough
+   for a request frame followed by a full reply frame */
+#define SIM_WINDOW_CAPTURE                    (128)
+/* Level shifted in on MISO when no slave drives the line */
+#define SIM_MISO_IDLE                         (0xFF)
+/* Level shifted out on MOSI by a receive only master transfer */
+#define SIM_MOSI_DUMMY                        (0xFF)
+/* Probability of a bit error per byte added for each 10% the SPI clock
+   exceeds link_max_hz */
+#define SIM_OVERCLOCK_ERROR_RATE              (0.01)
+/* Maximum number of devices on one simulated board */
+#define SIM_MAX_DEVICES                       (8)
+/* Connection id the simulated central gets */
+#define SIM_BT_CONN_ID                        (1)
+/* Longest value the simulated central writes once connected */
+#define SIM_BT_MAX_WRITE                      (16)
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+/* Faults the bus can inject into the traffic of a slave, each hitting the
+   next byte the slave exchanges */
+typedef enum
+{
+    SIM_FAULT_NONE,
+    /* One bit of the byte arrives flipped in the RX FIFO */
+    SIM_FAULT_BIT_FLIP,
+    /* The byte never reaches the RX FIFO */
+    SIM_FAULT_DROP,
+    /* Both FIFOs stop moving until the slave resets its pSPI block: MOSI
+       bytes are lost and MISO stays at SIM_MISO_IDLE */
+    SIM_FAULT_STUCK_FIFO,
+    /* The slave misses a clock edge and is one bit late on MOSI and MISO
+       for the rest of the chip select window */
+    SIM_FAULT_CLOCK_SLIP
+} sim_fault_t;
+
+/* Bus and timing parameters, set by the harness before devices start */
+typedef struct
+{
+    /* Overrides the clock the master requests in wiced_hal_pspi_init, 0 to
+       use the requested clock */
+    uint32_t    clock_hz;
+    /* Depth of each slave TX and RX FIFO in bytes */
+    uint32_t    fifo_depth;
+    /* Fixed setup latency added to every master transfer, in us */
+    uint32_t    latency_us;
+    /* Simulated time runs this many times faster than host time */
+    double      time_scale;
+    /* Time one thermistor conversion takes on the slave, in us */
+    uint32_t    adc_conversion_us;
+    /* Ambient temperature model: base, peak swing and period of the swing */
+    double      temp_base_c;
+    double      temp_swing_c;
+    double      temp_period_s;
+    /* Probability that a byte on MOSI or MISO arrives with one bit flipped */
+    double      bit_error_rate;
+    /* Fastest SPI clock the board traces carry without errors, 0 for no
+       limit; faster clocks add SIM_OVERCLOCK_ERROR_RATE bit errors */
+    uint32_t    link_max_hz;
+    /* Print the WICED_BT_TRACE output of the devices */
+    int         trace;
+} sim_config_t;
+
+/* One byte FIFO of the slave pSPI block */
+typedef struct
+{
+    uint8_t     data[SIM_FIFO_MAX_DEPTH];
+    uint32_t    head;
+    uint32_t    count;
+} sim_fifo_t;
+
+/* pSPI block of one device */
+typedef struct
+{
+    wiced_bool_t    initialized;
+    wiced_bool_t    is_master;
+    uint32_t        clock_hz;
+    SPI_ENDIAN      endian;
+    SPI_MODE        mode;
+    wiced_bool_t    rx_enabled;
+    wiced_bool_t    tx_enabled;
+    sim_fifo_t      rx_fifo;
+    sim_fifo_t      tx_fifo;
+    /* Slave: pin of this device that acts as chip select input */
+    uint32_t        cs_pin;
+    /* Counters */
+    uint32_t        resets;
+    uint64_t        bytes;
+    uint32_t        rx_discarded;
+    uint32_t        rx_overflows;
+    uint32_t        tx_underruns;
+    /* Master: bytes damaged on the wire by bit_error_rate or overclocking */
+    uint32_t        bit_errors;
+    /* Master: times the clock was changed by initializing again */
+    uint32_t        clock_changes;
+    /* Slave: disconnected from MOSI and MISO from unplug_start_us until
+       unplug_end_us, chip select still reaches it */
+    uint64_t        unplug_start_us;
+    uint64_t        unplug_end_us;
+    /* Slave: fault waiting for the next byte, faults that hit so far and
+       whether a SIM_FAULT_STUCK_FIFO holds the FIFOs */
+    sim_fault_t     fault;
+    uint32_t        faults;
+    wiced_bool_t    fifo_stuck;
+} sim_pspi_t;
+
+/* Deferred call on a device's application thread */
+typedef struct sim_event
+{
+    struct sim_event   *next;
+    void              (*fn)( void *arg, uint32_t param );
+    void               *arg;
+    uint32_t            param;
+} sim_event_t;
+
+/* One pin of a device */
+typedef struct
+{
+    uint32_t                            config;
+    uint8_t                             level;
+    uint8_t                             interrupt_pending;
+    wiced_hal_gpio_interrupt_handler_t *handler;
+    void                               *usrdata;
+} sim_pin_t;
+
+struct sim_device;
+
+/* Notification received by the simulated central */
+typedef void (sim_notify_hook_t)( const struct sim_device *dev, uint16_t handle,
+                                  const uint8_t *data, uint16_t len );
+
+/* Simulated central, see sim_bt_central(). It connects as soon as the
+   device advertises, exchanges the MTU, enables the notifications of every
+   client configuration descriptor and then writes write_value to the value
+   of the characteristic write_uuid, if given. */
+typedef struct
+{
+    uint16_t            mtu;
+    uint8_t             write_uuid[16];
+    uint8_t             write_value[SIM_BT_MAX_WRITE];
+    uint16_t            write_len;
+    sim_notify_hook_t  *hook;
+} sim_central_t;
+
+/* Bluetooth LE side of a device, kept by the stub stack in sim_bt.c */
+typedef struct
+{
+    wiced_bt_gatt_cback_t   *gatt_cback;
+    const uint8_t           *gatt_db;
+    uint32_t                 gatt_db_size;
+    wiced_bool_t             advertising;
+    const sim_central_t     *central;
+    /* Connection to the central, 0 when not connected */
+    uint16_t                 conn_id;
+    uint16_t                 mtu;
+    /* Counters */
+    uint32_t                 connections;
+    uint32_t                 notifications;
+    uint64_t                 notify_bytes;
+    uint32_t                 notify_rejected;
+    uint32_t                 request_errors;
+} sim_bt_t;
+
+/* Simulated device */
+typedef struct sim_device
+{
+    const char                      *name;
+    void                           (*app_start)( void );
+    pthread_t                        app_thread;
+
+    /* Application thread event loop, guarded by lock */
+    pthread_mutex_t                  lock;
+    pthread_cond_t                   wake;
+    sim_event_t                     *event_head;
+    sim_event_t                     *event_tail;
+    wiced_timer_t                   *timers;
+
+    wiced_bt_management_cback_t     *bt_cback;
+    const wiced_bt_cfg_settings_t   *bt_cfg;
+    sim_bt_t                         bt;
+
+    sim_pin_t                        pins[WICED_GPIO_MAX_PINS];
+    sim_pspi_t                       spi;
+
+    /* Clock of the device, see clock_SystemTimeMicroseconds64: the
+       simulated time plus clock_offset_us, running clock_drift_ppm fast */
+    int64_t                          clock_offset_us;
+    double                           clock_drift_ppm;
+
+    /* Times an RTOS thread of the device blocked in a delay or a wait,
+       each of which costs a wakeup on the device */
+    uint32_t                         sleeps;
+} sim_device_t;
+
+/* A completed chip select window as seen by the bus */
+typedef struct
+{
+    const sim_device_t  *slave;
+    uint64_t             start_us;
+    uint64_t             end_us;
+    uint32_t             mosi_count;
+    uint32_t             miso_count;
+    /* Time an injected fault hit a byte of the window, 0 for none */
+    uint64_t             fault_us;
+    uint8_t              mosi[SIM_WINDOW_CAPTURE];
+    uint8_t              miso[SIM_WINDOW_CAPTURE];
+} sim_window_t;
+
+typedef void (sim_window_hook_t)( const sim_window_t *window );
+
+/******************************************************************************
+ *                                Variables
+ ******************************************************************************/
+
+extern sim_config_t sim_config;
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+/* Devices */
+sim_device_t *sim_device_create( const char *name, void (*app_start)( void ) );
+void          sim_device_start( sim_device_t *dev );
+sim_device_t *sim_device_current( void );
+void          sim_device_bind( sim_device_t *dev );
+void          sim_device_post( sim_device_t *dev, void (*fn)( void *, uint32_t ),
+                               void *arg, uint32_t param );
+
+/* Time */
+uint64_t      sim_now_us( void );
+void          sim_sleep_us( uint64_t us );
+void          sim_deadline_to_timespec( uint64_t deadline_us, struct timespec *ts );
+void          sim_cond_init( pthread_cond_t *cond );
+
+/* GPIO */
+void          sim_gpio_connect( sim_device_t *src, uint32_t src_pin,
+                                sim_device_t *dst, uint32_t dst_pin );
+void          sim_gpio_drive( sim_device_t *dev, uint32_t pin, uint8_t level );
+
+/* pSPI bus */
+void          sim_pspi_attach_slave( sim_device_t *slave, uint32_t cs_pin );
+void          sim_pspi_cs_changed( sim_device_t *slave, uint8_t level );
+void          sim_pspi_set_window_hook( sim_window_hook_t *hook );
+void          sim_pspi_inject_fault( sim_device_t *slave, sim_fault_t fault );
+
+/* Bluetooth LE */
+void          sim_bt_central( sim_device_t *dev, const sim_central_t *central );
+
+/* Analog front end */
+double        sim_ambient_temperature( uint64_t now_us );
+
+/* Trace */
+void          sim_trace_raw( const char *fmt, ... ) __attribute__((format(printf, 1, 2)));
+
+#endif /* SIM_H */
@@ -0,0 +1,291 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+/*******************************************************************************
+ * @file sim_bt.c
+ *
+ * @brief
+ * Stub Bluetooth LE stack of the simulated devices: advertising, the GATT
+ * server interface and a simulated central.
+ *
+ * Nothing goes on air. A central given to sim_bt_central() connects to the
+ * device once it advertises and drives the GATT callback of the device
+ * through the requests a phone would make, all on the application thread of
+ * the device. Notifications are checked against the negotiated MTU, counted
+ * and handed to the hook of the central.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include <string.h>
+
+#include "sim.h"
+#include "wiced_bt_ble.h"
+#include "wiced_bt_gatt.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+/* Bytes of an attribute ahead of its value: handle, permissions, length */
+#define SIM_BT_ATTR_HEADER                    (4)
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ Function name: sim_bt_next_attr
+
+ Function Description:
+ @brief    Walks the GATT database of a device.
+
+ @param    dev     device
+ @param    offset  offset of the attribute in the database, updated to the
+                   next attribute
+ @param    handle  receives the handle of the attribute
+ @param    uuid    receives the UUID of the attribute
+ @param    uuid_len  receives the UUID length, 2 or 16
+
+ @return   int  1 if an attribute was returned, 0 at the end of the database
+ ******************************************************************************/
+static int sim_bt_next_attr( const sim_device_t *dev, uint32_t *offset, uint16_t *handle,
+                             const uint8_t **uuid, uint32_t *uuid_len )
+{
+    const uint8_t *attr = dev->bt.gatt_db + *offset;
+    uint32_t       skip;
+
+    if ( *offset + SIM_BT_ATTR_HEADER > dev->bt.gatt_db_size )
+    {
+        return 0;
+    }
+    /* Writable attributes carry their maximum length ahead of the UUID */
+    skip      = ( attr[2] & GATTDB_PERM_WRITABLE ) ? 1 : 0;
+    *handle   = (uint16_t)( attr[0] | ( attr[1] << 8 ) );
+    *uuid     = attr + SIM_BT_ATTR_HEADER + skip;
+    *uuid_len = ( attr[2] & GATTDB_PERM_SERVICE_UUID_128 ) ? 16 : 2;
+    *offset  += SIM_BT_ATTR_HEADER + attr[3];
+    return *offset <= dev->bt.gatt_db_size;
+}
+
+static wiced_bt_gatt_status_t sim_bt_request( sim_device_t *dev,
+                                              wiced_bt_gatt_attribute_request_t *request )
+{
+    wiced_bt_gatt_event_data_t  data;
+    wiced_bt_gatt_status_t      status;
+
+    data.attribute_request         = *request;
+    data.attribute_request.conn_id = dev->bt.conn_id;
+    status = dev->bt.gatt_cback( GATT_ATTRIBUTE_REQUEST_EVT, &data );
+    if ( status != WICED_BT_GATT_SUCCESS )
+    {
+        dev->bt.request_errors++;
+    }
+    return status;
+}
+
+static void sim_bt_write( sim_device_t *dev, uint16_t handle, const uint8_t *value,
+                          uint16_t len )
+{
+    wiced_bt_gatt_attribute_request_t   request;
+    uint8_t                             copy[SIM_BT_MAX_WRITE];
+
+    memcpy( copy, value, len );
+    memset( &request, 0, sizeof( request ) );
+    request.request_type            = GATTS_REQ_TYPE_WRITE;
+    request.data.write_req.handle   = handle;
+    request.data.write_req.val_len  = len;
+    request.data.write_req.p_val    = copy;
+    sim_bt_request( dev, &request );
+}
+
+/* Central side of a connection, on the application thread of the device */
+static void sim_bt_connect( void *arg, uint32_t param )
+{
+    sim_device_t                       *dev     = arg;
+    const sim_central_t                *central = dev->bt.central;
+    static uint8_t                      central_addr[6] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+    static const uint8_t                enable[2] = { LO_UINT16( GATT_CLIENT_CONFIG_NOTIFICATION ),
+                                                      HI_UINT16( GATT_CLIENT_CONFIG_NOTIFICATION ) };
+    wiced_bt_gatt_event_data_t          data;
+    wiced_bt_gatt_attribute_request_t   request;
+    uint32_t                            offset;
+    uint16_t                            handle;
+    const uint8_t                      *uuid;
+    uint32_t                            uuid_len;
+    uint16_t                            mtu;
+    wiced_bool_t                        is_value = WICED_FALSE;
+
+    (void)param;
+    if ( !dev->bt.gatt_cback || dev->bt.conn_id || !dev->bt.advertising )
+    {
+        return;
+    }
+    dev->bt.advertising = WICED_FALSE;
+    dev->bt.conn_id     = SIM_BT_CONN_ID;
+    dev->bt.mtu         = GATT_DEF_BLE_MTU_SIZE;
+    dev->bt.connections++;
+
+    memset( &data, 0, sizeof( data ) );
+    data.connection_status.bd_addr   = central_addr;
+    data.connection_status.conn_id   = dev->bt.conn_id;
+    data.connection_status.connected = WICED_TRUE;
+    data.connection_status.transport = BT_TRANSPORT_LE;
+    dev->bt.gatt_cback( GATT_CONNECTION_STATUS_EVT, &data );
+
+    /* MTU exchange; the server may use less than the central offers, and
+       the stack no more than its settings allow */
+    mtu = central->mtu;
+    if ( dev->bt_cfg && ( dev->bt_cfg->gatt_cfg.max_mtu_size < mtu ) )
+    {
+        mtu = dev->bt_cfg->gatt_cfg.max_mtu_size;
+    }
+    if ( mtu > GATT_DEF_BLE_MTU_SIZE )
+    {
+        memset( &request, 0, sizeof( request ) );
+        request.request_type = GATTS_REQ_TYPE_MTU;
+        request.data.mtu     = mtu;
+        if ( sim_bt_request( dev, &request ) == WICED_BT_GATT_SUCCESS )
+        {
+            dev->bt.mtu = mtu;
+        }
+    }
+
+    for ( offset = 0; sim_bt_next_attr( dev, &offset, &handle, &uuid, &uuid_len ); )
+    {
+        if ( ( uuid_len == 2 ) &&
+             ( ( uuid[0] | ( uuid[1] << 8 ) ) == GATT_UUID_CHAR_CLIENT_CONFIG ) )
+        {
+            sim_bt_write( dev, handle, enable, sizeof( enable ) );
+        }
+        /* The value of a characteristic follows its declaration and has the
+           UUID the declaration ends with */
+        if ( is_value && central->write_len && ( uuid_len == 16 ) &&
+             ( 0 == memcmp( uuid, central->write_uuid, 16 ) ) )
+        {
+            sim_bt_write( dev, handle, central->write_value, central->write_len );
+        }
+        is_value = ( uuid_len == 2 ) &&
+                   ( ( uuid[0] | ( uuid[1] << 8 ) ) == GATT_UUID_CHAR_DECLARE );
+    }
+}
+
+/*******************************************************************************
+ Function name: sim_bt_central
+
+ Function Description:
+ @brief    Puts a simulated central in range of a device. It connects as soon
+           as the device advertises; set it up before the device starts.
+
+ @param    dev      device acting as GATT server
+ @param    central  central, must outlive the device
+ ******************************************************************************/
+void sim_bt_central( sim_device_t *dev, const sim_central_t *central )
+{
+    dev->bt.central = central;
+}
+
+wiced_result_t wiced_bt_ble_set_raw_advertisement_data( uint8_t num_elem,
+                                                        wiced_bt_ble_advert_elem_t *p_data )
+{
+    uint32_t len = 0;
+    uint8_t  i;
+
+    /* Each element costs a length and a type byte on air */
+    for ( i = 0; i < num_elem; i++ )
+    {
+        len += 2 + p_data[i].len;
+    }
+    return ( len <= BTM_BLE_ADVERT_DATA_MAX_LEN ) ? WICED_BT_SUCCESS : WICED_BADARG;
+}
+
+wiced_result_t wiced_bt_start_advertisements( wiced_bt_ble_advert_mode_t advert_mode,
+                                              wiced_bt_ble_address_type_t directed_advertisement_bdaddr_type,
+                                              wiced_bt_device_address_ptr_t directed_advertisement_bdaddr_ptr )
+{
+    sim_device_t *dev = sim_device_current();
+
+    (void)directed_advertisement_bdaddr_type;
+    (void)directed_advertisement_bdaddr_ptr;
+    if ( dev->bt.conn_id && ( advert_mode != BTM_BLE_ADVERT_OFF ) )
+    {
+        /* One connection at a time */
+        return WICED_ERROR;
+    }
+    dev->bt.advertising = ( advert_mode != BTM_BLE_ADVERT_OFF ) &&
+                          ( advert_mode != BTM_BLE_ADVERT_NONCONN_HIGH ) &&
+                          ( advert_mode != BTM_BLE_ADVERT_NONCONN_LOW );
+    if ( dev->bt.advertising && dev->bt.central )
+    {
+        sim_device_post( dev, sim_bt_connect, dev, 0 );
+    }
+    return WICED_BT_SUCCESS;
+}
+
+wiced_bt_gatt_status_t wiced_bt_gatt_register( wiced_bt_gatt_cback_t *p_gatt_cback )
+{
+    sim_device_current()->bt.gatt_cback = p_gatt_cback;
+    return WICED_BT_GATT_SUCCESS;
+}
+
+wiced_bt_gatt_status_t wiced_bt_gatt_db_init( const uint8_t *p_gatt_db, uint32_t size )
+{
+    sim_device_t *dev = sim_device_current();
+
+    dev->bt.gatt_db      = p_gatt_db;
+    dev->bt.gatt_db_size = size;
+    return WICED_BT_GATT_SUCCESS;
+}
+
+wiced_bt_gatt_status_t wiced_bt_gatt_send_notification( uint16_t conn_id, uint16_t attr_handle,
+                                                        uint16_t val_len, uint8_t *p_val )
+{
+    sim_device_t *dev = sim_device_current();
+
+    if ( !dev->bt.conn_id || ( conn_id != dev->bt.conn_id ) )
+    {
+        dev->bt.notify_rejected++;
+        return WICED_BT_GATT_ERROR;
+    }
+    if ( val_len > dev->bt.mtu - GATT_NOTIFICATION_HEADER_SIZE )
+    {
+        dev->bt.notify_rejected++;
+        return WICED_BT_GATT_INVALID_ATTR_LEN;
+    }
+    dev->bt.notifications++;
+    dev->bt.notify_bytes += val_len;
+    if ( dev->bt.central->hook )
+    {
+        dev->bt.central->hook( dev, attr_handle, p_val, val_len );
+    }
+    return WICED_BT_GATT_SUCCESS;
+}
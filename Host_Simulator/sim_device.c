@@ -0,0 +1,429 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file sim_device.c
+ *
+ * @brief
+ * Simulated devices: application thread, time base, traces and the Bluetooth
+ * stack bring-up.
+ *
+ * Every device runs its application_start() on its own application thread and
+ * then services that thread's event loop, which executes the stack callbacks,
+ * timer callbacks and GPIO interrupt callbacks of the device one at a time.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sim.h"
+#include "wiced_bt_stack.h"
+#include "wiced_bt_trace.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+#define SIM_TRACE_LINE_MAX                    (512)
+/* Host sleeps shorter than this are spun to keep transfer timing tight */
+#define SIM_SPIN_THRESHOLD_NS                 (100000)
+
+/******************************************************************************
+ *                                Variables Definitions
+ ******************************************************************************/
+sim_config_t sim_config =
+{
+    .clock_hz           = 0,
+    .fifo_depth         = 64,
+    .latency_us         = 0,
+    .time_scale         = 1.0,
+    .adc_conversion_us  = 1000,
+    .temp_base_c        = 25.0,
+    .temp_swing_c       = 1.5,
+    .temp_period_s      = 60.0,
+    .bit_error_rate     = 0.0,
+    .link_max_hz        = 0,
+    .trace              = 0,
+};
+
+static __thread sim_device_t   *current_device;
+static struct timespec          sim_epoch;
+static pthread_once_t           sim_epoch_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t          trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+extern void sim_timer_service( sim_device_t *dev, uint64_t *next_deadline );
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+static void sim_epoch_init( void )
+{
+    clock_gettime( CLOCK_MONOTONIC, &sim_epoch );
+}
+
+static uint64_t sim_host_ns( void )
+{
+    struct timespec now;
+
+    pthread_once( &sim_epoch_once, sim_epoch_init );
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (uint64_t)( now.tv_sec - sim_epoch.tv_sec ) * 1000000000ull
+           + (uint64_t)now.tv_nsec - (uint64_t)sim_epoch.tv_nsec;
+}
+
+/*******************************************************************************
+ Function name: sim_now_us
+
+ Function Description:
+ @brief    Returns the simulated time since the simulator started.
+
+ @return   uint64_t  simulated microseconds
+ ******************************************************************************/
+uint64_t sim_now_us( void )
+{
+    return (uint64_t)( (double)sim_host_ns() * sim_config.time_scale / 1000.0 );
+}
+
+/*******************************************************************************
+ Function name: sim_sleep_us
+
+ Function Description:
+ @brief    Blocks the calling thread for the given simulated time.
+
+ @param    us  simulated microseconds
+ ******************************************************************************/
+void sim_sleep_us( uint64_t us )
+{
+    uint64_t        host_ns = (uint64_t)( (double)us * 1000.0 / sim_config.time_scale );
+    uint64_t        until;
+    struct timespec ts;
+
+    if ( host_ns == 0 )
+    {
+        return;
+    }
+    if ( host_ns < SIM_SPIN_THRESHOLD_NS )
+    {
+        until = sim_host_ns() + host_ns;
+        while ( sim_host_ns() < until )
+        {
+            sched_yield();
+        }
+        return;
+    }
+    ts.tv_sec  = host_ns / 1000000000ull;
+    ts.tv_nsec = host_ns % 1000000000ull;
+    while ( nanosleep( &ts, &ts ) != 0 )
+    {
+    }
+}
+
+/*******************************************************************************
+ Function name: sim_deadline_to_timespec
+
+ Function Description:
+ @brief    Converts a simulated deadline to an absolute CLOCK_MONOTONIC time
+           usable with condition variables created by sim_cond_init().
+
+ @param    deadline_us  simulated deadline
+ @param    ts           receives the host deadline
+ ******************************************************************************/
+void sim_deadline_to_timespec( uint64_t deadline_us, struct timespec *ts )
+{
+    uint64_t host_ns;
+
+    pthread_once( &sim_epoch_once, sim_epoch_init );
+    host_ns = (uint64_t)( (double)deadline_us * 1000.0 / sim_config.time_scale );
+    host_ns += (uint64_t)sim_epoch.tv_sec * 1000000000ull + (uint64_t)sim_epoch.tv_nsec;
+    ts->tv_sec  = host_ns / 1000000000ull;
+    ts->tv_nsec = host_ns % 1000000000ull;
+}
+
+void sim_cond_init( pthread_cond_t *cond )
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init( &attr );
+    pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+    pthread_cond_init( cond, &attr );
+    pthread_condattr_destroy( &attr );
+}
+
+/*******************************************************************************
+ Function name: sim_device_create
+
+ Function Description:
+ @brief    Creates a device that will run the given application image.
+
+ @param    name       device name used in traces and reports
+ @param    app_start  application_start() of the image
+
+ @return   sim_device_t*  the device, not yet running
+ ******************************************************************************/
+sim_device_t *sim_device_create( const char *name, void (*app_start)( void ) )
+{
+    sim_device_t *dev = calloc( 1, sizeof( *dev ) );
+    uint32_t      pin;
+
+    dev->name      = name;
+    dev->app_start = app_start;
+    pthread_mutex_init( &dev->lock, NULL );
+    sim_cond_init( &dev->wake );
+    for ( pin = 0; pin < WICED_GPIO_MAX_PINS; pin++ )
+    {
+        /* Undriven pins float high through the board pull-ups */
+        dev->pins[pin].level = GPIO_PIN_OUTPUT_HIGH;
+    }
+    return dev;
+}
+
+sim_device_t *sim_device_current( void )
+{
+    return current_device;
+}
+
+void sim_device_bind( sim_device_t *dev )
+{
+    current_device = dev;
+}
+
+/*******************************************************************************
+ Function name: sim_device_post
+
+ Function Description:
+ @brief    Queues a call on the application thread of a device.
+
+ @param    dev    target device
+ @param    fn     function to call
+ @param    arg    first argument
+ @param    param  second argument
+ ******************************************************************************/
+void sim_device_post( sim_device_t *dev, void (*fn)( void *, uint32_t ),
+                      void *arg, uint32_t param )
+{
+    sim_event_t *evt = malloc( sizeof( *evt ) );
+
+    evt->next  = NULL;
+    evt->fn    = fn;
+    evt->arg   = arg;
+    evt->param = param;
+
+    pthread_mutex_lock( &dev->lock );
+    if ( dev->event_tail )
+    {
+        dev->event_tail->next = evt;
+    }
+    else
+    {
+        dev->event_head = evt;
+    }
+    dev->event_tail = evt;
+    pthread_cond_signal( &dev->wake );
+    pthread_mutex_unlock( &dev->lock );
+}
+
+/* Application thread: boot the image, then run deferred calls and timers */
+static void *sim_device_main( void *arg )
+{
+    sim_device_t   *dev = arg;
+    sim_event_t    *evt;
+    uint64_t        next_deadline;
+    struct timespec ts;
+
+    sim_device_bind( dev );
+    dev->app_start();
+
+    pthread_mutex_lock( &dev->lock );
+    while ( 1 )
+    {
+        if ( dev->event_head )
+        {
+            evt = dev->event_head;
+            dev->event_head = evt->next;
+            if ( !dev->event_head )
+            {
+                dev->event_tail = NULL;
+            }
+            pthread_mutex_unlock( &dev->lock );
+            evt->fn( evt->arg, evt->param );
+            free( evt );
+            pthread_mutex_lock( &dev->lock );
+            continue;
+        }
+
+        /* Runs expired timers with the lock dropped around each callback */
+        next_deadline = 0;
+        sim_timer_service( dev, &next_deadline );
+        if ( dev->event_head )
+        {
+            continue;
+        }
+        if ( next_deadline )
+        {
+            sim_deadline_to_timespec( next_deadline, &ts );
+            pthread_cond_timedwait( &dev->wake, &dev->lock, &ts );
+        }
+        else
+        {
+            pthread_cond_wait( &dev->wake, &dev->lock );
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+ Function name: sim_device_start
+
+ Function Description:
+ @brief    Powers on a device: starts its application thread.
+
+ @param    dev  device to start
+ ******************************************************************************/
+void sim_device_start( sim_device_t *dev )
+{
+    pthread_create( &dev->app_thread, NULL, sim_device_main, dev );
+}
+
+/******************************************************************************
+ *                                Trace
+ ******************************************************************************/
+
+static void sim_trace_emit( const char *prefix, const char *text )
+{
+    const char *p = text;
+
+    /* The applications end lines with "\n\r"; only '\n' starts a new line */
+    pthread_mutex_lock( &trace_lock );
+    while ( *p )
+    {
+        const char *eol = strchr( p, '\n' );
+        size_t      len = eol ? (size_t)( eol - p ) : strlen( p );
+        size_t      i;
+
+        if ( ( len == 1 ) && ( p[0] == '\r' ) && !eol )
+        {
+            break;
+        }
+        printf( "%s", prefix );
+        for ( i = 0; i < len; i++ )
+        {
+            if ( p[i] != '\r' )
+            {
+                putchar( p[i] );
+            }
+        }
+        putchar( '\n' );
+        p += len + ( eol ? 1 : 0 );
+        if ( *p == '\r' )
+        {
+            p++;
+        }
+    }
+    fflush( stdout );
+    pthread_mutex_unlock( &trace_lock );
+}
+
+void sim_trace( const char *fmt, ... )
+{
+    char            line[SIM_TRACE_LINE_MAX];
+    char            prefix[64];
+    sim_device_t   *dev = current_device;
+    uint64_t        now;
+    va_list         ap;
+
+    if ( !sim_config.trace )
+    {
+        return;
+    }
+    now = sim_now_us();
+    va_start( ap, fmt );
+    vsnprintf( line, sizeof( line ), fmt, ap );
+    va_end( ap );
+    snprintf( prefix, sizeof( prefix ), "%10.3f ms [%s] ",
+              now / 1000.0, dev ? dev->name : "host" );
+    sim_trace_emit( prefix, line );
+}
+
+void sim_trace_raw( const char *fmt, ... )
+{
+    char    line[SIM_TRACE_LINE_MAX];
+    va_list ap;
+
+    va_start( ap, fmt );
+    vsnprintf( line, sizeof( line ), fmt, ap );
+    va_end( ap );
+    sim_trace_emit( "", line );
+}
+
+void wiced_set_debug_uart( wiced_debug_uart_types_t uart )
+{
+    (void)uart;
+}
+
+/******************************************************************************
+ *                                Bluetooth stack
+ ******************************************************************************/
+
+static void sim_bt_enabled( void *arg, uint32_t param )
+{
+    sim_device_t                   *dev = arg;
+    wiced_bt_management_evt_data_t  data;
+
+    (void)param;
+    memset( &data, 0, sizeof( data ) );
+    data.enabled.status = WICED_BT_SUCCESS;
+    dev->bt_cback( BTM_ENABLED_EVT, &data );
+}
+
+wiced_result_t wiced_bt_stack_init( wiced_bt_management_cback_t *p_bt_management_cback,
+                                    const wiced_bt_cfg_settings_t *p_bt_cfg_settings,
+                                    const wiced_bt_cfg_buf_pool_t *p_bt_cfg_buf_pools )
+{
+    sim_device_t *dev = current_device;
+
+    (void)p_bt_cfg_buf_pools;
+    dev->bt_cback = p_bt_management_cback;
+    dev->bt_cfg   = p_bt_cfg_settings;
+    sim_device_post( dev, sim_bt_enabled, dev, 0 );
+    return WICED_BT_SUCCESS;
+}
@@ -0,0 +1,310 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file sim_gpio.c
+ *
+ * @brief
+ * GPIO banks of the simulated devices and the wires between them.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include "sim.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+#define SIM_MAX_WIRES                         (32)
+#define SIM_INT_EDGE                          (0x0100)
+#define SIM_INT_FALLING                       (0x0010)
+#define SIM_INT_BOTH                          (0x0020)
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+typedef struct
+{
+    sim_device_t   *src;
+    uint32_t        src_pin;
+    sim_device_t   *dst;
+    uint32_t        dst_pin;
+} sim_wire_t;
+
+/******************************************************************************
+ *                                Variables Definitions
+ ******************************************************************************/
+static sim_wire_t       wires[SIM_MAX_WIRES];
+static uint32_t         wire_count;
+static pthread_mutex_t  gpio_lock;
+static pthread_once_t   gpio_once = PTHREAD_ONCE_INIT;
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+static void sim_gpio_lock_init( void )
+{
+    pthread_mutexattr_t attr;
+
+    /* Driving a wire drives the pins it is connected to */
+    pthread_mutexattr_init( &attr );
+    pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+    pthread_mutex_init( &gpio_lock, &attr );
+    pthread_mutexattr_destroy( &attr );
+}
+
+static void sim_gpio_lock( void )
+{
+    pthread_once( &gpio_once, sim_gpio_lock_init );
+    pthread_mutex_lock( &gpio_lock );
+}
+
+static void sim_gpio_unlock( void )
+{
+    pthread_mutex_unlock( &gpio_lock );
+}
+
+/* Tells whether a wire drives the pin; called with gpio_lock held */
+static wiced_bool_t sim_gpio_is_driven( const sim_device_t *dev, uint32_t pin )
+{
+    uint32_t i;
+
+    for ( i = 0; i < wire_count; i++ )
+    {
+        if ( ( wires[i].dst == dev ) && ( wires[i].dst_pin == pin ) )
+        {
+            return WICED_TRUE;
+        }
+    }
+    return WICED_FALSE;
+}
+
+/* Runs a pin interrupt handler on the application thread of its device */
+static void sim_gpio_dispatch( void *arg, uint32_t pin )
+{
+    sim_device_t                        *dev = arg;
+    wiced_hal_gpio_interrupt_handler_t  *handler;
+    void                                *usrdata;
+
+    sim_gpio_lock();
+    handler = dev->pins[pin].handler;
+    usrdata = dev->pins[pin].usrdata;
+    sim_gpio_unlock();
+    if ( handler )
+    {
+        handler( usrdata, (uint8_t)pin );
+    }
+}
+
+static wiced_bool_t sim_gpio_edge_matches( uint32_t config, uint8_t level )
+{
+    if ( !( config & GPIO_INTERRUPT_ENABLE_MASK ) )
+    {
+        return WICED_FALSE;
+    }
+    if ( config & SIM_INT_EDGE )
+    {
+        if ( config & SIM_INT_BOTH )
+        {
+            return WICED_TRUE;
+        }
+        return ( config & SIM_INT_FALLING ) ? ( level == 0 ) : ( level != 0 );
+    }
+    /* Level interrupts are reported when the level is entered */
+    return ( config & SIM_INT_FALLING ) ? ( level == 0 ) : ( level != 0 );
+}
+
+/*******************************************************************************
+ Function name: sim_gpio_drive
+
+ Function Description:
+ @brief    Sets the level of a pin and propagates it over the attached wires.
+
+ @param    dev    device owning the pin
+ @param    pin    pin number
+ @param    level  new level
+ ******************************************************************************/
+void sim_gpio_drive( sim_device_t *dev, uint32_t pin, uint8_t level )
+{
+    sim_pin_t  *p;
+    uint32_t    i;
+
+    if ( pin >= WICED_GPIO_MAX_PINS )
+    {
+        return;
+    }
+    level = level ? 1 : 0;
+
+    sim_gpio_lock();
+    p = &dev->pins[pin];
+    if ( p->level != level )
+    {
+        p->level = level;
+        if ( dev->spi.initialized && !dev->spi.is_master && ( dev->spi.cs_pin == pin ) )
+        {
+            sim_pspi_cs_changed( dev, level );
+        }
+        if ( p->handler && sim_gpio_edge_matches( p->config, level ) )
+        {
+            p->interrupt_pending = 1;
+            sim_device_post( dev, sim_gpio_dispatch, dev, pin );
+        }
+        for ( i = 0; i < wire_count; i++ )
+        {
+            if ( ( wires[i].src == dev ) && ( wires[i].src_pin == pin ) )
+            {
+                sim_gpio_drive( wires[i].dst, wires[i].dst_pin, level );
+            }
+        }
+    }
+    sim_gpio_unlock();
+}
+
+/*******************************************************************************
+ Function name: sim_gpio_connect
+
+ Function Description:
+ @brief    Wires an output pin of one device to an input pin of another.
+
+ @param    src      driving device
+ @param    src_pin  driving pin
+ @param    dst      receiving device
+ @param    dst_pin  receiving pin
+ ******************************************************************************/
+void sim_gpio_connect( sim_device_t *src, uint32_t src_pin,
+                       sim_device_t *dst, uint32_t dst_pin )
+{
+    sim_gpio_lock();
+    if ( wire_count < SIM_MAX_WIRES )
+    {
+        wires[wire_count].src     = src;
+        wires[wire_count].src_pin = src_pin;
+        wires[wire_count].dst     = dst;
+        wires[wire_count].dst_pin = dst_pin;
+        wire_count++;
+        dst->pins[dst_pin].level = src->pins[src_pin].level;
+    }
+    sim_gpio_unlock();
+}
+
+/******************************************************************************
+ *                                WICED GPIO driver
+ ******************************************************************************/
+
+void wiced_hal_gpio_init( void )
+{
+}
+
+void wiced_hal_gpio_configure_pin( uint32_t pin, uint32_t config, uint32_t outputVal )
+{
+    sim_device_t *dev = sim_device_current();
+
+    if ( pin >= WICED_GPIO_MAX_PINS )
+    {
+        return;
+    }
+    sim_gpio_lock();
+    dev->pins[pin].config = config;
+    /* An input no other device drives settles to its pull */
+    if ( ( config & GPIO_INPUT_ENABLE ) && ( config & ( GPIO_PULL_UP | GPIO_PULL_DOWN ) ) &&
+         !sim_gpio_is_driven( dev, pin ) )
+    {
+        dev->pins[pin].level = ( config & GPIO_PULL_UP ) ? 1 : 0;
+    }
+    sim_gpio_unlock();
+    if ( !( config & GPIO_INPUT_ENABLE ) && !( config & GPIO_OUTPUT_DISABLE ) )
+    {
+        sim_gpio_drive( dev, pin, (uint8_t)outputVal );
+    }
+}
+
+uint32_t wiced_hal_gpio_get_pin_config( uint32_t pin )
+{
+    return ( pin < WICED_GPIO_MAX_PINS ) ? sim_device_current()->pins[pin].config : 0;
+}
+
+void wiced_hal_gpio_set_pin_output( uint32_t pin, uint32_t val )
+{
+    sim_gpio_drive( sim_device_current(), pin, (uint8_t)val );
+}
+
+uint32_t wiced_hal_gpio_get_pin_output( uint32_t pin )
+{
+    return ( pin < WICED_GPIO_MAX_PINS ) ? sim_device_current()->pins[pin].level : 0;
+}
+
+uint32_t wiced_hal_gpio_get_pin_input_status( uint32_t pin )
+{
+    uint32_t level;
+
+    if ( pin >= WICED_GPIO_MAX_PINS )
+    {
+        return 0;
+    }
+    sim_gpio_lock();
+    level = sim_device_current()->pins[pin].level;
+    sim_gpio_unlock();
+    return level;
+}
+
+void wiced_hal_gpio_register_pin_for_interrupt( uint16_t pin,
+                                                wiced_hal_gpio_interrupt_handler_t *userfn,
+                                                void *usrdata )
+{
+    sim_device_t *dev = sim_device_current();
+
+    if ( pin >= WICED_GPIO_MAX_PINS )
+    {
+        return;
+    }
+    sim_gpio_lock();
+    dev->pins[pin].handler = userfn;
+    dev->pins[pin].usrdata = usrdata;
+    sim_gpio_unlock();
+}
+
+uint32_t wiced_hal_gpio_get_pin_interrupt_status( uint32_t pin )
+{
+    return ( pin < WICED_GPIO_MAX_PINS ) ?
+           sim_device_current()->pins[pin].interrupt_pending : 0;
+}
+
+void wiced_hal_gpio_clear_pin_interrupt_status( uint32_t pin )
+{
+    if ( pin < WICED_GPIO_MAX_PINS )
+    {
+        sim_device_current()->pins[pin].interrupt_pending = 0;
+    }
+}
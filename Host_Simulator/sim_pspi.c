@@ -0,0 +1,577 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file sim_pspi.c
+ *
+ * @brief
+ * Virtual pSPI bus between the simulated master and slaves.
+ *
+ * Master transfers take the wire time of the configured clock plus the fixed
+ * bus latency, then move their bytes in one step: MOSI bytes are pushed into
+ * the RX FIFO of the selected slave, MISO bytes are popped from its TX FIFO.
+ * A slave whose TX FIFO runs dry shifts out SIM_MISO_IDLE, a full or disabled
+ * RX FIFO drops the incoming byte. An unplugged slave neither receives nor
+ * drives anything. Faults injected with sim_pspi_inject_fault hit the next
+ * byte the slave exchanges.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include <string.h>
+
+#include "sim.h"
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+/* Bus view of one attached slave */
+typedef struct
+{
+    sim_device_t   *dev;
+    wiced_bool_t    selected;
+    sim_window_t    window;
+    /* One bit late after a SIM_FAULT_CLOCK_SLIP until the window closes,
+       the bit carried over comes from the previous byte on each line */
+    wiced_bool_t    slipped;
+    uint8_t         last_mosi;
+    uint8_t         last_miso;
+} sim_bus_slave_t;
+
+/******************************************************************************
+ *                                Variables Definitions
+ ******************************************************************************/
+static pthread_mutex_t      bus_lock = PTHREAD_MUTEX_INITIALIZER;
+static sim_bus_slave_t      bus_slaves[SIM_MAX_DEVICES];
+static uint32_t             bus_slave_count;
+static sim_window_hook_t   *window_hook;
+/* State of the bit error generator, fixed so that runs are repeatable */
+static uint32_t             noise_state = 0x2545F491u;
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+static uint32_t sim_fifo_depth( void )
+{
+    if ( sim_config.fifo_depth == 0 || sim_config.fifo_depth > SIM_FIFO_MAX_DEPTH )
+    {
+        return SIM_FIFO_MAX_DEPTH;
+    }
+    return sim_config.fifo_depth;
+}
+
+static wiced_bool_t sim_fifo_push( sim_fifo_t *fifo, uint8_t byte )
+{
+    if ( fifo->count >= sim_fifo_depth() )
+    {
+        return WICED_FALSE;
+    }
+    fifo->data[( fifo->head + fifo->count ) % SIM_FIFO_MAX_DEPTH] = byte;
+    fifo->count++;
+    return WICED_TRUE;
+}
+
+static uint8_t sim_fifo_pop( sim_fifo_t *fifo )
+{
+    uint8_t byte = fifo->data[fifo->head];
+
+    fifo->head = ( fifo->head + 1 ) % SIM_FIFO_MAX_DEPTH;
+    fifo->count--;
+    return byte;
+}
+
+static void sim_fifo_flush( sim_fifo_t *fifo )
+{
+    fifo->head  = 0;
+    fifo->count = 0;
+}
+
+static uint8_t sim_bit_reverse( uint8_t b )
+{
+    b = (uint8_t)( ( b & 0xF0 ) >> 4 | ( b & 0x0F ) << 4 );
+    b = (uint8_t)( ( b & 0xCC ) >> 2 | ( b & 0x33 ) << 2 );
+    b = (uint8_t)( ( b & 0xAA ) >> 1 | ( b & 0x55 ) << 1 );
+    return b;
+}
+
+/* Probability of a bit error per byte at the given clock */
+static double sim_error_rate( uint32_t clock )
+{
+    double rate = sim_config.bit_error_rate;
+
+    if ( sim_config.link_max_hz && ( clock > sim_config.link_max_hz ) )
+    {
+        rate += SIM_OVERCLOCK_ERROR_RATE * 10.0 *
+                ( (double)clock / sim_config.link_max_hz - 1.0 );
+    }
+    return MIN( rate, 1.0 );
+}
+
+/* Flips one random bit of a byte with the given probability; called with
+   bus_lock held */
+static uint8_t sim_bit_error( sim_device_t *master, uint8_t b, double rate )
+{
+    if ( rate <= 0.0 )
+    {
+        return b;
+    }
+    noise_state ^= noise_state << 13;
+    noise_state ^= noise_state >> 17;
+    noise_state ^= noise_state << 5;
+    if ( ( noise_state >> 8 ) >= rate * ( 1u << 24 ) )
+    {
+        return b;
+    }
+    master->spi.bit_errors++;
+    return (uint8_t)( b ^ ( 1u << ( noise_state & 7 ) ) );
+}
+
+static sim_bus_slave_t *sim_bus_find( const sim_device_t *dev )
+{
+    uint32_t i;
+
+    for ( i = 0; i < bus_slave_count; i++ )
+    {
+        if ( bus_slaves[i].dev == dev )
+        {
+            return &bus_slaves[i];
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+ Function name: sim_pspi_attach_slave
+
+ Function Description:
+ @brief    Puts a device on the bus as a slave selected by one of its pins.
+
+ @param    slave   slave device
+ @param    cs_pin  pin of the slave device used as active low chip select
+ ******************************************************************************/
+void sim_pspi_attach_slave( sim_device_t *slave, uint32_t cs_pin )
+{
+    pthread_mutex_lock( &bus_lock );
+    if ( bus_slave_count < SIM_MAX_DEVICES )
+    {
+        memset( &bus_slaves[bus_slave_count], 0, sizeof( bus_slaves[0] ) );
+        bus_slaves[bus_slave_count].dev = slave;
+        bus_slave_count++;
+        slave->spi.cs_pin = cs_pin;
+    }
+    pthread_mutex_unlock( &bus_lock );
+}
+
+void sim_pspi_set_window_hook( sim_window_hook_t *hook )
+{
+    window_hook = hook;
+}
+
+/*******************************************************************************
+ Function name: sim_pspi_inject_fault
+
+ Function Description:
+ @brief    Arms a fault that hits the next byte a slave exchanges; a fault
+           still armed is replaced.
+
+ @param    slave  slave device
+ @param    fault  fault to inject
+ ******************************************************************************/
+void sim_pspi_inject_fault( sim_device_t *slave, sim_fault_t fault )
+{
+    pthread_mutex_lock( &bus_lock );
+    slave->spi.fault = fault;
+    pthread_mutex_unlock( &bus_lock );
+}
+
+/* Applies the armed fault of a slave to the byte being exchanged and returns
+   it; called with bus_lock held */
+static sim_fault_t sim_fault_hit( sim_bus_slave_t *entry, uint64_t now_us )
+{
+    sim_pspi_t  *spi   = &entry->dev->spi;
+    sim_fault_t  fault = spi->fault;
+
+    if ( fault == SIM_FAULT_NONE )
+    {
+        return fault;
+    }
+    spi->fault = SIM_FAULT_NONE;
+    spi->faults++;
+    if ( !entry->window.fault_us )
+    {
+        entry->window.fault_us = now_us;
+    }
+    if ( fault == SIM_FAULT_STUCK_FIFO )
+    {
+        spi->fifo_stuck = WICED_TRUE;
+    }
+    else if ( fault == SIM_FAULT_CLOCK_SLIP )
+    {
+        entry->slipped = WICED_TRUE;
+    }
+    return fault;
+}
+
+/*******************************************************************************
+ Function name: sim_pspi_cs_changed
+
+ Function Description:
+ @brief    Chip select edge seen by a slave; opens or closes a bus window.
+
+ @param    slave  slave device
+ @param    level  new chip select level
+ ******************************************************************************/
+void sim_pspi_cs_changed( sim_device_t *slave, uint8_t level )
+{
+    sim_bus_slave_t *entry;
+    sim_window_t     done;
+    wiced_bool_t     report = WICED_FALSE;
+
+    pthread_mutex_lock( &bus_lock );
+    entry = sim_bus_find( slave );
+    if ( entry )
+    {
+        if ( ( level == 0 ) && !entry->selected )
+        {
+            entry->selected = WICED_TRUE;
+            entry->slipped  = WICED_FALSE;
+            memset( &entry->window, 0, sizeof( entry->window ) );
+            entry->window.slave    = slave;
+            entry->window.start_us = sim_now_us();
+        }
+        else if ( ( level != 0 ) && entry->selected )
+        {
+            entry->selected        = WICED_FALSE;
+            entry->window.end_us   = sim_now_us();
+            done                   = entry->window;
+            report                 = WICED_TRUE;
+        }
+    }
+    pthread_mutex_unlock( &bus_lock );
+
+    if ( report && window_hook )
+    {
+        window_hook( &done );
+    }
+}
+
+/* Clocks len bytes between the master and the selected slaves */
+static void sim_pspi_transfer( sim_device_t *master, uint32_t len,
+                               const uint8_t *tx, uint8_t *rx )
+{
+    uint32_t         clock = sim_config.clock_hz ? sim_config.clock_hz : master->spi.clock_hz;
+    double           error_rate = sim_error_rate( clock );
+    uint64_t         wire_us;
+    uint64_t         now_us;
+    uint32_t         i;
+    uint32_t         s;
+
+    if ( !master->spi.initialized || !master->spi.is_master || !clock )
+    {
+        if ( rx )
+        {
+            memset( rx, SIM_MISO_IDLE, len );
+        }
+        return;
+    }
+    wire_us = ( (uint64_t)len * 8ull * 1000000ull + clock - 1 ) / clock + sim_config.latency_us;
+    sim_sleep_us( wire_us );
+
+    pthread_mutex_lock( &bus_lock );
+    now_us = sim_now_us();
+    for ( i = 0; i < len; i++ )
+    {
+        uint8_t mosi = sim_bit_error( master, tx ? tx[i] : SIM_MOSI_DUMMY, error_rate );
+        uint8_t miso = SIM_MISO_IDLE;
+
+        for ( s = 0; s < bus_slave_count; s++ )
+        {
+            sim_bus_slave_t *entry = &bus_slaves[s];
+            sim_pspi_t      *spi   = &entry->dev->spi;
+            uint8_t          in    = mosi;
+            uint8_t          out   = SIM_MISO_IDLE;
+            wiced_bool_t     flip  = ( spi->endian != master->spi.endian );
+            sim_fault_t      fault;
+
+            if ( !entry->selected || !spi->initialized || spi->is_master ||
+                 ( ( now_us >= spi->unplug_start_us ) && ( now_us < spi->unplug_end_us ) ) )
+            {
+                continue;
+            }
+            fault = sim_fault_hit( entry, now_us );
+            if ( entry->slipped )
+            {
+                /* The slave samples each bit one clock late */
+                in               = (uint8_t)( entry->last_mosi << 7 | mosi >> 1 );
+                entry->last_mosi = mosi;
+            }
+            else if ( fault == SIM_FAULT_BIT_FLIP )
+            {
+                in ^= 0x10;
+            }
+            if ( flip )
+            {
+                in = sim_bit_reverse( in );
+            }
+            if ( !spi->rx_enabled || spi->fifo_stuck || ( fault == SIM_FAULT_DROP ) )
+            {
+                spi->rx_discarded++;
+            }
+            else if ( !sim_fifo_push( &spi->rx_fifo, in ) )
+            {
+                spi->rx_overflows++;
+            }
+            if ( spi->fifo_stuck )
+            {
+                /* The idle level goes out, the TX FIFO keeps its bytes */
+                out = SIM_MISO_IDLE;
+            }
+            else if ( spi->tx_enabled && spi->tx_fifo.count )
+            {
+                out = sim_fifo_pop( &spi->tx_fifo );
+            }
+            else
+            {
+                spi->tx_underruns++;
+            }
+            if ( flip )
+            {
+                out = sim_bit_reverse( out );
+            }
+            if ( entry->slipped )
+            {
+                uint8_t late = (uint8_t)( entry->last_miso << 7 | out >> 1 );
+
+                entry->last_miso = out;
+                out              = late;
+            }
+            else
+            {
+                entry->last_mosi = mosi;
+                entry->last_miso = out;
+            }
+            out = sim_bit_error( master, out, error_rate );
+            /* Several selected slaves fight over MISO; low wins */
+            miso &= out;
+
+            if ( entry->window.mosi_count < SIM_WINDOW_CAPTURE )
+            {
+                entry->window.mosi[entry->window.mosi_count] = mosi;
+            }
+            if ( entry->window.miso_count < SIM_WINDOW_CAPTURE )
+            {
+                entry->window.miso[entry->window.miso_count] = out;
+            }
+            entry->window.mosi_count++;
+            entry->window.miso_count++;
+        }
+        if ( rx )
+        {
+            rx[i] = miso;
+        }
+    }
+    master->spi.bytes += len;
+    pthread_mutex_unlock( &bus_lock );
+}
+
+/******************************************************************************
+ *                                WICED pSPI driver
+ ******************************************************************************/
+
+void wiced_hal_pspi_init( spi_interface_t spi, uint32_t clkSpeed,
+                          SPI_ENDIAN endian, SPI_SS_POLARITY polarity,
+                          SPI_MODE mode )
+{
+    sim_device_t *dev = sim_device_current();
+
+    (void)spi;
+    (void)polarity;
+    pthread_mutex_lock( &bus_lock );
+    if ( dev->spi.initialized && clkSpeed && ( clkSpeed != dev->spi.clock_hz ) )
+    {
+        dev->spi.clock_changes++;
+    }
+    dev->spi.initialized = WICED_TRUE;
+    dev->spi.is_master   = ( clkSpeed != 0 ) ? WICED_TRUE : WICED_FALSE;
+    dev->spi.clock_hz    = clkSpeed;
+    dev->spi.endian      = endian;
+    dev->spi.mode        = mode;
+    dev->spi.rx_enabled  = WICED_FALSE;
+    dev->spi.tx_enabled  = WICED_FALSE;
+    dev->spi.fifo_stuck  = WICED_FALSE;
+    sim_fifo_flush( &dev->spi.rx_fifo );
+    sim_fifo_flush( &dev->spi.tx_fifo );
+    pthread_mutex_unlock( &bus_lock );
+}
+
+void wiced_hal_pspi_reset( spi_interface_t spi )
+{
+    sim_device_t *dev = sim_device_current();
+
+    (void)spi;
+    pthread_mutex_lock( &bus_lock );
+    dev->spi.resets++;
+    if ( !dev->spi.is_master )
+    {
+        dev->spi.rx_enabled = WICED_FALSE;
+        dev->spi.tx_enabled = WICED_FALSE;
+        dev->spi.fifo_stuck = WICED_FALSE;
+        sim_fifo_flush( &dev->spi.rx_fifo );
+        sim_fifo_flush( &dev->spi.tx_fifo );
+    }
+    pthread_mutex_unlock( &bus_lock );
+}
+
+void wiced_hal_pspi_tx_data( spi_interface_t spi, uint32_t txLen, const uint8_t *txBuf )
+{
+    (void)spi;
+    sim_pspi_transfer( sim_device_current(), txLen, txBuf, NULL );
+}
+
+void wiced_hal_pspi_rx_data( spi_interface_t spi, uint32_t rxLen, uint8_t *rxBuf )
+{
+    (void)spi;
+    sim_pspi_transfer( sim_device_current(), rxLen, NULL, rxBuf );
+}
+
+void wiced_hal_pspi_exchange_data( spi_interface_t spi, uint32_t len,
+                                   const uint8_t *txBuf, uint8_t *rxBuf )
+{
+    (void)spi;
+    sim_pspi_transfer( sim_device_current(), len, txBuf, rxBuf );
+}
+
+SPIFFY_STATUS wiced_hal_pspi_slave_tx_data( spi_interface_t spi, uint32_t txLen,
+                                            const uint8_t *txBuf )
+{
+    sim_device_t   *dev = sim_device_current();
+    SPIFFY_STATUS   status = SPIFFY_SUCCESS;
+    uint32_t        i;
+
+    (void)spi;
+    pthread_mutex_lock( &bus_lock );
+    if ( dev->spi.tx_fifo.count + txLen > sim_fifo_depth() )
+    {
+        status = SPIFFY_ERROR;
+    }
+    else
+    {
+        for ( i = 0; i < txLen; i++ )
+        {
+            sim_fifo_push( &dev->spi.tx_fifo, txBuf[i] );
+        }
+    }
+    pthread_mutex_unlock( &bus_lock );
+    return status;
+}
+
+SPIFFY_STATUS wiced_hal_pspi_slave_rx_data( spi_interface_t spi, uint32_t rxLen,
+                                            uint8_t *rxBuf )
+{
+    sim_device_t   *dev = sim_device_current();
+    SPIFFY_STATUS   status = SPIFFY_SUCCESS;
+    uint32_t        i;
+
+    (void)spi;
+    pthread_mutex_lock( &bus_lock );
+    if ( dev->spi.rx_fifo.count < rxLen )
+    {
+        status = SPIFFY_ERROR;
+    }
+    else
+    {
+        for ( i = 0; i < rxLen; i++ )
+        {
+            rxBuf[i] = sim_fifo_pop( &dev->spi.rx_fifo );
+        }
+    }
+    pthread_mutex_unlock( &bus_lock );
+    return status;
+}
+
+void wiced_hal_pspi_slave_enable_rx( spi_interface_t spi )
+{
+    (void)spi;
+    pthread_mutex_lock( &bus_lock );
+    sim_device_current()->spi.rx_enabled = WICED_TRUE;
+    pthread_mutex_unlock( &bus_lock );
+}
+
+void wiced_hal_pspi_slave_disable_rx( spi_interface_t spi )
+{
+    (void)spi;
+    pthread_mutex_lock( &bus_lock );
+    sim_device_current()->spi.rx_enabled = WICED_FALSE;
+    pthread_mutex_unlock( &bus_lock );
+}
+
+void wiced_hal_pspi_slave_enable_tx( spi_interface_t spi )
+{
+    (void)spi;
+    pthread_mutex_lock( &bus_lock );
+    sim_device_current()->spi.tx_enabled = WICED_TRUE;
+    pthread_mutex_unlock( &bus_lock );
+}
+
+void wiced_hal_pspi_slave_disable_tx( spi_interface_t spi )
+{
+    (void)spi;
+    pthread_mutex_lock( &bus_lock );
+    sim_device_current()->spi.tx_enabled = WICED_FALSE;
+    pthread_mutex_unlock( &bus_lock );
+}
+
+uint32_t wiced_hal_pspi_slave_get_rx_fifo_count( spi_interface_t spi )
+{
+    uint32_t count;
+
+    (void)spi;
+    pthread_mutex_lock( &bus_lock );
+    count = sim_device_current()->spi.rx_fifo.count;
+    pthread_mutex_unlock( &bus_lock );
+    return count;
+}
+
+uint32_t wiced_hal_pspi_slave_get_tx_fifo_count( spi_interface_t spi )
+{
+    uint32_t count;
+
+    (void)spi;
+    pthread_mutex_lock( &bus_lock );
+    count = sim_device_current()->spi.tx_fifo.count;
+    pthread_mutex_unlock( &bus_lock );
+    return count;
+}
@@ -0,0 +1,377 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file sim_rtos.c
+ *
+ * @brief
+ * WICED RTOS threads, delays, queues, mutexes and semaphores on POSIX.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "wiced_rtos.h"
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+struct sim_thread
+{
+    pthread_t               handle;
+    sim_device_t           *device;
+    wiced_thread_function_t function;
+    void                   *arg;
+    const char             *name;
+    uint32_t                stack_size;
+};
+
+struct sim_queue
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    uint8_t        *buffer;
+    uint32_t        message_size;
+    uint32_t        capacity;
+    uint32_t        head;
+    uint32_t        count;
+};
+
+struct sim_mutex
+{
+    pthread_mutex_t lock;
+};
+
+struct sim_semaphore
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    uint32_t        count;
+};
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/* Waits on cond until predicate holds or the simulated timeout expires */
+/* Counts one blocking of the calling RTOS thread */
+static void sim_count_sleep( void )
+{
+    sim_device_t *dev = sim_device_current();
+
+    if ( dev )
+    {
+        __sync_fetch_and_add( &dev->sleeps, 1 );
+    }
+}
+
+static wiced_result_t sim_wait( pthread_cond_t *cond, pthread_mutex_t *lock,
+                                int (*ready)( void * ), void *ctx, uint32_t timeout_ms )
+{
+    struct timespec ts;
+    uint64_t        deadline;
+
+    if ( ready( ctx ) )
+    {
+        return WICED_SUCCESS;
+    }
+    if ( timeout_ms == WICED_NO_WAIT )
+    {
+        return WICED_TIMEOUT;
+    }
+    sim_count_sleep();
+    if ( timeout_ms == WICED_WAIT_FOREVER )
+    {
+        while ( !ready( ctx ) )
+        {
+            pthread_cond_wait( cond, lock );
+        }
+        return WICED_SUCCESS;
+    }
+    deadline = sim_now_us() + (uint64_t)timeout_ms * 1000ull;
+    sim_deadline_to_timespec( deadline, &ts );
+    while ( !ready( ctx ) )
+    {
+        if ( pthread_cond_timedwait( cond, lock, &ts ) == ETIMEDOUT )
+        {
+            return ready( ctx ) ? WICED_SUCCESS : WICED_TIMEOUT;
+        }
+    }
+    return WICED_SUCCESS;
+}
+
+/******************************************************************************
+ *                                Threads
+ ******************************************************************************/
+
+static void *sim_thread_main( void *arg )
+{
+    wiced_thread_t *thread = arg;
+
+    sim_device_bind( thread->device );
+    thread->function( (uint32_t)(uintptr_t)thread->arg );
+    return NULL;
+}
+
+wiced_thread_t *wiced_rtos_create_thread( void )
+{
+    return calloc( 1, sizeof( wiced_thread_t ) );
+}
+
+wiced_result_t wiced_rtos_init_thread( wiced_thread_t *thread, uint8_t priority,
+                                       const char *name,
+                                       wiced_thread_function_t function,
+                                       uint32_t stack_size, void *arg )
+{
+    pthread_attr_t attr;
+    int            err;
+
+    (void)priority;
+    if ( !thread || !function )
+    {
+        return WICED_BADARG;
+    }
+    thread->device     = sim_device_current();
+    thread->function   = function;
+    thread->arg        = arg;
+    thread->name       = name;
+    thread->stack_size = stack_size;
+
+    /* Host threads get a host sized stack; the firmware stack size is kept
+       for reporting only */
+    pthread_attr_init( &attr );
+    pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+    err = pthread_create( &thread->handle, &attr, sim_thread_main, thread );
+    pthread_attr_destroy( &attr );
+    return err ? WICED_THREAD_ERROR : WICED_SUCCESS;
+}
+
+wiced_result_t wiced_rtos_delay_milliseconds( uint32_t milliseconds,
+                                              wiced_delay_type_t delay_type )
+{
+    (void)delay_type;
+    sim_count_sleep();
+    sim_sleep_us( (uint64_t)milliseconds * 1000ull );
+    return WICED_SUCCESS;
+}
+
+/* The device busy waits for microsecond delays, so they cost no wakeup */
+wiced_result_t wiced_rtos_delay_microseconds( uint32_t microseconds )
+{
+    sim_sleep_us( microseconds );
+    return WICED_SUCCESS;
+}
+
+/******************************************************************************
+ *                                Queues
+ ******************************************************************************/
+
+wiced_queue_t *wiced_rtos_create_queue( void )
+{
+    return calloc( 1, sizeof( wiced_queue_t ) );
+}
+
+wiced_result_t wiced_rtos_init_queue( wiced_queue_t *queue, const char *name,
+                                      uint32_t message_size,
+                                      uint32_t number_of_messages )
+{
+    (void)name;
+    if ( !queue || !message_size || !number_of_messages )
+    {
+        return WICED_BADARG;
+    }
+    pthread_mutex_init( &queue->lock, NULL );
+    sim_cond_init( &queue->changed );
+    queue->buffer       = calloc( number_of_messages, message_size );
+    queue->message_size = message_size;
+    queue->capacity     = number_of_messages;
+    queue->head         = 0;
+    queue->count        = 0;
+    return WICED_SUCCESS;
+}
+
+static int sim_queue_has_space( void *ctx )
+{
+    wiced_queue_t *queue = ctx;
+
+    return queue->count < queue->capacity;
+}
+
+static int sim_queue_has_message( void *ctx )
+{
+    wiced_queue_t *queue = ctx;
+
+    return queue->count > 0;
+}
+
+wiced_result_t wiced_rtos_push_to_queue( wiced_queue_t *queue, void *message,
+                                         uint32_t timeout_ms )
+{
+    wiced_result_t result;
+    uint32_t       slot;
+
+    pthread_mutex_lock( &queue->lock );
+    result = sim_wait( &queue->changed, &queue->lock, sim_queue_has_space,
+                       queue, timeout_ms );
+    if ( result == WICED_SUCCESS )
+    {
+        slot = ( queue->head + queue->count ) % queue->capacity;
+        memcpy( queue->buffer + slot * queue->message_size, message,
+                queue->message_size );
+        queue->count++;
+        pthread_cond_broadcast( &queue->changed );
+    }
+    else
+    {
+        result = WICED_QUEUE_FULL;
+    }
+    pthread_mutex_unlock( &queue->lock );
+    return result;
+}
+
+wiced_result_t wiced_rtos_pop_from_queue( wiced_queue_t *queue, void *message,
+                                          uint32_t timeout_ms )
+{
+    wiced_result_t result;
+
+    pthread_mutex_lock( &queue->lock );
+    result = sim_wait( &queue->changed, &queue->lock, sim_queue_has_message,
+                       queue, timeout_ms );
+    if ( result == WICED_SUCCESS )
+    {
+        memcpy( message, queue->buffer + queue->head * queue->message_size,
+                queue->message_size );
+        queue->head = ( queue->head + 1 ) % queue->capacity;
+        queue->count--;
+        pthread_cond_broadcast( &queue->changed );
+    }
+    else
+    {
+        result = WICED_QUEUE_EMPTY;
+    }
+    pthread_mutex_unlock( &queue->lock );
+    return result;
+}
+
+wiced_result_t wiced_rtos_get_queue_occupancy( wiced_queue_t *queue, uint32_t *count )
+{
+    pthread_mutex_lock( &queue->lock );
+    *count = queue->count;
+    pthread_mutex_unlock( &queue->lock );
+    return WICED_SUCCESS;
+}
+
+/******************************************************************************
+ *                                Mutexes
+ ******************************************************************************/
+
+wiced_mutex_t *wiced_rtos_create_mutex( void )
+{
+    return calloc( 1, sizeof( wiced_mutex_t ) );
+}
+
+wiced_result_t wiced_rtos_init_mutex( wiced_mutex_t *mutex )
+{
+    pthread_mutexattr_t attr;
+
+    /* WICED mutexes may be taken recursively by their owner */
+    pthread_mutexattr_init( &attr );
+    pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+    pthread_mutex_init( &mutex->lock, &attr );
+    pthread_mutexattr_destroy( &attr );
+    return WICED_SUCCESS;
+}
+
+wiced_result_t wiced_rtos_lock_mutex( wiced_mutex_t *mutex )
+{
+    return pthread_mutex_lock( &mutex->lock ) ? WICED_MUTEX_ERROR : WICED_SUCCESS;
+}
+
+wiced_result_t wiced_rtos_unlock_mutex( wiced_mutex_t *mutex )
+{
+    return pthread_mutex_unlock( &mutex->lock ) ? WICED_NOT_OWNED : WICED_SUCCESS;
+}
+
+/******************************************************************************
+ *                                Semaphores
+ ******************************************************************************/
+
+wiced_semaphore_t *wiced_rtos_create_semaphore( void )
+{
+    return calloc( 1, sizeof( wiced_semaphore_t ) );
+}
+
+wiced_result_t wiced_rtos_init_semaphore( wiced_semaphore_t *semaphore )
+{
+    pthread_mutex_init( &semaphore->lock, NULL );
+    sim_cond_init( &semaphore->changed );
+    semaphore->count = 0;
+    return WICED_SUCCESS;
+}
+
+wiced_result_t wiced_rtos_set_semaphore( wiced_semaphore_t *semaphore )
+{
+    pthread_mutex_lock( &semaphore->lock );
+    semaphore->count++;
+    pthread_cond_signal( &semaphore->changed );
+    pthread_mutex_unlock( &semaphore->lock );
+    return WICED_SUCCESS;
+}
+
+static int sim_semaphore_available( void *ctx )
+{
+    wiced_semaphore_t *semaphore = ctx;
+
+    return semaphore->count > 0;
+}
+
+wiced_result_t wiced_rtos_get_semaphore( wiced_semaphore_t *semaphore,
+                                         uint32_t timeout_ms )
+{
+    wiced_result_t result;
+
+    pthread_mutex_lock( &semaphore->lock );
+    result = sim_wait( &semaphore->changed, &semaphore->lock,
+                       sim_semaphore_available, semaphore, timeout_ms );
+    if ( result == WICED_SUCCESS )
+    {
+        semaphore->count--;
+    }
+    pthread_mutex_unlock( &semaphore->lock );
+    return result;
+}
@@ -0,0 +1,148 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file sim_thermistor.c
+ *
+ * @brief
+ * Analog front end of the simulated slave: ambient temperature model, the
+ * NCU15WF104 thermistor divider and the ADC.
+ *
+ * The ambient temperature follows a slow sine around sim_config values so
+ * that consecutive readings differ. The thermistor sits between the ADC input
+ * and ground with a reference resistor to VDDIO. VDDIO and the core supply
+ * read as fixed voltages; the other ADC inputs read 0 V.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include <math.h>
+#include <stdlib.h>
+
+#include "sim.h"
+#include "wiced_hal_adc.h"
+#include "wiced_thermistor.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+#define SIM_VDDIO_MV                          (3300.0)
+#define SIM_VDD_CORE_MV                       (1200.0)
+#define SIM_THERMISTOR_R25                    (100000.0)
+#define SIM_THERMISTOR_BETA                   (4250.0)
+#define SIM_THERMISTOR_RREF                   (100000.0)
+#define SIM_KELVIN_OFFSET                     (273.15)
+#define SIM_PI                                (3.14159265358979323846)
+/* Peak conversion noise of the thermistor library, in 1/100 C */
+#define SIM_THERMISTOR_NOISE                  (3)
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ Function name: sim_ambient_temperature
+
+ Function Description:
+ @brief    Ambient temperature of the simulated board at a point in time.
+
+ @param    now_us  simulated time
+
+ @return   double  temperature in degree Celsius
+ ******************************************************************************/
+double sim_ambient_temperature( uint64_t now_us )
+{
+    double t = (double)now_us / 1000000.0;
+
+    return sim_config.temp_base_c
+           + sim_config.temp_swing_c * sin( 2.0 * SIM_PI * t / sim_config.temp_period_s );
+}
+
+static double sim_thermistor_resistance( double celsius )
+{
+    double kelvin = celsius + SIM_KELVIN_OFFSET;
+
+    return SIM_THERMISTOR_R25 *
+           exp( SIM_THERMISTOR_BETA * ( 1.0 / kelvin - 1.0 / ( 25.0 + SIM_KELVIN_OFFSET ) ) );
+}
+
+void thermistor_init( void )
+{
+}
+
+int16_t thermistor_read( thermistor_cfg_t *p_thermistor_cfg )
+{
+    static __thread unsigned int seed = 1;
+    double                       celsius;
+
+    (void)p_thermistor_cfg;
+    /* The library averages several conversions per reading */
+    sim_sleep_us( sim_config.adc_conversion_us );
+    celsius = sim_ambient_temperature( sim_now_us() );
+    return (int16_t)lround( celsius * 100.0 )
+           + (int16_t)( rand_r( &seed ) % ( 2 * SIM_THERMISTOR_NOISE + 1 ) )
+           - SIM_THERMISTOR_NOISE;
+}
+
+void wiced_hal_adc_init( void )
+{
+}
+
+uint32_t wiced_hal_adc_read_voltage( ADC_INPUT_CHANNEL_SEL channel )
+{
+    double rt;
+
+    switch ( channel )
+    {
+    case ADC_INPUT_VDDIO:
+        return (uint32_t)SIM_VDDIO_MV;
+
+    case ADC_INPUT_VDD_CORE:
+        return (uint32_t)SIM_VDD_CORE_MV;
+
+    case ADC_INPUT_P10:
+        rt = sim_thermistor_resistance( sim_ambient_temperature( sim_now_us() ) );
+        return (uint32_t)lround( SIM_VDDIO_MV * rt / ( rt + SIM_THERMISTOR_RREF ) );
+
+    default:
+        return 0;
+    }
+}
+
+uint16_t wiced_hal_adc_read_raw_sample( ADC_INPUT_CHANNEL_SEL channel, uint32_t reserved )
+{
+    (void)reserved;
+    /* 15 bit converter over the 0..3.6 V input range */
+    return (uint16_t)( wiced_hal_adc_read_voltage( channel ) * 32767u / 3600u );
+}
@@ -0,0 +1,218 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file sim_timer.c
+ *
+ * @brief
+ * WICED application timers of the simulated devices.
+ *
+ * Timers belong to the device that initialised them and expire on that
+ * device's application thread, see sim_device_main().
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include <string.h>
+
+#include "sim.h"
+#include "wiced_timer.h"
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+wiced_result_t wiced_init_timer( wiced_timer_t *p_timer, wiced_timer_callback_fp TimerCb,
+                                 TIMER_PARAM_TYPE cBackparam, wiced_timer_type_t type )
+{
+    sim_device_t *dev = sim_device_current();
+
+    if ( !p_timer || !TimerCb || !dev )
+    {
+        return WICED_BADARG;
+    }
+    memset( p_timer, 0, sizeof( *p_timer ) );
+    p_timer->owner       = dev;
+    p_timer->cback       = TimerCb;
+    p_timer->cback_param = cBackparam;
+    p_timer->type        = type;
+
+    pthread_mutex_lock( &dev->lock );
+    p_timer->next = dev->timers;
+    dev->timers   = p_timer;
+    pthread_mutex_unlock( &dev->lock );
+    return WICED_SUCCESS;
+}
+
+wiced_result_t wiced_start_timer( wiced_timer_t *p_timer, uint32_t timeout )
+{
+    sim_device_t *dev = p_timer->owner;
+    uint64_t      period_us;
+
+    if ( !dev )
+    {
+        return WICED_BADARG;
+    }
+    if ( ( p_timer->type == WICED_SECONDS_TIMER ) ||
+         ( p_timer->type == WICED_SECONDS_PERIODIC_TIMER ) )
+    {
+        period_us = (uint64_t)timeout * 1000000ull;
+    }
+    else
+    {
+        period_us = (uint64_t)timeout * 1000ull;
+    }
+
+    pthread_mutex_lock( &dev->lock );
+    p_timer->period_us   = period_us;
+    p_timer->deadline_us = sim_now_us() + period_us;
+    p_timer->in_use      = WICED_TRUE;
+    pthread_cond_signal( &dev->wake );
+    pthread_mutex_unlock( &dev->lock );
+    return WICED_SUCCESS;
+}
+
+wiced_result_t wiced_stop_timer( wiced_timer_t *p_timer )
+{
+    sim_device_t *dev = p_timer->owner;
+
+    if ( !dev )
+    {
+        return WICED_BADARG;
+    }
+    pthread_mutex_lock( &dev->lock );
+    p_timer->in_use = WICED_FALSE;
+    pthread_mutex_unlock( &dev->lock );
+    return WICED_SUCCESS;
+}
+
+wiced_bool_t wiced_is_timer_in_use( wiced_timer_t *p_timer )
+{
+    return p_timer->in_use;
+}
+
+wiced_result_t wiced_deinit_timer( wiced_timer_t *p_timer )
+{
+    sim_device_t   *dev = p_timer->owner;
+    wiced_timer_t **pp;
+
+    if ( !dev )
+    {
+        return WICED_BADARG;
+    }
+    pthread_mutex_lock( &dev->lock );
+    for ( pp = &dev->timers; *pp; pp = &( *pp )->next )
+    {
+        if ( *pp == p_timer )
+        {
+            *pp = p_timer->next;
+            break;
+        }
+    }
+    p_timer->in_use = WICED_FALSE;
+    p_timer->owner  = NULL;
+    pthread_mutex_unlock( &dev->lock );
+    return WICED_SUCCESS;
+}
+
+/* Clock of the calling device, offset from the simulated time and drifting
+   against it as set up by the harness; timers run on the simulated time */
+uint64_t clock_SystemTimeMicroseconds64( void )
+{
+    const sim_device_t *dev = sim_device_current();
+    uint64_t            now = sim_now_us();
+
+    if ( !dev )
+    {
+        return now;
+    }
+    return (uint64_t)( (int64_t)now + dev->clock_offset_us +
+                       (int64_t)( (double)now * dev->clock_drift_ppm / 1e6 ) );
+}
+
+/*******************************************************************************
+ Function name: sim_timer_service
+
+ Function Description:
+ @brief    Runs the expired timers of a device. Called on the application
+           thread with dev->lock held; the lock is released around callbacks.
+
+ @param    dev            device whose timers are serviced
+ @param    next_deadline  receives the earliest pending deadline, 0 if none
+ ******************************************************************************/
+void sim_timer_service( sim_device_t *dev, uint64_t *next_deadline )
+{
+    wiced_timer_t          *timer;
+    wiced_timer_callback_fp cback;
+    TIMER_PARAM_TYPE        param;
+    uint64_t                now;
+    int                     fired;
+
+    do
+    {
+        fired = 0;
+        now   = sim_now_us();
+        *next_deadline = 0;
+        for ( timer = dev->timers; timer; timer = timer->next )
+        {
+            if ( !timer->in_use )
+            {
+                continue;
+            }
+            if ( timer->deadline_us <= now )
+            {
+                if ( ( timer->type == WICED_SECONDS_PERIODIC_TIMER ) ||
+                     ( timer->type == WICED_MILLI_SECONDS_PERIODIC_TIMER ) )
+                {
+                    timer->deadline_us += timer->period_us ? timer->period_us : 1;
+                }
+                else
+                {
+                    timer->in_use = WICED_FALSE;
+                }
+                cback = timer->cback;
+                param = timer->cback_param;
+                pthread_mutex_unlock( &dev->lock );
+                cback( param );
+                pthread_mutex_lock( &dev->lock );
+                fired = 1;
+                break;
+            }
+            if ( !*next_deadline || ( timer->deadline_us < *next_deadline ) )
+            {
+                *next_deadline = timer->deadline_us;
+            }
+        }
+    } while ( fired && !dev->event_head );
+}
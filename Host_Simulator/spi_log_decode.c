@@ -0,0 +1,142 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file spi_log_decode.c
+ *
+ * @brief
+ * Decoder of the deferred trace log of SPI_Common/spi_log.h.
+ *
+ * Reads simulator output on stdin and writes it to stdout with every flushed
+ * log entry turned back into the trace line it stands for. A decoded line
+ * keeps the device name of the line it came from but carries the time the
+ * event was logged rather than the time it was flushed. Other lines pass
+ * through unchanged, so
+ *
+ *     build/spi_sim -v | build/spi_log_decode
+ *
+ * reads like a run that traced every event as it happened.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "spi_log.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+#define DECODE_LINE_MAX                       (512)
+
+#define SPI_LOG_FORMAT( id, format )          format,
+
+/******************************************************************************
+ *                                Variables Definitions
+ ******************************************************************************/
+static const char * const spi_log_formats[SPI_LOG_EVENT_COUNT] =
+{
+    SPI_LOG_EVENTS( SPI_LOG_FORMAT )
+};
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ Function name: decode_line
+
+ Function Description:
+ @brief    Decodes one line of simulator output if it holds a log entry.
+
+ @param    *line  line without its newline
+
+ @return   int    1 if the line was decoded and printed, 0 otherwise
+ ******************************************************************************/
+static int decode_line( const char *line )
+{
+    const char  *marker = strstr( line, SPI_LOG_MARKER " " );
+    const char  *device;
+    char         text[DECODE_LINE_MAX];
+    unsigned int time_us, event, a, b;
+    size_t       len;
+
+    if ( !marker ||
+         ( sscanf( marker + strlen( SPI_LOG_MARKER ), "%x %x %x %x",
+                   &time_us, &event, &a, &b ) != 4 ) ||
+         ( event >= SPI_LOG_EVENT_COUNT ) )
+    {
+        return 0;
+    }
+
+    /* The format takes int16_t a and int32_t b */
+    snprintf( text, sizeof( text ), spi_log_formats[event],
+              (int)(int16_t)a, (int)b );
+    len = strcspn( text, "\r\n" );
+    text[len] = '\0';
+
+    /* "<time> ms [device] " prefix of the simulator */
+    device = strchr( line, '[' );
+    if ( device && ( device < marker ) )
+    {
+        printf( "%10.3f ms %.*s%s\n", time_us / 1000.0,
+                (int)( marker - device ), device, text );
+    }
+    else
+    {
+        printf( "%10.3f ms %s\n", time_us / 1000.0, text );
+    }
+    return 1;
+}
+
+int main( void )
+{
+    char line[DECODE_LINE_MAX];
+
+    while ( fgets( line, sizeof( line ), stdin ) )
+    {
+        char *eol = strchr( line, '\n' );
+
+        if ( eol )
+        {
+            *eol = '\0';
+        }
+        if ( !decode_line( line ) )
+        {
+            printf( "%s\n", line );
+        }
+    }
+    return 0;
+}
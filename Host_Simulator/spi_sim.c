@@ -0,0 +1,884 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file spi_sim.c
+ *
+ * @brief
+ * Host harness running the SPI master and SPI slave applications together
+ * over the virtual pSPI bus.
+ *
+ * The harness powers on one device per application image, wires the master
+ * chip select to the slave, lets both run for the requested simulated time
+ * and then reports the transactions per second and the per-command latency
+ * observed on the bus. A transaction is one chip select window; its latency
+ * is the time the window was held open by the master. Windows carrying a
+ * frame are reported by the list of commands in the frame.
+ *
+ * With -e the bus damages bytes at random, with -u the first slave is
+ * unplugged for a while. A recovery is then counted from the first window
+ * without a valid response to the end of the next window with a valid
+ * temperature reading, which is the time the master went without sensor data.
+ *
+ * With -x a fault is injected into the traffic of the first slave at a fixed
+ * interval, and the time from the byte it hit to the end of the next window
+ * of that slave with a valid temperature reading is reported for each fault.
+ * This bounds how long the master and slave take to get back in step after
+ * each kind of fault.
+ *
+ * With -g a simulated BLE central connects to the master, enables the
+ * notifications of its temperature service and decodes them; the report
+ * adds the notifications per second, the readings each carries and the age
+ * of the readings when they arrive, which is what the notification interval
+ * trades against radio wakeups.
+ *
+ * With -j the slaves were powered on earlier than the master and their
+ * clocks may drift, so the clock offset the master measures for timed
+ * samples can be checked against the true offset the report gives.
+ *
+ * Usage: spi_sim [options]
+ *   -d <s>     simulated run time in seconds (default 10)
+ *   -c <Hz>    force the SPI clock, 0 uses the master's request (default 0)
+ *   -f <n>     slave TX/RX FIFO depth in bytes (default 64)
+ *   -l <us>    fixed latency added to every master transfer (default 0)
+ *   -s <x>     run simulated time x times faster than host time (default 1)
+ *   -a <us>    duration of one thermistor reading on the slave (default 1000)
+ *   -t <C>     swing of the ambient temperature around 25 C over a minute,
+ *              0 keeps it steady (default 1.5)
+ *   -e <p>     probability of one bit error per byte on the bus (default 0)
+ *   -m <Hz>    fastest clock the bus carries without errors, 0 for no limit
+ *              (default 0)
+ *   -k <n>     number of slaves on the bus, 1 to 3 (default 1); slave n is
+ *              wired to the chip select and data ready pins of sensor n in
+ *              the master's SPI_SENSOR_COUNT table
+ *   -u <ms>    unplug the data lines of the first slave for ms halfway
+ *              through the run (default 0)
+ *   -x <fault>[,<ms>]
+ *              inject a fault into the traffic of the first slave every ms
+ *              (default 1000): flip one bit of a MOSI byte, drop a MOSI
+ *              byte, leave the slave FIFOs stuck until the slave resets its
+ *              pSPI block, or slip the slave clock by one bit for the rest
+ *              of a window (flip, drop, stuck, slip)
+ *   -g <mtu>[,<ms>]
+ *              connect a BLE central with the given ATT MTU to the master
+ *              and, if given, set the notification interval to ms
+ *   -j <ms>[,<ppm>]
+ *              run the clock of slave n n*ms ahead of the master clock, as if
+ *              powered on that much earlier, and ppm fast (default 0,0)
+ *   -n         leave the data ready line of the slave unconnected
+ *   -v         print the PUART trace of both devices
+ *   -o <file>  also append the report to file as comma separated values, one
+ *              row per kind of transaction and one row "all"; a header row
+ *              is written to a new file
+ *   -b <name>  name of the run in the rows of -o, such as the build variant
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "spi_gatt.h"
+#include "spi_protocol.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+/* Pins of the hardware connection table; the master has one chip select and
+   data ready pin per slave */
+#define SIM_SLAVE_CS_PIN                      WICED_P02
+#define SIM_SLAVE_DRDY_PIN                    WICED_P06
+
+/* Slaves the simulator has application images for, see Makefile */
+#define SIM_MAX_SLAVES                        (3)
+
+/* Legacy 4 byte data packet: int16 data followed by the packet header */
+#define SIM_PACKET_SIZE                       (4)
+/* Commands that read the temperature, see the sensor_cmd of the master */
+#define SIM_CMD_MEASURE_TEMPERATURE           (0x03)
+#define SIM_CMD_READ_SAMPLES                  (0x04)
+#define SIM_CMD_GET_SUMMARY                   (0x07)
+#define SIM_CMD_READ_PACKED_SAMPLES           (0x08)
+#define SIM_CMD_REPORT_TEMPERATURE            (0x09)
+#define SIM_CMD_READ_REGISTERS                (0x0A)
+#define SIM_CMD_READ_TIMED_SAMPLES            (0x0C)
+
+/* Transaction kinds tracked separately in the report */
+#define SIM_MAX_KINDS                         (32)
+#define SIM_KIND_NAME_LEN                     (40)
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+/* Latency samples of one kind of transaction */
+typedef struct
+{
+    char        name[SIM_KIND_NAME_LEN];
+    uint32_t    count;
+    uint32_t    valid;
+    uint32_t    capacity;
+    uint32_t   *latency_us;
+} sim_cmd_stats_t;
+
+/******************************************************************************
+ *                                Variables Definitions
+ ******************************************************************************/
+static pthread_mutex_t  stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static sim_cmd_stats_t  cmd_stats[SIM_MAX_KINDS];
+static uint32_t         kind_count;
+static uint32_t         window_count;
+static uint64_t         first_window_us;
+static uint64_t         last_window_us;
+/* Recoveries from windows without a valid response */
+static uint64_t         recovery_start_us;
+static uint32_t         recovery_count;
+static uint64_t         recovery_sum_us;
+static uint64_t         recovery_max_us;
+/* Injected faults and the recovery from each, in us */
+static sim_fault_t          fault_kind;
+static uint32_t             fault_interval_ms = 1000;
+static uint32_t             fault_hits;
+static uint64_t             fault_start_us;
+static const sim_device_t  *fault_slave;
+static sim_cmd_stats_t      fault_recoveries;
+
+static uint32_t         slave_count = 1;
+
+/* BLE central and the readings it received, see -g */
+static sim_central_t    gatt_central;
+static uint32_t         gatt_readings;
+static uint32_t         gatt_last_ms[SIM_MAX_SLAVES];
+static uint64_t         gatt_age_sum_ms;
+static uint32_t         gatt_age_max_ms;
+static uint32_t         gatt_out_of_order;
+static uint32_t         gatt_bad;
+
+/* Machine readable results, see -o and -b */
+static const char      *results_path;
+static const char      *results_label = "default";
+
+static const uint32_t   master_cs_pins[SIM_MAX_SLAVES]   = { WICED_P02, WICED_P10, WICED_P12 };
+static const uint32_t   master_drdy_pins[SIM_MAX_SLAVES] = { WICED_P06, WICED_P11, WICED_P13 };
+
+static const char * const cmd_names[] =
+{
+    [0x01]             = "GET_MANUFACTURER_ID",
+    [0x02]             = "GET_UNIT",
+    [0x03]             = "MEASURE_TEMPERATURE",
+    [0x05]             = "GET_DESCRIPTOR",
+};
+#define SIM_NAMED_COMMANDS  ( sizeof( cmd_names ) / sizeof( cmd_names[0] ) )
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+/* Entry points of the application images, see Makefile */
+extern void spi_master_application_start( void );
+extern void spi_slave_application_start( void );
+extern void spi_slave2_application_start( void );
+extern void spi_slave3_application_start( void );
+
+static void ( * const slave_starts[SIM_MAX_SLAVES] )( void ) =
+{
+    spi_slave_application_start, spi_slave2_application_start, spi_slave3_application_start
+};
+static const char * const slave_names[SIM_MAX_SLAVES] = { "slave", "slave2", "slave3" };
+
+/* Names of the faults for -x, indexed by sim_fault_t */
+static const char * const fault_names[] = { "none", "flip", "drop", "stuck", "slip" };
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+static uint16_t sim_le16( const uint8_t *p )
+{
+    return (uint16_t)( p[0] | ( p[1] << 8 ) );
+}
+
+static void sim_stats_add( sim_cmd_stats_t *stats, uint32_t latency_us, wiced_bool_t valid )
+{
+    if ( stats->count == stats->capacity )
+    {
+        stats->capacity   = stats->capacity ? stats->capacity * 2 : 256;
+        stats->latency_us = realloc( stats->latency_us,
+                                     stats->capacity * sizeof( uint32_t ) );
+    }
+    stats->latency_us[stats->count++] = latency_us;
+    if ( valid )
+    {
+        stats->valid++;
+    }
+}
+
+/* Stats of the named kind, created on first use; called with stats_lock held */
+static sim_cmd_stats_t *sim_stats_find( const char *name )
+{
+    uint32_t i;
+
+    for ( i = 0; i < kind_count; i++ )
+    {
+        if ( !strcmp( cmd_stats[i].name, name ) )
+        {
+            return &cmd_stats[i];
+        }
+    }
+    if ( kind_count == SIM_MAX_KINDS )
+    {
+        /* Table full, lump the rest together in the last entry */
+        snprintf( cmd_stats[SIM_MAX_KINDS - 1].name, SIM_KIND_NAME_LEN, "other" );
+        return &cmd_stats[SIM_MAX_KINDS - 1];
+    }
+    snprintf( cmd_stats[kind_count].name, SIM_KIND_NAME_LEN, "%s", name );
+    return &cmd_stats[kind_count++];
+}
+
+/* Name of a legacy command */
+static const char *sim_cmd_name( uint32_t cmd )
+{
+    return ( ( cmd < SIM_NAMED_COMMANDS ) && cmd_names[cmd] ) ? cmd_names[cmd] : "other";
+}
+
+/* Classifies a window carrying a frame; the reply frame follows the request.
+   reading is set when the frame asks for temperature samples. */
+static wiced_bool_t sim_classify_frame( const sim_window_t *window, char *name,
+                                        wiced_bool_t *reading )
+{
+    const uint8_t  *req = window->mosi;
+    const uint8_t  *rsp;
+    uint32_t        req_len = sizeof( frame_header ) + req[0] + FRAME_CRC_SIZE;
+    uint32_t        rsp_len;
+    uint32_t        req_off;
+    uint32_t        rsp_off;
+    uint32_t        used;
+
+    used = snprintf( name, SIM_KIND_NAME_LEN, "frame" );
+    for ( req_off = sizeof( frame_header );
+          ( req_off + sizeof( frame_record ) <= req_len - FRAME_CRC_SIZE ) &&
+          ( req_off < SIM_WINDOW_CAPTURE - 1 );
+          req_off += sizeof( frame_record ) + req[req_off + 1] )
+    {
+        if ( used < SIM_KIND_NAME_LEN )
+        {
+            used += snprintf( name + used, SIM_KIND_NAME_LEN - used, " %02x", req[req_off] );
+        }
+        if ( ( req[req_off] == SIM_CMD_READ_SAMPLES ) ||
+             ( req[req_off] == SIM_CMD_GET_SUMMARY ) ||
+             ( req[req_off] == SIM_CMD_READ_PACKED_SAMPLES ) ||
+             ( req[req_off] == SIM_CMD_REPORT_TEMPERATURE ) ||
+             ( req[req_off] == SIM_CMD_READ_REGISTERS ) ||
+             ( req[req_off] == SIM_CMD_READ_TIMED_SAMPLES ) )
+        {
+            *reading = WICED_TRUE;
+        }
+    }
+
+    /* The reply has to answer every command without RECORD_ERROR */
+    if ( ( req_len + sizeof( frame_header ) > window->miso_count ) ||
+         ( req_len + sizeof( frame_header ) > SIM_WINDOW_CAPTURE ) )
+    {
+        return WICED_FALSE;
+    }
+    rsp     = &window->miso[req_len];
+    rsp_len = sizeof( frame_header ) + rsp[0] + FRAME_CRC_SIZE;
+    if ( ( sim_le16( &rsp[2] ) != FRAME_HEADER ) || ( rsp[1] != req[1] ) ||
+         ( req_len + rsp_len > MIN( window->miso_count, SIM_WINDOW_CAPTURE ) ) ||
+         ( spi_crc16( SPI_CRC16_INIT, rsp, rsp_len - FRAME_CRC_SIZE ) !=
+           sim_le16( &rsp[rsp_len - FRAME_CRC_SIZE] ) ) )
+    {
+        return WICED_FALSE;
+    }
+    for ( req_off = rsp_off = sizeof( frame_header );
+          req_off + sizeof( frame_record ) <= req_len - FRAME_CRC_SIZE;
+          req_off += sizeof( frame_record ) + req[req_off + 1],
+          rsp_off += sizeof( frame_record ) + rsp[rsp_off + 1] )
+    {
+        if ( ( rsp_off + sizeof( frame_record ) > rsp_len - FRAME_CRC_SIZE ) ||
+             ( rsp[rsp_off] != req[req_off] ) )
+        {
+            return WICED_FALSE;
+        }
+    }
+    return WICED_TRUE;
+}
+
+/* Classifies one chip select window by the command it carried */
+static void sim_on_window( const sim_window_t *window )
+{
+    char            name[SIM_KIND_NAME_LEN] = "other";
+    wiced_bool_t    valid = WICED_FALSE;
+    wiced_bool_t    resync = WICED_FALSE;
+    wiced_bool_t    reading = WICED_FALSE;
+
+    if ( ( window->mosi_count >= SIM_PACKET_SIZE ) &&
+         ( window->mosi[0] == SPI_IDLE_BYTE ) && ( window->mosi[1] == SPI_IDLE_BYTE ) &&
+         ( window->mosi[2] == SPI_IDLE_BYTE ) && ( window->mosi[3] == SPI_IDLE_BYTE ) )
+    {
+        /* Idle bytes clocked out to get back in step with the slave */
+        snprintf( name, sizeof( name ), "resync" );
+        resync = WICED_TRUE;
+    }
+    else if ( ( window->mosi_count >= SIM_PACKET_SIZE ) &&
+         ( sim_le16( &window->mosi[2] ) == PACKET_HEADER ) )
+    {
+        snprintf( name, sizeof( name ), "%s", sim_cmd_name( sim_le16( &window->mosi[0] ) ) );
+        reading = ( sim_le16( &window->mosi[0] ) == SIM_CMD_MEASURE_TEMPERATURE );
+        /* The response is clocked in after the command */
+        valid = ( window->miso_count >= 2 * SIM_PACKET_SIZE ) &&
+                ( sim_le16( &window->miso[SIM_PACKET_SIZE + 2] ) == PACKET_HEADER );
+    }
+    else if ( ( window->mosi_count >= SIM_PACKET_SIZE ) &&
+              ( sim_le16( &window->mosi[2] ) == PIPELINE_HEADER ) )
+    {
+        snprintf( name, sizeof( name ), "%s pipelined",
+                  sim_cmd_name( sim_le16( &window->mosi[0] ) ) );
+        reading = WICED_TRUE;
+        /* The response to the previous command is clocked in alongside */
+        valid = ( window->miso_count >= SIM_PACKET_SIZE ) &&
+                ( sim_le16( &window->miso[2] ) == PIPELINE_HEADER );
+    }
+    else if ( ( window->mosi_count >= sizeof( frame_header ) ) &&
+              ( sim_le16( &window->mosi[2] ) == FRAME_HEADER ) )
+    {
+        valid = sim_classify_frame( window, name, &reading );
+    }
+    if ( slave_count > 1 )
+    {
+        /* Several slaves are reported apart */
+        char kind[SIM_KIND_NAME_LEN];
+
+        snprintf( kind, sizeof( kind ), "%s: %s", window->slave->name, name );
+        memcpy( name, kind, sizeof( name ) );
+    }
+
+    pthread_mutex_lock( &stats_lock );
+    if ( !window_count )
+    {
+        first_window_us = window->start_us;
+    }
+    last_window_us = window->end_us;
+    window_count++;
+    if ( !valid && !resync && !recovery_start_us )
+    {
+        recovery_start_us = window->start_us;
+    }
+    else if ( valid && reading && recovery_start_us )
+    {
+        recovery_count++;
+        recovery_sum_us += window->end_us - recovery_start_us;
+        recovery_max_us  = MAX( recovery_max_us, window->end_us - recovery_start_us );
+        recovery_start_us = 0;
+    }
+    if ( window->fault_us )
+    {
+        /* A fault hitting before the last one was recovered from adds to
+           its recovery */
+        fault_hits++;
+        if ( !fault_start_us )
+        {
+            fault_start_us = window->fault_us;
+            fault_slave    = window->slave;
+        }
+    }
+    if ( fault_start_us && valid && reading && ( window->slave == fault_slave ) )
+    {
+        sim_stats_add( &fault_recoveries, (uint32_t)( window->end_us - fault_start_us ),
+                       WICED_TRUE );
+        fault_start_us = 0;
+    }
+    sim_stats_add( sim_stats_find( name ), (uint32_t)( window->end_us - window->start_us ), valid );
+    pthread_mutex_unlock( &stats_lock );
+}
+
+static int sim_cmp_u32( const void *a, const void *b )
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return ( x > y ) - ( x < y );
+}
+
+static double sim_percentile_ms( const sim_cmd_stats_t *stats, double pct )
+{
+    uint32_t idx = (uint32_t)( pct / 100.0 * ( stats->count - 1 ) + 0.5 );
+
+    return stats->latency_us[idx] / 1000.0;
+}
+
+static uint32_t sim_le32( const uint8_t *p )
+{
+    return (uint32_t)sim_le16( p ) | ( (uint32_t)sim_le16( p + 2 ) << 16 );
+}
+
+/* Decodes a notification of the temperature samples of the master, see
+   spi_gatt.h; the readings of each slave must come oldest first and in the
+   temperature range of the ambient model */
+static void sim_on_notification( const sim_device_t *dev, uint16_t handle,
+                                 const uint8_t *data, uint16_t len )
+{
+    uint32_t    now_ms = (uint32_t)( sim_now_us() / 1000 );
+    uint32_t    time_ms;
+    uint32_t    age_ms;
+    double      temp_c;
+    uint32_t    i;
+
+    (void)dev;
+    pthread_mutex_lock( &stats_lock );
+    if ( ( handle != HDLC_TEMPERATURE_SAMPLES_VALUE ) ||
+         ( len < SPI_GATT_NOTIFY_HEADER_SIZE + SPI_GATT_SAMPLE_SIZE ) ||
+         ( ( len - SPI_GATT_NOTIFY_HEADER_SIZE ) % SPI_GATT_SAMPLE_SIZE ) )
+    {
+        gatt_bad++;
+        pthread_mutex_unlock( &stats_lock );
+        return;
+    }
+    time_ms = sim_le32( data );
+    for ( i = SPI_GATT_NOTIFY_HEADER_SIZE; i < len; i += SPI_GATT_SAMPLE_SIZE )
+    {
+        time_ms += sim_le16( &data[i + 1] );
+        temp_c   = (int16_t)sim_le16( &data[i + 3] ) / 100.0;
+        if ( ( data[i] >= slave_count ) ||
+             ( temp_c < sim_config.temp_base_c - sim_config.temp_swing_c - 5.0 ) ||
+             ( temp_c > sim_config.temp_base_c + sim_config.temp_swing_c + 5.0 ) )
+        {
+            gatt_bad++;
+            continue;
+        }
+        if ( gatt_last_ms[data[i]] && ( (int32_t)( time_ms - gatt_last_ms[data[i]] ) < 0 ) )
+        {
+            gatt_out_of_order++;
+        }
+        gatt_last_ms[data[i]] = time_ms;
+        age_ms           = now_ms - time_ms;
+        gatt_age_sum_ms += age_ms;
+        gatt_age_max_ms  = ( age_ms > gatt_age_max_ms ) ? age_ms : gatt_age_max_ms;
+        gatt_readings++;
+    }
+    pthread_mutex_unlock( &stats_lock );
+}
+
+static void sim_report( const sim_device_t *master, sim_device_t * const *slaves,
+                        double duration_s )
+{
+    uint32_t    i;
+    uint64_t    sum;
+    uint32_t    k;
+    double      span_s;
+    uint64_t    unplug_us = slaves[0]->spi.unplug_end_us - slaves[0]->spi.unplug_start_us;
+
+    pthread_mutex_lock( &stats_lock );
+    span_s = ( window_count > 1 ) ? ( last_window_us - first_window_us ) / 1e6 : 0.0;
+
+    printf( "\nSPI simulator report\n" );
+    printf( "  run time            %.1f s simulated\n", duration_s );
+    printf( "  SPI clock           %u Hz%s, %u changes\n",
+            sim_config.clock_hz ? sim_config.clock_hz : master->spi.clock_hz,
+            sim_config.clock_hz ? " (forced)" : "", master->spi.clock_changes );
+    if ( sim_config.link_max_hz )
+    {
+        printf( "  error-free clock    %u Hz\n", sim_config.link_max_hz );
+    }
+    printf( "  FIFO depth          %u bytes\n", sim_config.fifo_depth );
+    printf( "  transfer latency    %u us\n", sim_config.latency_us );
+    printf( "  transactions        %u\n", window_count );
+    printf( "  transactions/s      %.2f\n", span_s > 0 ? ( window_count - 1 ) / span_s : 0.0 );
+    printf( "\n  %-26s %7s %7s %9s %9s %9s %9s\n",
+            "command", "count", "valid", "mean ms", "p50 ms", "p99 ms", "max ms" );
+    for ( i = 0; i < kind_count; i++ )
+    {
+        sim_cmd_stats_t *stats = &cmd_stats[i];
+
+        if ( !stats->count )
+        {
+            continue;
+        }
+        qsort( stats->latency_us, stats->count, sizeof( uint32_t ), sim_cmp_u32 );
+        for ( sum = 0, k = 0; k < stats->count; k++ )
+        {
+            sum += stats->latency_us[k];
+        }
+        printf( "  %-26s %7u %7u %9.3f %9.3f %9.3f %9.3f\n",
+                stats->name, stats->count, stats->valid,
+                (double)sum / stats->count / 1000.0,
+                sim_percentile_ms( stats, 50.0 ), sim_percentile_ms( stats, 99.0 ),
+                stats->latency_us[stats->count - 1] / 1000.0 );
+    }
+    printf( "\n  master pSPI         %llu bytes, %u resets\n",
+            (unsigned long long)master->spi.bytes, master->spi.resets );
+    for ( i = 0; i < slave_count; i++ )
+    {
+        char label[SIM_KIND_NAME_LEN];
+
+        snprintf( label, sizeof( label ), "%s pSPI", slaves[i]->name );
+        printf( "  %-19s %u resets, %u rx overflows, %u tx underruns\n",
+                label, slaves[i]->spi.resets, slaves[i]->spi.rx_overflows,
+                slaves[i]->spi.tx_underruns );
+    }
+    printf( "  thread wakeups/s    master %.1f", master->sleeps / duration_s );
+    for ( i = 0; i < slave_count; i++ )
+    {
+        printf( ", %s %.1f", slaves[i]->name, slaves[i]->sleeps / duration_s );
+    }
+    printf( "\n" );
+    if ( ( sim_config.bit_error_rate > 0.0 ) || master->spi.bit_errors )
+    {
+        printf( "  bit errors          %u bytes damaged (rate %g)\n",
+                master->spi.bit_errors, sim_config.bit_error_rate );
+    }
+    if ( unplug_us )
+    {
+        printf( "  unplugged           %s for %.1f ms\n", slaves[0]->name, unplug_us / 1000.0 );
+    }
+    if ( ( sim_config.bit_error_rate > 0.0 ) || master->spi.bit_errors || unplug_us )
+    {
+        printf( "  recoveries          %u, mean %.3f ms, max %.3f ms%s\n",
+                recovery_count,
+                recovery_count ? (double)recovery_sum_us / recovery_count / 1000.0 : 0.0,
+                recovery_max_us / 1000.0,
+                recovery_start_us ? ", one still open" : "" );
+    }
+    if ( gatt_central.mtu )
+    {
+        const sim_bt_t *bt = &master->bt;
+
+        printf( "  GATT notifications  %u, %.2f/s, MTU %u, %.1f readings and %.1f bytes each\n",
+                bt->notifications, bt->notifications / duration_s, bt->mtu,
+                bt->notifications ? (double)gatt_readings / bt->notifications : 0.0,
+                bt->notifications ? (double)bt->notify_bytes / bt->notifications : 0.0 );
+        printf( "  GATT readings       %u, age mean %.1f ms, max %u ms, %u out of order, "
+                "%u bad\n",
+                gatt_readings, gatt_readings ? (double)gatt_age_sum_ms / gatt_readings : 0.0,
+                gatt_age_max_ms, gatt_out_of_order, gatt_bad );
+        if ( bt->notify_rejected || bt->request_errors || ( bt->connections != 1 ) )
+        {
+            printf( "  GATT errors         %u connections, %u notifications rejected, "
+                    "%u requests refused\n",
+                    bt->connections, bt->notify_rejected, bt->request_errors );
+        }
+    }
+    if ( slaves[0]->clock_offset_us || ( slaves[0]->clock_drift_ppm != 0.0 ) )
+    {
+        printf( "  slave clocks        ahead of the master by" );
+        for ( i = 0; i < slave_count; i++ )
+        {
+            printf( "%s %s %.3f ms", i ? "," : "", slaves[i]->name,
+                    ( slaves[i]->clock_offset_us +
+                      duration_s * 1e6 * slaves[i]->clock_drift_ppm / 1e6 ) / 1000.0 );
+        }
+        printf( " at the end, %g ppm fast\n", slaves[0]->clock_drift_ppm );
+    }
+    if ( fault_kind != SIM_FAULT_NONE )
+    {
+        const sim_cmd_stats_t *stats = &fault_recoveries;
+
+        qsort( stats->latency_us, stats->count, sizeof( uint32_t ), sim_cmp_u32 );
+        for ( sum = 0, k = 0; k < stats->count; k++ )
+        {
+            sum += stats->latency_us[k];
+        }
+        printf( "  injected faults     %s every %u ms, %u hit %s, %u recovered from\n",
+                fault_names[fault_kind], fault_interval_ms, fault_hits, slaves[0]->name,
+                stats->count );
+        if ( stats->count )
+        {
+            printf( "  fault recovery      mean %.3f ms, p50 %.3f ms, p99 %.3f ms, "
+                    "max %.3f ms%s\n",
+                    (double)sum / stats->count / 1000.0,
+                    sim_percentile_ms( stats, 50.0 ), sim_percentile_ms( stats, 99.0 ),
+                    stats->latency_us[stats->count - 1] / 1000.0,
+                    fault_start_us ? ", one still open" : "" );
+        }
+    }
+    pthread_mutex_unlock( &stats_lock );
+}
+
+/* Appends the report to results_path; latencies are sorted by sim_report */
+static void sim_write_results( const sim_device_t *master, double duration_s )
+{
+    FILE               *out;
+    sim_cmd_stats_t     all = { .name = "all" };
+    uint32_t            clock_hz;
+    double              span_s;
+    uint32_t            i;
+    uint32_t            k;
+
+    out = fopen( results_path, "a" );
+    if ( !out )
+    {
+        perror( results_path );
+        exit( 1 );
+    }
+    if ( 0 == ftell( out ) )
+    {
+        fprintf( out, "name,clock_hz,bit_error_rate,slaves,run_s,kind,count,valid,"
+                      "tps,mean_ms,p50_ms,p99_ms,max_ms\n" );
+    }
+
+    pthread_mutex_lock( &stats_lock );
+    span_s   = ( window_count > 1 ) ? ( last_window_us - first_window_us ) / 1e6 : 0.0;
+    clock_hz = sim_config.clock_hz ? sim_config.clock_hz : master->spi.clock_hz;
+    for ( i = 0; i < kind_count; i++ )
+    {
+        for ( k = 0; k < cmd_stats[i].count; k++ )
+        {
+            sim_stats_add( &all, cmd_stats[i].latency_us[k], WICED_FALSE );
+        }
+        all.valid += cmd_stats[i].valid;
+    }
+    qsort( all.latency_us, all.count, sizeof( uint32_t ), sim_cmp_u32 );
+
+    /* Recoveries from injected faults follow "all", counting the faults that
+       hit as transactions and those recovered from as valid */
+    snprintf( fault_recoveries.name, sizeof( fault_recoveries.name ), "recovery from %s",
+              fault_names[fault_kind] );
+    for ( i = 0; i <= kind_count + 1; i++ )
+    {
+        const sim_cmd_stats_t *stats = ( i < kind_count ) ? &cmd_stats[i] :
+                                       ( i == kind_count ) ? &all : &fault_recoveries;
+        uint32_t               count = ( stats == &fault_recoveries ) ? fault_hits : stats->count;
+        uint64_t               sum = 0;
+
+        if ( !stats->count )
+        {
+            continue;
+        }
+        for ( k = 0; k < stats->count; k++ )
+        {
+            sum += stats->latency_us[k];
+        }
+        fprintf( out, "%s,%u,%g,%u,%.1f,%s,%u,%u,%.2f,%.4f,%.4f,%.4f,%.4f\n",
+                 results_label, clock_hz, sim_config.bit_error_rate, slave_count,
+                 duration_s, stats->name, count, stats->valid,
+                 span_s > 0 ? count / span_s : 0.0,
+                 (double)sum / stats->count / 1000.0,
+                 sim_percentile_ms( stats, 50.0 ), sim_percentile_ms( stats, 99.0 ),
+                 stats->latency_us[stats->count - 1] / 1000.0 );
+    }
+    pthread_mutex_unlock( &stats_lock );
+    free( all.latency_us );
+    fclose( out );
+}
+
+static void sim_usage( const char *prog )
+{
+    fprintf( stderr,
+             "usage: %s [-d seconds] [-c clock_hz] [-f fifo_depth] [-l latency_us]\n"
+             "       [-s time_scale] [-a adc_us] [-t swing_c] [-e bit_error_rate]\n"
+             "       [-m link_max_hz] [-k slaves] [-u unplug_ms] [-x fault[,ms]]\n"
+             "       [-g mtu[,ms]] [-j ms[,ppm]] [-n] [-v] [-o results.csv] [-b name]\n",
+             prog );
+    exit( 2 );
+}
+
+int main( int argc, char *argv[] )
+{
+    sim_device_t   *master;
+    sim_device_t   *slaves[SIM_MAX_SLAVES];
+    double          duration_s = 10.0;
+    int             data_ready_line = 1;
+    uint32_t        unplug_ms = 0;
+    uint64_t        run_us;
+    uint64_t        elapsed_us = 0;
+    char           *interval;
+    uint32_t        notify_ms;
+    double          clock_ahead_ms = 0.0;
+    double          clock_drift_ppm = 0.0;
+    int             opt;
+    uint32_t        i;
+
+    while ( ( opt = getopt( argc, argv, "d:c:f:l:s:a:t:e:m:k:u:x:g:j:nvo:b:" ) ) != -1 )
+    {
+        switch ( opt )
+        {
+        case 'd':
+            duration_s = atof( optarg );
+            break;
+        case 'c':
+            sim_config.clock_hz = (uint32_t)strtoul( optarg, NULL, 0 );
+            break;
+        case 'f':
+            sim_config.fifo_depth = (uint32_t)strtoul( optarg, NULL, 0 );
+            break;
+        case 'l':
+            sim_config.latency_us = (uint32_t)strtoul( optarg, NULL, 0 );
+            break;
+        case 's':
+            sim_config.time_scale = atof( optarg );
+            break;
+        case 'a':
+            sim_config.adc_conversion_us = (uint32_t)strtoul( optarg, NULL, 0 );
+            break;
+        case 't':
+            sim_config.temp_swing_c = atof( optarg );
+            break;
+        case 'e':
+            sim_config.bit_error_rate = atof( optarg );
+            break;
+        case 'm':
+            sim_config.link_max_hz = (uint32_t)strtoul( optarg, NULL, 0 );
+            break;
+        case 'k':
+            slave_count = (uint32_t)strtoul( optarg, NULL, 0 );
+            break;
+        case 'u':
+            unplug_ms = (uint32_t)strtoul( optarg, NULL, 0 );
+            break;
+        case 'x':
+            if ( NULL != ( interval = strchr( optarg, ',' ) ) )
+            {
+                *interval++       = '\0';
+                fault_interval_ms = (uint32_t)strtoul( interval, NULL, 0 );
+            }
+            for ( i = SIM_FAULT_BIT_FLIP; i <= SIM_FAULT_CLOCK_SLIP; i++ )
+            {
+                if ( 0 == strcmp( optarg, fault_names[i] ) )
+                {
+                    fault_kind = (sim_fault_t)i;
+                }
+            }
+            if ( ( fault_kind == SIM_FAULT_NONE ) || ( fault_interval_ms == 0 ) )
+            {
+                sim_usage( argv[0] );
+            }
+            break;
+        case 'g':
+            if ( NULL != ( interval = strchr( optarg, ',' ) ) )
+            {
+                static const uint8_t interval_uuid[16] = { SPI_GATT_UUID_INTERVAL };
+
+                *interval++ = '\0';
+                notify_ms   = (uint32_t)strtoul( interval, NULL, 0 );
+                if ( ( notify_ms < SPI_GATT_INTERVAL_MIN_MS ) ||
+                     ( notify_ms > SPI_GATT_INTERVAL_MAX_MS ) )
+                {
+                    sim_usage( argv[0] );
+                }
+                memcpy( gatt_central.write_uuid, interval_uuid, sizeof( interval_uuid ) );
+                gatt_central.write_value[0] = (uint8_t)notify_ms;
+                gatt_central.write_value[1] = (uint8_t)( notify_ms >> 8 );
+                gatt_central.write_len      = 2;
+            }
+            gatt_central.mtu  = (uint16_t)strtoul( optarg, NULL, 0 );
+            gatt_central.hook = sim_on_notification;
+            if ( gatt_central.mtu < GATT_DEF_BLE_MTU_SIZE )
+            {
+                sim_usage( argv[0] );
+            }
+            break;
+        case 'j':
+            if ( NULL != ( interval = strchr( optarg, ',' ) ) )
+            {
+                *interval++     = '\0';
+                clock_drift_ppm = atof( interval );
+            }
+            clock_ahead_ms = atof( optarg );
+            if ( ( clock_ahead_ms < 0.0 ) || ( clock_drift_ppm <= -1e6 ) )
+            {
+                sim_usage( argv[0] );
+            }
+            break;
+        case 'n':
+            data_ready_line = 0;
+            break;
+        case 'v':
+            sim_config.trace = 1;
+            break;
+        case 'o':
+            results_path = optarg;
+            break;
+        case 'b':
+            results_label = optarg;
+            break;
+        default:
+            sim_usage( argv[0] );
+        }
+    }
+    if ( ( duration_s <= 0 ) || ( sim_config.time_scale <= 0 ) ||
+         ( sim_config.fifo_depth == 0 ) || ( sim_config.fifo_depth > SIM_FIFO_MAX_DEPTH ) ||
+         ( sim_config.bit_error_rate < 0.0 ) || ( sim_config.bit_error_rate > 1.0 ) ||
+         ( slave_count == 0 ) || ( slave_count > SIM_MAX_SLAVES ) )
+    {
+        sim_usage( argv[0] );
+    }
+
+    master = sim_device_create( "master", spi_master_application_start );
+    for ( i = 0; i < slave_count; i++ )
+    {
+        slaves[i] = sim_device_create( slave_names[i], slave_starts[i] );
+
+        sim_gpio_connect( master, master_cs_pins[i], slaves[i], SIM_SLAVE_CS_PIN );
+        if ( data_ready_line )
+        {
+            sim_gpio_connect( slaves[i], SIM_SLAVE_DRDY_PIN, master, master_drdy_pins[i] );
+        }
+        sim_pspi_attach_slave( slaves[i], SIM_SLAVE_CS_PIN );
+        slaves[i]->clock_offset_us = (int64_t)( clock_ahead_ms * 1000.0 * ( i + 1 ) );
+        slaves[i]->clock_drift_ppm = clock_drift_ppm;
+    }
+    slaves[0]->spi.unplug_start_us = sim_now_us() + (uint64_t)( duration_s * 1e6 / 2 );
+    slaves[0]->spi.unplug_end_us   = slaves[0]->spi.unplug_start_us + unplug_ms * 1000ull;
+    sim_pspi_set_window_hook( sim_on_window );
+    if ( gatt_central.mtu )
+    {
+        sim_bt_central( master, &gatt_central );
+    }
+
+    for ( i = 0; i < slave_count; i++ )
+    {
+        sim_device_start( slaves[i] );
+    }
+    sim_device_start( master );
+
+    run_us = (uint64_t)( duration_s * 1e6 );
+    while ( ( fault_kind != SIM_FAULT_NONE ) &&
+            ( elapsed_us + fault_interval_ms * 1000ull < run_us ) )
+    {
+        sim_sleep_us( fault_interval_ms * 1000ull );
+        elapsed_us += fault_interval_ms * 1000ull;
+        sim_pspi_inject_fault( slaves[0], fault_kind );
+    }
+    sim_sleep_us( run_us - elapsed_us );
+
+    sim_report( master, slaves, duration_s );
+    if ( results_path )
+    {
+        sim_write_results( master, duration_s );
+    }
+    return 0;
+}
@@ -0,0 +1,181 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file thermistor_bench.c
+ *
+ * @brief
+ * Host benchmark of the thermistor conversions of the SPI slave.
+ *
+ * Compares the floating point beta equation, which is the resistance to
+ * temperature math of the thermistor library, with the generated lookup
+ * table of thermistor_lut.c. Both convert the divider voltage an ideal ADC
+ * reports, in whole millivolts, at every hundredth of a degree of the table
+ * range. The errors are against the true temperature, so they include the
+ * millivolt resolution of the input. The times are host times and only
+ * their ratio carries over to the device.
+ *
+ * Usage: thermistor_bench
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "thermistor_lut.h"
+#include "thermistor_lut_table.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+#define BENCH_VDDIO_MV                        (3300)
+#define BENCH_MIN_CENTI                       (-4000)
+#define BENCH_MAX_CENTI                       (12500)
+#define BENCH_POINTS                          (BENCH_MAX_CENTI - BENCH_MIN_CENTI + 1)
+/* Passes over all points when timing */
+#define BENCH_ROUNDS                          (200)
+#define BENCH_KELVIN_OFFSET                   (273.15)
+#define BENCH_T25_KELVIN                      (25.0 + BENCH_KELVIN_OFFSET)
+
+typedef int16_t (*bench_conversion_t)( uint32_t input_mv, uint32_t vddio_mv );
+
+/******************************************************************************
+ *                                Variables Definitions
+ ******************************************************************************/
+static uint32_t         bench_input_mv[BENCH_POINTS];
+/* Keeps the timed conversions from being optimized away */
+static volatile int32_t bench_sink;
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+static double bench_now_ns( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*******************************************************************************
+ Function name: bench_beta_convert
+
+ Function Description:
+ @brief    Converts the divider voltage with the beta equation in floating
+           point.
+
+ @param    input_mv  voltage at the thermistor
+ @param    vddio_mv  voltage at the top of the divider
+
+ @return   int16_t   temperature in hundredths of a degree Celsius
+ ******************************************************************************/
+static int16_t bench_beta_convert( uint32_t input_mv, uint32_t vddio_mv )
+{
+    double r = THERMISTOR_LUT_RREF * input_mv / (double)( vddio_mv - input_mv );
+
+    return (int16_t)lround( 100.0 * ( 1.0 / ( 1.0 / BENCH_T25_KELVIN +
+                                              log( r / THERMISTOR_LUT_R25 ) / THERMISTOR_LUT_BETA )
+                                      - BENCH_KELVIN_OFFSET ) );
+}
+
+/*******************************************************************************
+ Function name: bench_run
+
+ Function Description:
+ @brief    Measures the accuracy and speed of one conversion and prints them.
+
+ @param    *name    name of the conversion
+ @param    convert  conversion
+ ******************************************************************************/
+static void bench_run( const char *name, bench_conversion_t convert )
+{
+    double   start, elapsed;
+    double   total_error = 0;
+    int32_t  max_error = 0;
+    int32_t  error;
+    int32_t  sum = 0;
+    int      i, round;
+
+    for ( i = 0; i < BENCH_POINTS; i++ )
+    {
+        error = abs( convert( bench_input_mv[i], BENCH_VDDIO_MV ) - ( BENCH_MIN_CENTI + i ) );
+        total_error += error;
+        if ( error > max_error )
+        {
+            max_error = error;
+        }
+    }
+
+    start = bench_now_ns();
+    for ( round = 0; round < BENCH_ROUNDS; round++ )
+    {
+        for ( i = 0; i < BENCH_POINTS; i++ )
+        {
+            sum += convert( bench_input_mv[i], BENCH_VDDIO_MV );
+        }
+    }
+    elapsed = bench_now_ns() - start;
+    bench_sink = sum;
+
+    printf( "  %-16s %12.1f %14.2f %15.3f\n", name,
+            elapsed / ( (double)BENCH_ROUNDS * BENCH_POINTS ),
+            max_error / 100.0, total_error / BENCH_POINTS / 100.0 );
+}
+
+int main( void )
+{
+    double celsius, r;
+    int    i;
+
+    /* Divider voltage at each test temperature, as the ADC reports it */
+    for ( i = 0; i < BENCH_POINTS; i++ )
+    {
+        celsius = ( BENCH_MIN_CENTI + i ) / 100.0;
+        r = THERMISTOR_LUT_R25 * exp( THERMISTOR_LUT_BETA *
+                                      ( 1.0 / ( celsius + BENCH_KELVIN_OFFSET ) - 1.0 / BENCH_T25_KELVIN ) );
+        bench_input_mv[i] = (uint32_t)lround( BENCH_VDDIO_MV * r / ( r + THERMISTOR_LUT_RREF ) );
+    }
+
+    printf( "thermistor conversion, %d points from %.2f to %.2f C, table of %d entries (%d bytes)\n\n",
+            BENCH_POINTS, BENCH_MIN_CENTI / 100.0, BENCH_MAX_CENTI / 100.0,
+            THERMISTOR_LUT_SIZE, (int)sizeof( thermistor_lut ) );
+    printf( "  %-16s %12s %14s %15s\n", "conversion", "ns/reading", "max error C", "mean error C" );
+    bench_run( "beta equation", bench_beta_convert );
+    bench_run( "lookup table", thermistor_lut_convert );
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file spi_delta.c
+ *
+ * @brief
+ * Delta and varint coding of sample blocks, see spi_delta.h.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include <string.h>
+
+#include "spi_delta.h"
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ Function name: spi_delta_encode
+
+ Function Description:
+ @brief    Encodes samples, oldest first, as long as their encoding fits.
+
+ @param   *samples   samples to encode
+ @param   count      number of samples
+ @param   *data      buffer for the encoding
+ @param   size       size of data
+ @param   *encoded   number of samples encoded
+
+ @return uint32_t  number of bytes written
+ ******************************************************************************/
+
+uint32_t spi_delta_encode( const int16_t *samples, uint32_t count,
+                           uint8_t *data, uint32_t size, uint32_t *encoded )
+{
+    uint8_t  bytes[SPI_DELTA_MAX_BYTES];
+    uint32_t used     = 0;
+    int32_t  previous = 0;
+    int32_t  delta;
+    uint32_t zigzag;
+    uint32_t length;
+    uint32_t i;
+
+    for ( i = 0; i < count; i++ )
+    {
+        delta  = samples[i] - previous;
+        zigzag = ( delta < 0 ) ? ( ( (uint32_t)-delta << 1 ) - 1 ) : ( (uint32_t)delta << 1 );
+        length = 0;
+        do
+        {
+            bytes[length] = (uint8_t)( zigzag & 0x7F );
+            zigzag >>= 7;
+            if ( zigzag )
+            {
+                bytes[length] |= 0x80;
+            }
+            length++;
+        } while ( zigzag );
+
+        if ( used + length > size )
+        {
+            break;
+        }
+        memcpy( &data[used], bytes, length );
+        used    += length;
+        previous = samples[i];
+    }
+    *encoded = i;
+    return used;
+}
+
+/*******************************************************************************
+ Function name: spi_delta_decode
+
+ Function Description:
+ @brief    Decodes a block of samples.
+
+ @param   *data        encoding
+ @param   length       bytes of encoding
+ @param   *samples     buffer for the samples
+ @param   max_samples  capacity of samples
+ @param   *count       number of samples decoded
+
+ @return wiced_bool_t  WICED_FALSE if the encoding is cut short, decodes to
+                       values outside int16_t or to more than max_samples
+ ******************************************************************************/
+
+wiced_bool_t spi_delta_decode( const uint8_t *data, uint32_t length,
+                               int16_t *samples, uint32_t max_samples,
+                               uint32_t *count )
+{
+    uint32_t offset = 0;
+    int32_t  value  = 0;
+    uint32_t zigzag;
+    uint32_t shift;
+    uint32_t n      = 0;
+
+    while ( offset < length )
+    {
+        zigzag = 0;
+        shift  = 0;
+        do
+        {
+            if ( ( offset >= length ) || ( shift >= 7 * SPI_DELTA_MAX_BYTES ) )
+            {
+                return WICED_FALSE;
+            }
+            zigzag |= (uint32_t)( data[offset] & 0x7F ) << shift;
+            shift  += 7;
+        } while ( data[offset++] & 0x80 );
+
+        value += ( zigzag & 1 ) ? -(int32_t)( ( zigzag + 1 ) >> 1 ) : (int32_t)( zigzag >> 1 );
+        if ( ( value < INT16_MIN ) || ( value > INT16_MAX ) || ( n >= max_samples ) )
+        {
+            return WICED_FALSE;
+        }
+        samples[n++] = (int16_t)value;
+    }
+    *count = n;
+    return WICED_TRUE;
+}
@@ -0,0 +1,71 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file spi_delta.h
+ *
+ * @brief
+ * Delta encoding of blocks of 16 bit temperature samples.
+ *
+ * Each sample is sent as its difference to the previous one, the first as
+ * its difference to 0. Differences are zigzag mapped, 0, -1, 1, -2, 2, ... to
+ * 0, 1, 2, 3, 4, ..., and written as varints: seven bits per byte, least
+ * significant group first, with the top bit set on all bytes but the last.
+ * A temperature that changes by at most 0.63 degree between two samples
+ * takes one byte instead of two, and any sample at most three.
+ ******************************************************************************/
+
+#ifndef SPI_DELTA_H
+#define SPI_DELTA_H
+
+#include "wiced.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+/* Longest encoding of one sample*/
+#define SPI_DELTA_MAX_BYTES                   (3)
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+uint32_t            spi_delta_encode( const int16_t *samples, uint32_t count,
+                                      uint8_t *data, uint32_t size,
+                                      uint32_t *encoded );
+wiced_bool_t        spi_delta_decode( const uint8_t *data, uint32_t length,
+                                      int16_t *samples, uint32_t max_samples,
+                                      uint32_t *count );
+
+#endif /* SPI_DELTA_H */
@@ -0,0 +1,563 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file spi_frame.c
+ *
+ * @brief
+ * Building and walking the multi-command frames of spi_protocol.h, and the
+ * wire formats of the temperature summary, the report configuration, the
+ * slave time, the timed burst read and the ADC scan.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include <string.h>
+
+#include "spi_protocol.h"
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ Function name: spi_frame_init
+
+ Function Description:
+ @brief    Prepares an empty frame.
+
+ @param   *frame  frame to initialize
+
+ @return void
+ ******************************************************************************/
+
+void spi_frame_init( spi_frame *frame )
+{
+    frame->hdr.length   = 0;
+    frame->hdr.seq      = 0;
+    frame->hdr.header   = FRAME_HEADER;
+}
+
+/*******************************************************************************
+ Function name: spi_frame_add
+
+ Function Description:
+ @brief    Appends a record to a frame.
+
+ @param   *frame  frame to append to
+ @param   cmd     command code of the record
+ @param   length  number of data bytes
+ @param   *data   record data, may be NULL when length is 0
+
+ @return wiced_bool_t  WICED_FALSE if the record does not fit
+ ******************************************************************************/
+
+wiced_bool_t spi_frame_add( spi_frame *frame, uint8_t cmd,
+                            uint8_t length, const void *data )
+{
+    frame_record *record;
+
+    if ( frame->hdr.length + sizeof( frame_record ) + length > FRAME_MAX_PAYLOAD )
+    {
+        return WICED_FALSE;
+    }
+    record = (frame_record *)&frame->payload[frame->hdr.length];
+    record->cmd    = cmd;
+    record->length = length;
+    if ( length )
+    {
+        memcpy( record->data, data, length );
+    }
+    frame->hdr.length += sizeof( frame_record ) + length;
+    return WICED_TRUE;
+}
+
+/*******************************************************************************
+ Function name: spi_frame_seal
+
+ Function Description:
+ @brief    Completes a frame for sending: sets its sequence number and
+           appends the CRC. Records must not be added afterwards.
+
+ @param   *frame  frame to complete
+ @param   seq     sequence number
+
+ @return void
+ ******************************************************************************/
+
+void spi_frame_seal( spi_frame *frame, uint8_t seq )
+{
+    uint16_t crc;
+
+    frame->hdr.seq = seq;
+    crc = spi_frame_crc( frame );
+    frame->payload[frame->hdr.length]     = (uint8_t)crc;
+    frame->payload[frame->hdr.length + 1] = (uint8_t)( crc >> 8 );
+}
+
+/*******************************************************************************
+ Function name: spi_frame_size
+
+ Function Description:
+ @brief    Number of bytes the frame occupies on the bus.
+
+ @param   *frame  frame
+
+ @return uint32_t  header, payload and CRC size
+ ******************************************************************************/
+
+uint32_t spi_frame_size( const spi_frame *frame )
+{
+    return sizeof( frame_header ) + frame->hdr.length + FRAME_CRC_SIZE;
+}
+
+/*******************************************************************************
+ Function name: spi_frame_crc
+
+ Function Description:
+ @brief    Computes the CRC over the header and the payload of a frame.
+
+ @param   *frame  frame
+
+ @return uint16_t  CRC
+ ******************************************************************************/
+
+uint16_t spi_frame_crc( const spi_frame *frame )
+{
+    return spi_crc16( SPI_CRC16_INIT, frame,
+                      sizeof( frame_header ) + frame->hdr.length );
+}
+
+/*******************************************************************************
+ Function name: spi_frame_header_valid
+
+ Function Description:
+ @brief    Checks a received frame header before its payload is read.
+
+ @param   *hdr  received header
+
+ @return wiced_bool_t  WICED_TRUE if the header starts a well formed frame
+ ******************************************************************************/
+
+wiced_bool_t spi_frame_header_valid( const frame_header *hdr )
+{
+    return ( ( FRAME_HEADER == hdr->header ) &&
+             ( hdr->length <= FRAME_MAX_PAYLOAD ) ) ? WICED_TRUE : WICED_FALSE;
+}
+
+/*******************************************************************************
+ Function name: spi_frame_crc_valid
+
+ Function Description:
+ @brief    Checks the CRC of a received frame.
+
+ @param   *frame  received frame, header already validated
+
+ @return wiced_bool_t  WICED_TRUE if the CRC matches
+ ******************************************************************************/
+
+wiced_bool_t spi_frame_crc_valid( const spi_frame *frame )
+{
+    uint16_t crc = (uint16_t)( frame->payload[frame->hdr.length] |
+                               ( frame->payload[frame->hdr.length + 1] << 8 ) );
+
+    return ( spi_frame_crc( frame ) == crc ) ? WICED_TRUE : WICED_FALSE;
+}
+
+/*******************************************************************************
+ Function name: spi_frame_next
+
+ Function Description:
+ @brief    Walks the records of a frame.
+
+ @param   *frame   frame to walk
+ @param   *offset  payload offset of the next record, start with 0
+
+ @return const frame_record*  next record, NULL at the end of the frame or
+                              when a record runs past the payload
+ ******************************************************************************/
+
+const frame_record *spi_frame_next( const spi_frame *frame, uint32_t *offset )
+{
+    const frame_record *record;
+
+    if ( *offset + sizeof( frame_record ) > frame->hdr.length )
+    {
+        return NULL;
+    }
+    record = (const frame_record *)&frame->payload[*offset];
+    if ( *offset + sizeof( frame_record ) + record->length > frame->hdr.length )
+    {
+        return NULL;
+    }
+    *offset += sizeof( frame_record ) + record->length;
+    return record;
+}
+
+/*******************************************************************************
+ Function name: spi_record_int16
+
+ Function Description:
+ @brief    Reads the 16 bit value carried by a record. Record data is not
+           aligned, so it is assembled byte by byte.
+
+ @param   *record  record with at least two data bytes
+
+ @return int16_t  the value, 0 if the record is shorter
+ ******************************************************************************/
+
+int16_t spi_record_int16( const frame_record *record )
+{
+    if ( record->length < sizeof( int16_t ) )
+    {
+        return 0;
+    }
+    return (int16_t)( record->data[0] | ( record->data[1] << 8 ) );
+}
+
+/*******************************************************************************
+ Function name: spi_summary_pack
+
+ Function Description:
+ @brief    Writes a temperature summary in its wire format, the fields in
+           order of declaration.
+
+ @param   *summary  summary
+ @param   *data     SUMMARY_WIRE_SIZE bytes
+
+ @return void
+ ******************************************************************************/
+
+void spi_summary_pack( const temperature_summary *summary, uint8_t *data )
+{
+    const uint16_t field[] = { summary->window, summary->count,
+                               (uint16_t)summary->min, (uint16_t)summary->max,
+                               (uint16_t)summary->mean };
+    uint32_t i;
+
+    for ( i = 0; i < SUMMARY_WIRE_SIZE / sizeof( uint16_t ); i++ )
+    {
+        *data++ = (uint8_t)field[i];
+        *data++ = (uint8_t)( field[i] >> 8 );
+    }
+}
+
+/*******************************************************************************
+ Function name: spi_summary_unpack
+
+ Function Description:
+ @brief    Reads a temperature summary from its wire format.
+
+ @param   *summary  summary
+ @param   *data     SUMMARY_WIRE_SIZE bytes
+
+ @return void
+ ******************************************************************************/
+
+void spi_summary_unpack( temperature_summary *summary, const uint8_t *data )
+{
+    summary->window = (uint16_t)( data[0] | ( data[1] << 8 ) );
+    summary->count  = (uint16_t)( data[2] | ( data[3] << 8 ) );
+    summary->min    = (int16_t)( data[4] | ( data[5] << 8 ) );
+    summary->max    = (int16_t)( data[6] | ( data[7] << 8 ) );
+    summary->mean   = (int16_t)( data[8] | ( data[9] << 8 ) );
+}
+
+/*******************************************************************************
+ Function name: spi_report_config_pack
+
+ Function Description:
+ @brief    Writes a report configuration in its wire format, the fields in
+           order of declaration.
+
+ @param   *config   configuration
+ @param   *data     REPORT_CONFIG_WIRE_SIZE bytes
+
+ @return void
+ ******************************************************************************/
+
+void spi_report_config_pack( const report_config *config, uint8_t *data )
+{
+    data[0] = (uint8_t)config->threshold;
+    data[1] = (uint8_t)( config->threshold >> 8 );
+    data[2] = (uint8_t)config->hysteresis;
+    data[3] = (uint8_t)( config->hysteresis >> 8 );
+}
+
+/*******************************************************************************
+ Function name: spi_report_config_unpack
+
+ Function Description:
+ @brief    Reads a report configuration from its wire format.
+
+ @param   *config   configuration
+ @param   *data     REPORT_CONFIG_WIRE_SIZE bytes
+
+ @return void
+ ******************************************************************************/
+
+void spi_report_config_unpack( report_config *config, const uint8_t *data )
+{
+    config->threshold  = (uint16_t)( data[0] | ( data[1] << 8 ) );
+    config->hysteresis = (uint16_t)( data[2] | ( data[3] << 8 ) );
+}
+
+/*******************************************************************************
+ Function name: spi_slave_time_pack
+
+ Function Description:
+ @brief    Writes a slave time in its wire format, the fields in order of
+           declaration.
+
+ @param   *time     slave time
+ @param   *data     SLAVE_TIME_WIRE_SIZE bytes
+
+ @return void
+ ******************************************************************************/
+
+void spi_slave_time_pack( const slave_time *time, uint8_t *data )
+{
+    data[0] = (uint8_t)time->ms;
+    data[1] = (uint8_t)( time->ms >> 8 );
+    data[2] = (uint8_t)( time->ms >> 16 );
+    data[3] = (uint8_t)( time->ms >> 24 );
+    data[4] = (uint8_t)time->us;
+    data[5] = (uint8_t)( time->us >> 8 );
+}
+
+/*******************************************************************************
+ Function name: spi_slave_time_unpack
+
+ Function Description:
+ @brief    Reads a slave time from its wire format.
+
+ @param   *time     slave time
+ @param   *data     SLAVE_TIME_WIRE_SIZE bytes
+
+ @return void
+ ******************************************************************************/
+
+void spi_slave_time_unpack( slave_time *time, const uint8_t *data )
+{
+    time->ms = (uint32_t)data[0] | ( (uint32_t)data[1] << 8 ) |
+               ( (uint32_t)data[2] << 16 ) | ( (uint32_t)data[3] << 24 );
+    time->us = (uint16_t)( data[4] | ( data[5] << 8 ) );
+}
+
+/*******************************************************************************
+ Function name: spi_timed_samples_pack
+
+ Function Description:
+ @brief    Writes samples and the times they were taken in the format of the
+           timed burst read. Packing stops before a sample taken too long
+           after the one before it for the 16 bit gap.
+
+ @param   *samples  samples, oldest first
+ @param   *times_ms slave time of each sample in milliseconds
+ @param   count     number of samples
+ @param   *data     TIMED_SAMPLES_HEADER_SIZE bytes and
+                    TIMED_SAMPLE_WIRE_SIZE bytes per sample
+ @param   *packed   number of samples written
+
+ @return uint32_t  bytes written, 0 if there are no samples
+ ******************************************************************************/
+
+uint32_t spi_timed_samples_pack( const int16_t *samples, const uint32_t *times_ms,
+                                 uint32_t count, uint8_t *data,
+                                 uint32_t *packed )
+{
+    uint8_t  *p = data;
+    uint32_t  gap;
+    uint32_t  i;
+
+    *packed = 0;
+    if ( 0 == count )
+    {
+        return 0;
+    }
+    *p++ = (uint8_t)times_ms[0];
+    *p++ = (uint8_t)( times_ms[0] >> 8 );
+    *p++ = (uint8_t)( times_ms[0] >> 16 );
+    *p++ = (uint8_t)( times_ms[0] >> 24 );
+    for ( i = 0; i < count; i++ )
+    {
+        gap = i ? ( times_ms[i] - times_ms[i - 1] ) : 0;
+        if ( gap > 0xFFFF )
+        {
+            break;
+        }
+        *p++ = (uint8_t)samples[i];
+        *p++ = (uint8_t)( (uint16_t)samples[i] >> 8 );
+        *p++ = (uint8_t)gap;
+        *p++ = (uint8_t)( gap >> 8 );
+    }
+    *packed = i;
+    return (uint32_t)( p - data );
+}
+
+/*******************************************************************************
+ Function name: spi_timed_samples_unpack
+
+ Function Description:
+ @brief    Reads samples and the times they were taken from the format of
+           the timed burst read.
+
+ @param   *data        record data
+ @param   length       bytes of record data, 0 for no samples
+ @param   *samples     samples, oldest first
+ @param   *times_ms    slave time of each sample in milliseconds
+ @param   max_samples  capacity of samples and times_ms
+ @param   *count       number of samples read
+
+ @return wiced_bool_t  WICED_FALSE if the data is malformed or holds more
+                       than max_samples samples
+ ******************************************************************************/
+
+wiced_bool_t spi_timed_samples_unpack( const uint8_t *data, uint32_t length,
+                                       int16_t *samples, uint32_t *times_ms,
+                                       uint32_t max_samples, uint32_t *count )
+{
+    uint32_t time_ms;
+    uint32_t i;
+
+    *count = 0;
+    if ( 0 == length )
+    {
+        return WICED_TRUE;
+    }
+    if ( ( length < TIMED_SAMPLES_HEADER_SIZE + TIMED_SAMPLE_WIRE_SIZE ) ||
+         ( ( length - TIMED_SAMPLES_HEADER_SIZE ) % TIMED_SAMPLE_WIRE_SIZE ) ||
+         ( ( length - TIMED_SAMPLES_HEADER_SIZE ) / TIMED_SAMPLE_WIRE_SIZE > max_samples ) )
+    {
+        return WICED_FALSE;
+    }
+    time_ms = (uint32_t)data[0] | ( (uint32_t)data[1] << 8 ) |
+              ( (uint32_t)data[2] << 16 ) | ( (uint32_t)data[3] << 24 );
+    data += TIMED_SAMPLES_HEADER_SIZE;
+    for ( i = 0; i < ( length - TIMED_SAMPLES_HEADER_SIZE ) / TIMED_SAMPLE_WIRE_SIZE; i++ )
+    {
+        time_ms    += (uint32_t)( data[2] | ( data[3] << 8 ) );
+        samples[i]  = (int16_t)( data[0] | ( data[1] << 8 ) );
+        times_ms[i] = time_ms;
+        data       += TIMED_SAMPLE_WIRE_SIZE;
+    }
+    *count = i;
+    return WICED_TRUE;
+}
+
+/*******************************************************************************
+ Function name: spi_adc_scan_pack
+
+ Function Description:
+ @brief    Writes the channels of an ADC scan selected by a mask in the
+           format of the scan reply, as many as fit.
+
+ @param   *scan     ADC scan
+ @param   mask      bit n selects ADC input n, 0 selects every channel
+ @param   *data     buffer for the reply data
+ @param   size      size of data
+
+ @return uint32_t  bytes written, 0 if not even the time fits
+ ******************************************************************************/
+
+uint32_t spi_adc_scan_pack( const adc_scan *scan, uint32_t mask,
+                            uint8_t *data, uint32_t size )
+{
+    uint8_t  *p = data;
+    uint32_t  i;
+
+    if ( size < ADC_SCAN_HEADER_SIZE )
+    {
+        return 0;
+    }
+    *p++ = (uint8_t)scan->time_ms;
+    *p++ = (uint8_t)( scan->time_ms >> 8 );
+    *p++ = (uint8_t)( scan->time_ms >> 16 );
+    *p++ = (uint8_t)( scan->time_ms >> 24 );
+    for ( i = 0; i < scan->count; i++ )
+    {
+        if ( mask && ( ( scan->channel[i] >= 32 ) ||
+                       !( mask & ( 1u << scan->channel[i] ) ) ) )
+        {
+            continue;
+        }
+        if ( (uint32_t)( p - data ) + ADC_SCAN_CHANNEL_WIRE_SIZE > size )
+        {
+            break;
+        }
+        *p++ = scan->channel[i];
+        *p++ = (uint8_t)scan->mv[i];
+        *p++ = (uint8_t)( scan->mv[i] >> 8 );
+    }
+    return (uint32_t)( p - data );
+}
+
+/*******************************************************************************
+ Function name: spi_adc_scan_unpack
+
+ Function Description:
+ @brief    Reads an ADC scan from the format of the scan reply.
+
+ @param   *scan     ADC scan
+ @param   *data     reply data
+ @param   length    bytes of reply data
+
+ @return wiced_bool_t  WICED_FALSE if the data is malformed or holds more
+                       than ADC_SCAN_MAX_CHANNELS channels
+ ******************************************************************************/
+
+wiced_bool_t spi_adc_scan_unpack( adc_scan *scan, const uint8_t *data,
+                                  uint32_t length )
+{
+    uint32_t i;
+
+    if ( ( length < ADC_SCAN_HEADER_SIZE ) ||
+         ( ( length - ADC_SCAN_HEADER_SIZE ) % ADC_SCAN_CHANNEL_WIRE_SIZE ) ||
+         ( ( length - ADC_SCAN_HEADER_SIZE ) / ADC_SCAN_CHANNEL_WIRE_SIZE >
+           ADC_SCAN_MAX_CHANNELS ) )
+    {
+        return WICED_FALSE;
+    }
+    scan->time_ms = (uint32_t)data[0] | ( (uint32_t)data[1] << 8 ) |
+                    ( (uint32_t)data[2] << 16 ) | ( (uint32_t)data[3] << 24 );
+    scan->count   = (uint8_t)( ( length - ADC_SCAN_HEADER_SIZE ) / ADC_SCAN_CHANNEL_WIRE_SIZE );
+    data += ADC_SCAN_HEADER_SIZE;
+    for ( i = 0; i < scan->count; i++ )
+    {
+        scan->channel[i] = data[0];
+        scan->mv[i]      = (uint16_t)( data[1] | ( data[2] << 8 ) );
+        data            += ADC_SCAN_CHANNEL_WIRE_SIZE;
+    }
+    return WICED_TRUE;
+}
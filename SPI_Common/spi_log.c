@@ -0,0 +1,142 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file spi_log.c
+ *
+ * @brief
+ * Deferred binary trace log of spi_log.h.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include "spi_log.h"
+#include "wiced_bt_trace.h"
+#include "wiced_timer.h"
+
+/******************************************************************************
+ *                                Variables Definitions
+ ******************************************************************************/
+
+#if ( SPI_LOG_DEFERRED )
+/* Ring of entries. head and tail count entries written and flushed and only
+ * ever grow; an entry lives at its count modulo SPI_LOG_SIZE.*/
+static spi_log_entry spi_log_ring[SPI_LOG_SIZE];
+static uint32_t      spi_log_head;
+static uint32_t      spi_log_tail;
+/* Entries dropped since the last flush*/
+static uint32_t      spi_log_lost;
+#else
+#define SPI_LOG_FORMAT( id, format )          format,
+
+static const char * const spi_log_formats[SPI_LOG_EVENT_COUNT] =
+{
+    SPI_LOG_EVENTS( SPI_LOG_FORMAT )
+};
+#endif
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ Function name: spi_log_write
+
+ Function Description:
+ @brief    Logs an event. Deferred, this copies the event into the ring and
+           returns; an event that does not fit is counted and dropped.
+
+ @param   event  event id
+ @param   a      first argument of the event format
+ @param   b      second argument of the event format
+
+ @return void
+ ******************************************************************************/
+
+void spi_log_write( spi_log_event event, int16_t a, int32_t b )
+{
+#if ( SPI_LOG_DEFERRED )
+    spi_log_entry *entry;
+
+    if ( spi_log_head - spi_log_tail >= SPI_LOG_SIZE )
+    {
+        spi_log_lost++;
+        return;
+    }
+    entry = &spi_log_ring[spi_log_head & ( SPI_LOG_SIZE - 1 )];
+    entry->time_us = (uint32_t)clock_SystemTimeMicroseconds64();
+    entry->event   = (uint16_t)event;
+    entry->a       = a;
+    entry->b       = b;
+    spi_log_head++;
+#else
+    WICED_BT_TRACE(spi_log_formats[event], a, b);
+#endif
+}
+
+/*******************************************************************************
+ Function name: spi_log_flush
+
+ Function Description:
+ @brief    Prints the entries of the ring on the trace output, oldest first,
+           then the number of entries lost. Called by the SPI thread when it
+           is idle.
+
+ @param   void
+
+ @return void
+ ******************************************************************************/
+
+void spi_log_flush( void )
+{
+#if ( SPI_LOG_DEFERRED )
+    const spi_log_entry *entry;
+
+    while ( spi_log_tail != spi_log_head )
+    {
+        entry = &spi_log_ring[spi_log_tail & ( SPI_LOG_SIZE - 1 )];
+        WICED_BT_TRACE(SPI_LOG_MARKER " %x %x %x %x\n\r", entry->time_us,
+                       entry->event, (uint16_t)entry->a, entry->b);
+        spi_log_tail++;
+    }
+    if ( spi_log_lost )
+    {
+        /* The count goes in the 16 bit argument, saturated*/
+        WICED_BT_TRACE(SPI_LOG_MARKER " %x %x %x %x\n\r",
+                       (uint32_t)clock_SystemTimeMicroseconds64(), SPI_LOG_LOST,
+                       ( spi_log_lost > 0x7FFF ) ? 0x7FFF : spi_log_lost, 0);
+        spi_log_lost = 0;
+    }
+#endif
+}
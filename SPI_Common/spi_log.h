@@ -0,0 +1,156 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file spi_log.h
+ *
+ * @brief
+ * Deferred binary trace log of the SPI master and SPI slave.
+ *
+ * Formatting and printing a trace line takes far longer than an SPI
+ * transaction, so the transaction path does not call WICED_BT_TRACE. It
+ * writes an entry of an event id, two arguments and a timestamp into a ring
+ * with spi_log_write(), which only copies a few words. The application calls
+ * spi_log_flush() when it is idle, which prints each entry as a short line of
+ * hex fields,
+ *
+ *     #L <time us> <event> <a> <b>
+ *
+ * that the host decoder (Host_Simulator/spi_log_decode.c) turns back into
+ * text with the formats of SPI_LOG_EVENTS. When the ring is full new entries
+ * are dropped and counted, and the flush reports how many were lost.
+ *
+ * The ring has a single producer and a single consumer, both the SPI thread
+ * of the application, so it needs no locking. Building with
+ * SPI_LOG_DEFERRED=0 prints every event as it happens instead.
+ ******************************************************************************/
+
+#ifndef SPI_LOG_H
+#define SPI_LOG_H
+
+#include "wiced.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+/* 1: log entries are kept in the ring and printed by spi_log_flush(),
+ * 0: they are printed by spi_log_write()*/
+#ifndef SPI_LOG_DEFERRED
+#define SPI_LOG_DEFERRED                      (1)
+#endif
+
+/* Entries of the ring, a power of two*/
+#ifndef SPI_LOG_SIZE
+#define SPI_LOG_SIZE                          (64)
+#endif
+
+#if ( SPI_LOG_SIZE & ( SPI_LOG_SIZE - 1 ) )
+#error "SPI_LOG_SIZE must be a power of two"
+#endif
+
+/* Marker starting each flushed entry on the trace output*/
+#define SPI_LOG_MARKER                        "#L"
+
+/* Events of the log: X(id, format). The format takes the two arguments of
+ * the entry in order, a then b, and may use fewer of them. New events go at
+ * the end so that logs keep decoding with an older decoder.*/
+#define SPI_LOG_EVENTS(X) \
+    X( SPI_LOG_LOST,            "%d log entries lost\n\r" ) \
+    X( SPI_LOG_SENDING,         "Sending data to slave\n\r" ) \
+    X( SPI_LOG_RECEIVING,       "Receiving data from slave\n\r" ) \
+    X( SPI_LOG_NO_MANUFACTURER, "Failed to get manufacturer ID\n\r" ) \
+    X( SPI_LOG_TEMPERATURE,     "Temperature Value %d.%02d \n\r" ) \
+    X( SPI_LOG_UNSUPPORTED,     "Unsupported command %x\n\r" ) \
+    X( SPI_LOG_FRAME_INVALID,   "Invalid frame received\n\r" ) \
+    X( SPI_LOG_FRAME_DAMAGED,   "Damaged frame received\n\r" ) \
+    X( SPI_LOG_FRAME_NAK,       "Frame not acknowledged\n\r" ) \
+    X( SPI_LOG_RECEIVE_FAILED,  "Receive failed\n\r" ) \
+    X( SPI_LOG_DROPPING,        "Dropping data of an incomplete transaction\n\r" ) \
+    X( SPI_LOG_COMMAND,         "Received Command:\t\t\t\t %x\n\r" ) \
+    X( SPI_LOG_INVALID_COMMAND, "Invalid Command:\t\t\t\t %x\n\r" ) \
+    X( SPI_LOG_SENT_NUMBER,     "Sent Number:\t\t\t\t\t %hx\n\r" ) \
+    X( SPI_LOG_FRAME_LENGTH,    "Invalid frame length:\t\t\t %d\n\r" ) \
+    X( SPI_LOG_FRAME_TIMEOUT,   "Frame payload timeout\n\r" ) \
+    X( SPI_LOG_FRAME_CRC,       "Frame CRC error\n\r" ) \
+    X( SPI_LOG_REPEATED,        "Repeated request, resending reply\n\r" ) \
+    X( SPI_LOG_SENT_FRAME,      "Sent Frame:\t\t\t\t\t %d bytes\n\r" ) \
+    X( SPI_LOG_SENT_NAK,        "Sent NAK\n\r" ) \
+    X( SPI_LOG_SAMPLES,         "Received Command:\t\t\t\t %x (%d samples)\n\r" ) \
+    X( SPI_LOG_SAMPLED,         "Temperature (in degree Celsius) \t\t%d.%02d \n\r" ) \
+    X( SPI_LOG_SUMMARY,         "Summary window %hu, %d readings\n\r" ) \
+    X( SPI_LOG_SUMMARY_MIN,     "Temperature min %d.%02d \n\r" ) \
+    X( SPI_LOG_SUMMARY_MAX,     "Temperature max %d.%02d \n\r" ) \
+    X( SPI_LOG_SUMMARY_MEAN,    "Temperature mean %d.%02d \n\r" ) \
+    X( SPI_LOG_SUMMARY_MISSED,  "Summary windows missed: %d\n\r" ) \
+    X( SPI_LOG_CHANGE_SIGNALED, "Signaled temperature change %d.%02d \n\r" ) \
+    X( SPI_LOG_RESETTING,       "Resetting SPI interface\n\r" ) \
+    X( SPI_LOG_REGISTERS_READ,  "Registers read from %02x:\t\t\t %d bytes\n\r" ) \
+    X( SPI_LOG_REGISTERS_WROTE, "Registers written from %02x:\t\t %d bytes\n\r" ) \
+    X( SPI_LOG_SAMPLES_DROPPED, "Sensor dropped %d samples\n\r" ) \
+    X( SPI_LOG_CLOCK_SYNC,      "Clock synced within %d us, offset %d ms\n\r" ) \
+    X( SPI_LOG_ADC_CHANNEL,     "ADC channel %d: %d mV\n\r" )
+
+/******************************************************************************
+ *                                Enumerations
+ ******************************************************************************/
+
+#define SPI_LOG_EVENT_ID( id, format )        id,
+
+typedef enum
+{
+    SPI_LOG_EVENTS( SPI_LOG_EVENT_ID )
+    SPI_LOG_EVENT_COUNT
+}spi_log_event;
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+/* Entry of the ring, 12 bytes*/
+typedef struct
+{
+    uint32_t time_us;
+    uint16_t event;
+    int16_t  a;
+    int32_t  b;
+}spi_log_entry;
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+void                spi_log_write( spi_log_event event, int16_t a, int32_t b );
+void                spi_log_flush( void );
+
+#endif /* SPI_LOG_H */
@@ -0,0 +1,105 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+/*******************************************************************************
+ * @file spi_pool.c
+ *
+ * @brief
+ * Fixed block pools, see spi_pool.h.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include "spi_pool.h"
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ Function name: spi_pool_take
+
+ Function Description:
+ @brief    Takes the free block of a pool with the lowest index.
+
+ @param   *pool  pool to take the block from
+
+ @return void*  the block, NULL if every block is taken
+ ******************************************************************************/
+
+void *spi_pool_take( spi_pool *pool )
+{
+    uint32_t index = 0;
+
+    if ( 0 == pool->free )
+    {
+        pool->failures++;
+        return NULL;
+    }
+    while ( !( pool->free & ( 1u << index ) ) )
+    {
+        index++;
+    }
+    pool->free &= ~( 1u << index );
+    pool->used++;
+    if ( pool->used > pool->peak )
+    {
+        pool->peak = pool->used;
+    }
+    return &pool->blocks[index * pool->block_size];
+}
+
+/*******************************************************************************
+ Function name: spi_pool_give
+
+ Function Description:
+ @brief    Gives a block taken with spi_pool_take() back to its pool.
+
+ @param   *pool   pool the block was taken from
+ @param   *block  block to give back, NULL is ignored
+
+ @return void
+ ******************************************************************************/
+
+void spi_pool_give( spi_pool *pool, void *block )
+{
+    uint32_t index;
+
+    if ( NULL == block )
+    {
+        return;
+    }
+    index = (uint32_t)( ( (uint8_t *)block - pool->blocks ) / pool->block_size );
+    pool->free |= 1u << index;
+    pool->used--;
+}
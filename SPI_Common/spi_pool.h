@@ -0,0 +1,106 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+/*******************************************************************************
+ * @file spi_pool.h
+ *
+ * @brief
+ * Fixed block pools for the buffers of the SPI applications.
+ *
+ * A pool is a static array of blocks of one type, sized at compile time
+ * with SPI_POOL_DEFINE(), and a bit mask of the free blocks. Taking and
+ * giving back a block costs a few instructions and never touches the heap,
+ * so buffers that must not live on a thread stack, such as frames, come
+ * from a pool on the transaction path. The storage shows in the static RAM
+ * of the application under the name of the pool.
+ *
+ * A pool does no locking; a pool used by more than one thread is guarded by
+ * its owner.
+ ******************************************************************************/
+
+#ifndef SPI_POOL_H
+#define SPI_POOL_H
+
+#include "wiced.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+/* Most blocks of a pool, one bit of the free mask each*/
+#define SPI_POOL_MAX_BLOCKS                   (32)
+
+/* Defines the static pool name of number blocks of type. The size check
+ * fails to compile for pools of more than SPI_POOL_MAX_BLOCKS blocks.*/
+#define SPI_POOL_DEFINE( name, type, number )                                  \
+    typedef char name##_size_check[( ( number ) >= 1 ) &&                      \
+                                   ( ( number ) <= SPI_POOL_MAX_BLOCKS ) ? 1 : -1]; \
+    static type  name##_blocks[number];                                        \
+    static spi_pool name =                                                     \
+    {                                                                          \
+        .blocks     = (uint8_t *)name##_blocks,                                \
+        .block_size = sizeof( type ),                                          \
+        .count      = ( number ),                                              \
+        .free       = (uint32_t)( ( 2ull << ( ( number ) - 1 ) ) - 1 )          \
+    }
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+/* Pool of equally sized blocks
+ * blocks:     storage of the blocks.
+ * block_size: size of a block.
+ * count:      number of blocks.
+ * free:       bit n is set while block n is free.
+ * used:       blocks taken.
+ * peak:       most blocks ever taken at once.
+ * failures:   takes that found no free block.*/
+typedef struct
+{
+    uint8_t    *blocks;
+    uint32_t    block_size;
+    uint32_t    count;
+    uint32_t    free;
+    uint32_t    used;
+    uint32_t    peak;
+    uint32_t    failures;
+}spi_pool;
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+void               *spi_pool_take( spi_pool *pool );
+void                spi_pool_give( spi_pool *pool, void *block );
+
+#endif /* SPI_POOL_H */
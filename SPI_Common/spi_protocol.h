@@ -0,0 +1,343 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file spi_protocol.h
+ *
+ * @brief
+ * Definitions shared by the SPI master and SPI slave applications.
+ *
+ * Two packet formats share the bus:
+ *
+ * - data_packet: one 16 bit command or response followed by PACKET_HEADER,
+ *   one per chip select window.
+ *
+ * - Pipelined packets: a data_packet carrying PIPELINE_HEADER instead. The
+ *   slave loads the response right after the command and the master clocks
+ *   it in during the next chip select window, while clocking out the next
+ *   command. The response carries PIPELINE_HEADER as well.
+ *
+ * - Frames: a frame_header with the same size and layout as data_packet, but
+ *   carrying FRAME_HEADER, a sequence number and the number of payload bytes
+ *   that follow. The payload is a list of records, each a command code, a
+ *   data length and the data, and is followed by a CRC-16 over the header
+ *   and the payload. A request frame carries several commands in one chip
+ *   select window and the slave answers all of them in one reply frame with
+ *   the same sequence number, one record per command in request order.
+ *
+ *   A reply without records (a NAK) asks the master to send the request
+ *   again. The slave keeps its last reply, so a request sent again with the
+ *   same sequence number and CRC gets the same reply without executing the
+ *   commands twice. When a reply is lost midway, the master clocks out
+ *   FRAME_MAX_SIZE bytes of SPI_IDLE_BYTE to empty the slave's TX FIFO
+ *   before sending again; the slave discards received data starting with
+ *   SPI_IDLE_BYTE.
+ *
+ * Commands that return a list of values, such as the burst read of buffered
+ * temperature samples, are only available in frames. Their request record
+ * carries the largest number of values wanted as a single byte. The packed
+ * burst read returns the same samples delta encoded (spi_delta.h) behind one
+ * byte counting the samples still buffered, saturated at 255, so that a
+ * block of slowly changing temperatures takes about one byte per sample.
+ * The statistics command, which returns the spi_stats of the slave, and
+ * the summary command, which returns the temperature_summary of the last
+ * complete summary window of the slave, are only available in frames as
+ * well.
+ *
+ * The report command, also frames only, carries a report_config and returns
+ * the latest reading. From then on the slave pulses its data ready line
+ * while the reading has moved by the configured threshold from the one
+ * returned, outside of any transaction, so that the master only has to poll
+ * when the temperature changes.
+ *
+ * The register commands, frames only, address the register map of the slave
+ * instead of a fixed command per value. A read request record carries a
+ * start address and a byte count, a write request record a start address
+ * followed by the bytes to write; both move on to the next register after
+ * every two bytes, so a single record reads or writes a block of registers.
+ * Reading on into the sample window at REG_SAMPLES returns buffered samples,
+ * oldest first, and ends early once none is left, so one burst read from
+ * REG_REPORT_THRESHOLD returns the configuration, the status and as many
+ * samples as the reply has room for. A write is answered by a record without
+ * data. Reads of unmapped registers and writes of read only registers are
+ * answered with RECORD_ERROR and nothing is written.
+ *
+ * The timed burst read, frames only, returns buffered samples together with
+ * the time the slave took them on its own clock: the time of the first
+ * sample in milliseconds, then each sample followed by the milliseconds
+ * since the sample before it, 0 for the first. A gap too long for 16 bits
+ * ends the record; the samples after it come with the next read. The time
+ * command returns a slave_time, the current time of the same clock, so that
+ * the master can work out the offset between the two clocks from the time
+ * it sent the request and received the reply.
+ *
+ * The scan command, frames only, returns the last adc_scan of the slave,
+ * which reads a list of ADC channels together in the background, so that
+ * several analog inputs come back in one record. Its request record may
+ * carry a 32 bit mask with a bit per ADC_INPUT_CHANNEL_SEL to select
+ * channels; without it every channel scanned is returned. The reply carries
+ * the slave time of the scan in milliseconds, then each channel as its
+ * ADC input and its voltage in millivolts, 16 bits, as far as the reply has
+ * room. Before the first scan it is an empty record.
+ *
+ * The slave tells the two formats apart by the header field of the first four
+ * bytes it receives. All multi-byte fields are little endian.
+ ******************************************************************************/
+
+#ifndef SPI_PROTOCOL_H
+#define SPI_PROTOCOL_H
+
+#include "wiced.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+/* Header for SPI data packet ensures the SPI sensor connections are intact*/
+#define PACKET_HEADER                         (0xC819)
+/* Header of a pipelined data packet*/
+#define PIPELINE_HEADER                       (0xC81B)
+/* Header of a frame, see frame_header*/
+#define FRAME_HEADER                          (0xC81A)
+
+/* Manufacturer ID denoting Cypress Semiconductor*/
+#define MANUFACTURER_ID                       (0x000A)
+/* Unit ID denoting temperature is in Celsius scale*/
+#define UNIT_ID                               (0x000B)
+/* Version of this protocol, part of the sensor descriptor*/
+#define SPI_PROTOCOL_VERSION                  (0x0001)
+
+/* Largest frame, header and CRC included. A whole reply frame is loaded into
+ * the slave TX FIFO at once, so this must not exceed the FIFO size.*/
+#define FRAME_MAX_SIZE                        (64)
+#define FRAME_CRC_SIZE                        (2)
+#define FRAME_MAX_PAYLOAD                     (FRAME_MAX_SIZE - sizeof(frame_header) - FRAME_CRC_SIZE)
+
+/* Initial value of spi_crc16()*/
+#define SPI_CRC16_INIT                        (0xFFFF)
+
+/* Byte clocked out to resynchronize; never the first byte of a request*/
+#define SPI_IDLE_BYTE                         (0xFF)
+/* Header field read from a slave that has nothing to send*/
+#define SPI_IDLE_HEADER                       ((SPI_IDLE_BYTE << 8) | SPI_IDLE_BYTE)
+
+/* Most 16 bit samples a single reply record can carry*/
+#define SAMPLES_MAX_PER_RECORD                ((FRAME_MAX_PAYLOAD - sizeof(frame_record)) / sizeof(int16_t))
+
+/* Most samples a packed burst read can return in a single reply record, at
+ * one byte each behind the count of samples still buffered*/
+#define PACKED_SAMPLES_MAX                    (FRAME_MAX_PAYLOAD - sizeof(frame_record) - 1)
+
+/* Set in the command code of a reply record when the command was not
+ * understood; such records carry no data*/
+#define RECORD_ERROR                          (0x80)
+
+/* Size of a temperature_summary on the wire, five 16 bit fields*/
+#define SUMMARY_WIRE_SIZE                     (10)
+
+/* Size of a report_config on the wire, two 16 bit fields*/
+#define REPORT_CONFIG_WIRE_SIZE               (4)
+
+/* Size of a slave_time on the wire, a 32 and a 16 bit field*/
+#define SLAVE_TIME_WIRE_SIZE                  (6)
+
+/* Timed burst read: the slave time of the first sample, then per sample the
+ * 16 bit temperature and the 16 bit milliseconds since the sample before*/
+#define TIMED_SAMPLES_HEADER_SIZE             (4)
+#define TIMED_SAMPLE_WIRE_SIZE                (4)
+#define TIMED_SAMPLES_MAX_PER_RECORD          ((FRAME_MAX_PAYLOAD - sizeof(frame_record) - \
+                                                TIMED_SAMPLES_HEADER_SIZE) / TIMED_SAMPLE_WIRE_SIZE)
+
+/* Most channels of an adc_scan*/
+#define ADC_SCAN_MAX_CHANNELS                 (16)
+/* Scan reply: the slave time of the scan, then per channel the ADC input and
+ * the voltage*/
+#define ADC_SCAN_HEADER_SIZE                  (4)
+#define ADC_SCAN_CHANNEL_WIRE_SIZE            (3)
+/* Size of the channel mask of a scan request*/
+#define ADC_SCAN_MASK_WIRE_SIZE               (4)
+
+/* Register map of the slave: byte addresses of 16 bit registers, which must
+ * be read and written at even addresses and in whole registers
+ * REG_MANUFACTURER .. REG_SIGNATURE:   the sensor descriptor and its
+ *                                      signature, read only.
+ * REG_REPORT_THRESHOLD, _HYSTERESIS:   the report_config of change reporting,
+ *                                      writing sets it up as the report
+ *                                      command does.
+ * REG_TEMPERATURE:                     latest reading, read only.
+ * REG_SAMPLES_PENDING, _DROPPED:       samples buffered, and samples lost to
+ *                                      a full buffer modulo 2^16, read only.
+ * REG_SAMPLES:                         start of the sample window, which
+ *                                      runs to the end of the address space;
+ *                                      new registers go in front of it.*/
+#define REG_MANUFACTURER                      (0x00)
+#define REG_UNIT                              (0x02)
+#define REG_VERSION                           (0x04)
+#define REG_SIGNATURE                         (0x06)
+#define REG_REPORT_THRESHOLD                  (0x08)
+#define REG_REPORT_HYSTERESIS                 (0x0A)
+#define REG_TEMPERATURE                       (0x0C)
+#define REG_SAMPLES_PENDING                   (0x0E)
+#define REG_SAMPLES_DROPPED                   (0x10)
+#define REG_SAMPLES                           (0x12)
+
+/* Size of the request record of a register read: start address and number
+ * of bytes*/
+#define REGISTER_READ_WIRE_SIZE               (2)
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+/* Sensor descriptor: what the master learns about a sensor when detecting
+ * it. The sensor answers the descriptor command with the signature of its
+ * descriptor, see spi_descriptor_signature(), so the master can check in one
+ * exchange that it still talks to the sensor it detected.*/
+typedef struct
+{
+    uint16_t manufacturer;
+    uint16_t unit;
+    uint16_t version;
+}sensor_descriptor;
+
+/* Summary of the filtered temperature readings of one summary window of the
+ * slave, temperatures in hundredths of a degree Celsius
+ * window:   number of the window, counting up from 0 and wrapping; the
+ *           master tells a new window from one it has read already
+ * count:    readings in the window
+ * min, max, mean: of those readings*/
+typedef struct
+{
+    uint16_t window;
+    uint16_t count;
+    int16_t  min;
+    int16_t  max;
+    int16_t  mean;
+}temperature_summary;
+
+/* Change reporting requested with the report command, temperatures in
+ * hundredths of a degree Celsius
+ * threshold:  change from the last reading returned by the report command
+ *             that the slave signals; 0 stops signaling
+ * hysteresis: added to the threshold when the temperature turns back against
+ *             the last signaled change, so noise around a level that was just
+ *             reached is not signaled again*/
+typedef struct
+{
+    uint16_t threshold;
+    uint16_t hysteresis;
+}report_config;
+
+/* Time of the slave clock, which starts at 0 when the slave starts
+ * ms:       milliseconds, wrapping after 49 days
+ * us:       microseconds into that millisecond, 0 to 999*/
+typedef struct
+{
+    uint32_t ms;
+    uint16_t us;
+}slave_time;
+
+/* ADC channels read together by the slave
+ * time_ms:  slave time of the scan, see slave_time
+ * count:    number of channels
+ * channel:  ADC input of each channel, an ADC_INPUT_CHANNEL_SEL
+ * mv:       voltage of each channel in millivolts*/
+typedef struct
+{
+    uint32_t time_ms;
+    uint8_t  count;
+    uint8_t  channel[ADC_SCAN_MAX_CHANNELS];
+    uint16_t mv[ADC_SCAN_MAX_CHANNELS];
+}adc_scan;
+
+/* Frame header
+ * length:   number of payload bytes following the header, CRC excluded
+ * seq:      sequence number of the request, echoed in the reply
+ * header:   FRAME_HEADER*/
+typedef struct
+{
+    uint8_t  length;
+    uint8_t  seq;
+    uint16_t header;
+}frame_header;
+
+/* Record within a frame payload*/
+typedef struct
+{
+    uint8_t  cmd;
+    uint8_t  length;
+    uint8_t  data[];
+}frame_record;
+
+/* Frame as transferred on the bus; the CRC directly follows the payload*/
+typedef struct
+{
+    frame_header hdr;
+    uint8_t      payload[FRAME_MAX_SIZE - sizeof(frame_header)];
+}spi_frame;
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+void                spi_frame_init( spi_frame *frame );
+wiced_bool_t        spi_frame_add( spi_frame *frame, uint8_t cmd,
+                                   uint8_t length, const void *data );
+void                spi_frame_seal( spi_frame *frame, uint8_t seq );
+uint32_t            spi_frame_size( const spi_frame *frame );
+uint16_t            spi_frame_crc( const spi_frame *frame );
+wiced_bool_t        spi_frame_header_valid( const frame_header *hdr );
+wiced_bool_t        spi_frame_crc_valid( const spi_frame *frame );
+const frame_record *spi_frame_next( const spi_frame *frame, uint32_t *offset );
+int16_t             spi_record_int16( const frame_record *record );
+void                spi_summary_pack( const temperature_summary *summary, uint8_t *data );
+void                spi_summary_unpack( temperature_summary *summary, const uint8_t *data );
+void                spi_report_config_pack( const report_config *config, uint8_t *data );
+void                spi_report_config_unpack( report_config *config, const uint8_t *data );
+void                spi_slave_time_pack( const slave_time *time, uint8_t *data );
+void                spi_slave_time_unpack( slave_time *time, const uint8_t *data );
+uint32_t            spi_timed_samples_pack( const int16_t *samples, const uint32_t *times_ms,
+                                            uint32_t count, uint8_t *data,
+                                            uint32_t *packed );
+wiced_bool_t        spi_timed_samples_unpack( const uint8_t *data, uint32_t length,
+                                              int16_t *samples, uint32_t *times_ms,
+                                              uint32_t max_samples, uint32_t *count );
+uint32_t            spi_adc_scan_pack( const adc_scan *scan, uint32_t mask,
+                                       uint8_t *data, uint32_t size );
+wiced_bool_t        spi_adc_scan_unpack( adc_scan *scan, const uint8_t *data,
+                                         uint32_t length );
+
+uint16_t            spi_crc16( uint16_t crc, const void *data, uint32_t length );
+uint16_t            spi_descriptor_signature( const sensor_descriptor *descriptor );
+
+#endif /* SPI_PROTOCOL_H */
@@ -0,0 +1,111 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+/*******************************************************************************
+ * @file spi_stack.c
+ *
+ * @brief
+ * Stack high water mark by painting, see spi_stack.h.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include "spi_stack.h"
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ Function name: spi_stack_paint
+
+ Function Description:
+ @brief    Fills the stack of the calling thread below the caller with
+           SPI_STACK_PATTERN. Called first thing in the thread function.
+           Paints nothing on a stack no larger than the reserve and the
+           margin together.
+
+ @param   *stack  painted stack
+ @param   size    stack size the thread was created with
+
+ @return void
+ ******************************************************************************/
+
+void spi_stack_paint( spi_stack *stack, uint32_t size )
+{
+    volatile uint8_t here = 0;
+    volatile uint8_t *fill;
+    uintptr_t        top = (uintptr_t)&here;
+
+    stack->size   = size;
+    stack->bottom = 0;
+    if ( size <= SPI_STACK_ENTRY_RESERVE + SPI_STACK_PAINT_MARGIN )
+    {
+        /* Nothing to paint; the stack reads as full*/
+        return;
+    }
+    stack->bottom = top + SPI_STACK_ENTRY_RESERVE - size;
+    for ( fill = (volatile uint8_t *)stack->bottom;
+          (uintptr_t)fill < top - SPI_STACK_PAINT_MARGIN;
+          fill++ )
+    {
+        *fill = SPI_STACK_PATTERN;
+    }
+}
+
+/*******************************************************************************
+ Function name: spi_stack_used
+
+ Function Description:
+ @brief    Finds the most stack the thread has used since it was painted.
+
+ @param   *stack  stack painted by the thread
+
+ @return uint32_t  bytes used at most, the stack size if all of it was
+ ******************************************************************************/
+
+uint32_t spi_stack_used( const spi_stack *stack )
+{
+    const volatile uint8_t *scan = (const volatile uint8_t *)stack->bottom;
+    uint32_t               untouched = 0;
+
+    if ( 0 == stack->bottom )
+    {
+        return stack->size;
+    }
+    while ( ( untouched < stack->size ) && ( SPI_STACK_PATTERN == scan[untouched] ) )
+    {
+        untouched++;
+    }
+    return stack->size - untouched;
+}
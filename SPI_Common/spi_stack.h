@@ -0,0 +1,99 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+/*******************************************************************************
+ * @file spi_stack.h
+ *
+ * @brief
+ * Stack high water mark of the SPI threads.
+ *
+ * The stack a thread needs is found by painting: at its start the thread
+ * calls spi_stack_paint(), which fills the part of its stack below the
+ * caller with SPI_STACK_PATTERN. Every byte the thread uses later
+ * overwrites the pattern, so spi_stack_used() finds the deepest use by
+ * scanning up from the bottom of the stack for the first byte changed.
+ * Stacks are taken to grow downwards, as they do on the ARM cores and on the
+ * host.
+ *
+ * The thread is given a stack size only, by wiced_rtos_init_thread(), and
+ * where its stack starts is not known to it. The stack is taken to start
+ * SPI_STACK_ENTRY_RESERVE bytes above the frame of spi_stack_paint(), so its
+ * bottom is taken that far above the frame less the stack size. The reserve
+ * is an upper bound of what the RTOS thread entry and the thread function
+ * put on the stack before the call: a reserve too large leaves the lowest
+ * bytes of the stack unpainted, a reserve too small would paint below the
+ * stack. The unpainted bytes and the reserve count as used, so the high
+ * water mark errs on the high side; a stack used into them reads as full.
+ ******************************************************************************/
+
+#ifndef SPI_STACK_H
+#define SPI_STACK_H
+
+#include "wiced.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+/* Fill of the unused stack*/
+#define SPI_STACK_PATTERN                     (0xA5)
+
+/* Most stack in use above spi_stack_paint() when the thread calls it*/
+#ifndef SPI_STACK_ENTRY_RESERVE
+#define SPI_STACK_ENTRY_RESERVE               (256)
+#endif
+
+/* Stack left unpainted directly below spi_stack_paint(), which its own
+ * locals and calls may still use*/
+#define SPI_STACK_PAINT_MARGIN                (64)
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+/* Painted stack of a thread
+ * bottom: lowest address of the stack.
+ * size:   size of the stack.*/
+typedef struct
+{
+    uintptr_t   bottom;
+    uint32_t    size;
+}spi_stack;
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+void                spi_stack_paint( spi_stack *stack, uint32_t size );
+uint32_t            spi_stack_used( const spi_stack *stack );
+
+#endif /* SPI_STACK_H */
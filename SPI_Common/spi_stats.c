@@ -0,0 +1,172 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file spi_stats.c
+ *
+ * @brief
+ * Transaction statistics of spi_stats.h: latency histogram, wire format and
+ * trace dump.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include "spi_stats.h"
+#include "wiced_bt_trace.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+/* Number of 32 bit fields of spi_stats*/
+#define SPI_STATS_FIELDS                      (sizeof(spi_stats) / sizeof(uint32_t))
+
+#if ( SPI_STATS_BUCKETS != 8 )
+#error "spi_stats_dump() prints eight latency buckets"
+#endif
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ Function name: spi_stats_add_transaction
+
+ Function Description:
+ @brief    Counts a transaction and sorts its latency into the histogram.
+
+ @param   *stats      statistics to update
+ @param   latency_us  time the transaction took
+
+ @return void
+ ******************************************************************************/
+
+void spi_stats_add_transaction( spi_stats *stats, uint32_t latency_us )
+{
+    uint32_t bucket = 0;
+    uint32_t bound  = SPI_STATS_BUCKET_US;
+
+    while ( ( bucket < SPI_STATS_BUCKETS - 1 ) && ( latency_us >= bound ) )
+    {
+        bucket++;
+        bound <<= 1;
+    }
+    stats->transactions++;
+    stats->latency[bucket]++;
+    if ( latency_us > stats->max_us )
+    {
+        stats->max_us = latency_us;
+    }
+}
+
+/*******************************************************************************
+ Function name: spi_stats_pack
+
+ Function Description:
+ @brief    Writes statistics in their wire format.
+
+ @param   *stats  statistics
+ @param   *data   SPI_STATS_WIRE_SIZE bytes
+
+ @return void
+ ******************************************************************************/
+
+void spi_stats_pack( const spi_stats *stats, uint8_t *data )
+{
+    const uint32_t *field = (const uint32_t *)stats;
+    uint32_t i;
+
+    for ( i = 0; i < SPI_STATS_FIELDS; i++ )
+    {
+        *data++ = (uint8_t)field[i];
+        *data++ = (uint8_t)( field[i] >> 8 );
+        *data++ = (uint8_t)( field[i] >> 16 );
+        *data++ = (uint8_t)( field[i] >> 24 );
+    }
+}
+
+/*******************************************************************************
+ Function name: spi_stats_unpack
+
+ Function Description:
+ @brief    Reads statistics from their wire format.
+
+ @param   *stats  statistics
+ @param   *data   SPI_STATS_WIRE_SIZE bytes
+
+ @return void
+ ******************************************************************************/
+
+void spi_stats_unpack( spi_stats *stats, const uint8_t *data )
+{
+    uint32_t *field = (uint32_t *)stats;
+    uint32_t i;
+
+    for ( i = 0; i < SPI_STATS_FIELDS; i++, data += sizeof( uint32_t ) )
+    {
+        field[i] = data[0] | ( data[1] << 8 ) | ( data[2] << 16 ) |
+                   ( (uint32_t)data[3] << 24 );
+    }
+}
+
+/*******************************************************************************
+ Function name: spi_stats_dump
+
+ Function Description:
+ @brief    Prints statistics on the trace output, one line of counters and
+           one line of latency buckets, each bucket labelled with its upper
+           bound in microseconds.
+
+ @param   *name   side the statistics belong to
+ @param   *stats  statistics
+
+ @return void
+ ******************************************************************************/
+
+void spi_stats_dump( const char *name, const spi_stats *stats )
+{
+    const uint32_t *n = stats->latency;
+
+    WICED_BT_TRACE("%s: %d transactions, %d retries, %d resets, %d invalid, "
+                   "%d underruns, max %d us\n\r",
+                   name, stats->transactions, stats->retries, stats->resets,
+                   stats->invalid, stats->underruns, stats->max_us);
+    /* One trace call per line*/
+    WICED_BT_TRACE("%s latency: <%d us %d, <%d %d, <%d %d, <%d %d, <%d %d, "
+                   "<%d %d, <%d %d, more %d\n\r", name,
+                   SPI_STATS_BUCKET_US,      n[0], SPI_STATS_BUCKET_US << 1, n[1],
+                   SPI_STATS_BUCKET_US << 2, n[2], SPI_STATS_BUCKET_US << 3, n[3],
+                   SPI_STATS_BUCKET_US << 4, n[4], SPI_STATS_BUCKET_US << 5, n[5],
+                   SPI_STATS_BUCKET_US << 6, n[6], n[7]);
+}
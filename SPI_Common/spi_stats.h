@@ -0,0 +1,101 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file spi_stats.h
+ *
+ * @brief
+ * Transaction statistics kept by the SPI master and SPI slave.
+ *
+ * Each side counts its transactions, retries, interface resets, invalid
+ * requests or replies and FIFO underruns, and sorts the time each
+ * transaction took into a histogram of SPI_STATS_BUCKETS buckets whose
+ * bounds double from SPI_STATS_BUCKET_US. The counters only ever grow, so a
+ * rate is the difference between two dumps. The master reads the statistics
+ * of the slave with the statistics command and dumps both sides together.
+ ******************************************************************************/
+
+#ifndef SPI_STATS_H
+#define SPI_STATS_H
+
+#include "wiced.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+/* Latency buckets: bucket 0 holds transactions shorter than
+ * SPI_STATS_BUCKET_US, each further bucket twice that bound, and the last
+ * bucket everything longer*/
+#define SPI_STATS_BUCKETS                     (8)
+#define SPI_STATS_BUCKET_US                   (128)
+
+/* Size of the statistics on the wire, all fields little endian 32 bit*/
+#define SPI_STATS_WIRE_SIZE                   (sizeof(spi_stats))
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+/* Statistics of one side of the link
+ * transactions: chip select windows carrying a request.
+ * retries:      requests sent again (master) or answered again from the
+ *               last reply (slave).
+ * resets:       resets of the pSPI interface.
+ * invalid:      replies (master) or requests and commands (slave) that were
+ *               damaged or not understood.
+ * underruns:    replies the slave had not loaded in time, which the master
+ *               reads as SPI_IDLE_BYTE.
+ * max_us:       longest transaction.
+ * latency:      transactions per latency bucket.*/
+typedef struct
+{
+    uint32_t transactions;
+    uint32_t retries;
+    uint32_t resets;
+    uint32_t invalid;
+    uint32_t underruns;
+    uint32_t max_us;
+    uint32_t latency[SPI_STATS_BUCKETS];
+}spi_stats;
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+void                spi_stats_add_transaction( spi_stats *stats, uint32_t latency_us );
+void                spi_stats_pack( const spi_stats *stats, uint8_t *data );
+void                spi_stats_unpack( spi_stats *stats, const uint8_t *data );
+void                spi_stats_dump( const char *name, const spi_stats *stats );
+
+#endif /* SPI_STATS_H */
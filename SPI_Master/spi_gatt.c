@@ -0,0 +1,534 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+/*******************************************************************************
+ * @file spi_gatt.c
+ *
+ * @brief
+ * GATT temperature service of spi_gatt.h.
+ *
+ * The SPI thread queues the readings with spi_gatt_publish(); the GATT
+ * callback and the notification timer run on the application thread, which
+ * owns the connection state. Only the queue is shared between the two and
+ * guarded by a mutex. When the queue is full the oldest reading makes room,
+ * so the interval and SPI_GATT_QUEUE_SIZE should be chosen for the queue to
+ * hold the readings of one interval.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include <string.h>
+
+#include "spi_gatt.h"
+#include "wiced_bt_ble.h"
+#include "wiced_bt_trace.h"
+#include "wiced_rtos.h"
+#include "wiced_timer.h"
+
+#if ( SPI_GATT_NOTIFICATIONS )
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+/* Readings queued for the client, a power of 2*/
+#ifndef SPI_GATT_QUEUE_SIZE
+#define SPI_GATT_QUEUE_SIZE                   (64)
+#endif
+#if ( SPI_GATT_QUEUE_SIZE & ( SPI_GATT_QUEUE_SIZE - 1 ) )
+#error "SPI_GATT_QUEUE_SIZE must be a power of 2"
+#endif
+
+/* Time between two rounds of notifications until the client sets one*/
+#ifndef SPI_GATT_NOTIFY_INTERVAL_MS
+#define SPI_GATT_NOTIFY_INTERVAL_MS           (5000)
+#endif
+#if ( SPI_GATT_NOTIFY_INTERVAL_MS < SPI_GATT_INTERVAL_MIN_MS ) || \
+    ( SPI_GATT_NOTIFY_INTERVAL_MS > SPI_GATT_INTERVAL_MAX_MS )
+#error "SPI_GATT_NOTIFY_INTERVAL_MS out of range"
+#endif
+
+#define SPI_GATT_NOTIFY_MAX_SIZE              (SPI_GATT_MAX_MTU - GATT_NOTIFICATION_HEADER_SIZE)
+
+/* Largest gap between two readings of one notification*/
+#define SPI_GATT_MAX_DELTA_MS                 (0xFFFF)
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+/* A queued reading*/
+typedef struct
+{
+    uint32_t    time_ms;
+    int16_t     temperature;
+    uint8_t     sensor;
+}spi_gatt_sample;
+
+/******************************************************************************
+ *                                Variables Definitions
+ ******************************************************************************/
+
+static const uint8_t gatt_database[] =
+{
+    PRIMARY_SERVICE_UUID128(HDLS_TEMPERATURE_SERVICE, SPI_GATT_UUID_SERVICE),
+
+    CHARACTERISTIC_UUID128(HDLC_TEMPERATURE_SAMPLES,
+                           HDLC_TEMPERATURE_SAMPLES_VALUE,
+                           SPI_GATT_UUID_SAMPLES,
+                           GATTDB_CHAR_PROP_NOTIFY,
+                           GATTDB_PERM_NONE),
+    CHAR_DESCRIPTOR_UUID16_WRITABLE(HDLD_TEMPERATURE_SAMPLES_CLIENT_CONFIG,
+                                    GATT_UUID_CHAR_CLIENT_CONFIG,
+                                    GATTDB_PERM_READABLE | GATTDB_PERM_WRITE_REQ),
+
+    CHARACTERISTIC_UUID128_WRITABLE(HDLC_TEMPERATURE_INTERVAL,
+                                    HDLC_TEMPERATURE_INTERVAL_VALUE,
+                                    SPI_GATT_UUID_INTERVAL,
+                                    GATTDB_CHAR_PROP_READ | GATTDB_CHAR_PROP_WRITE,
+                                    GATTDB_PERM_READABLE | GATTDB_PERM_WRITE_REQ),
+};
+
+static uint8_t advert_flags = BTM_BLE_GENERAL_DISCOVERABLE_FLAG | BTM_BLE_BREDR_NOT_SUPPORTED;
+static uint8_t advert_service[] = { SPI_GATT_UUID_SERVICE };
+
+/* Ring of readings. head and tail count readings queued and sent and only
+ * ever grow; a reading lives at its count modulo SPI_GATT_QUEUE_SIZE.*/
+static spi_gatt_sample   gatt_queue[SPI_GATT_QUEUE_SIZE];
+static uint32_t          gatt_head;
+static uint32_t          gatt_tail;
+static wiced_mutex_t    *gatt_lock;
+
+/* Connection state, application thread only; conn_id is 0 when not
+ * connected*/
+static uint16_t          gatt_conn_id;
+static uint16_t          gatt_mtu = GATT_DEF_BLE_MTU_SIZE;
+static uint16_t          gatt_client_config;
+static uint16_t          gatt_interval_ms = SPI_GATT_NOTIFY_INTERVAL_MS;
+static wiced_timer_t     gatt_notify_timer;
+static uint8_t           gatt_notification[SPI_GATT_NOTIFY_MAX_SIZE];
+
+/* Counters for spi_gatt_stats*/
+static uint32_t          gatt_notifications;
+static uint32_t          gatt_samples_sent;
+static uint32_t          gatt_overwritten;
+static uint32_t          gatt_send_failures;
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+static wiced_bt_gatt_status_t spi_gatt_cback(wiced_bt_gatt_evt_t event,
+                                             wiced_bt_gatt_event_data_t *p_event_data);
+static wiced_bt_gatt_status_t spi_gatt_read(wiced_bt_gatt_read_t *p_read);
+static wiced_bt_gatt_status_t spi_gatt_write(wiced_bt_gatt_write_t *p_write);
+static void spi_gatt_advertise(void);
+static void spi_gatt_schedule(void);
+static void spi_gatt_notify(TIMER_PARAM_TYPE arg);
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ Function name:  spi_gatt_init
+
+ Function Description:
+ @brief    Registers the temperature service with the stack and starts
+           advertising it. Called once the stack is enabled and before the
+           SPI thread publishes readings.
+
+ @param    void
+
+ @return   void
+ ******************************************************************************/
+
+void spi_gatt_init(void)
+{
+    gatt_lock = wiced_rtos_create_mutex();
+    wiced_rtos_init_mutex(gatt_lock);
+    wiced_init_timer(&gatt_notify_timer, spi_gatt_notify, 0,
+                     WICED_MILLI_SECONDS_PERIODIC_TIMER);
+
+    if((WICED_BT_GATT_SUCCESS != wiced_bt_gatt_register(spi_gatt_cback)) ||
+       (WICED_BT_GATT_SUCCESS != wiced_bt_gatt_db_init(gatt_database,
+                                                       sizeof(gatt_database))))
+    {
+        WICED_BT_TRACE("GATT database initialization failed \n\r");
+        return;
+    }
+    spi_gatt_advertise();
+}
+
+/*******************************************************************************
+ Function name:  spi_gatt_publish
+
+ Function Description:
+ @brief    Queues a reading for the next round of notifications. The oldest
+           queued reading is dropped when the queue is full.
+
+ @param    sensor       index of the sensor in the sensor table
+ @param    temperature  reading in hundredths of a degree Celsius
+ @param    time_ms      time of the reading on the master clock
+
+ @return   void
+ ******************************************************************************/
+
+void spi_gatt_publish(uint8_t sensor, int16_t temperature, uint32_t time_ms)
+{
+    spi_gatt_sample *sample;
+
+    if(NULL == gatt_lock)
+    {
+        return;
+    }
+    wiced_rtos_lock_mutex(gatt_lock);
+    if(gatt_head - gatt_tail >= SPI_GATT_QUEUE_SIZE)
+    {
+        gatt_tail++;
+        gatt_overwritten++;
+    }
+    sample = &gatt_queue[gatt_head & (SPI_GATT_QUEUE_SIZE - 1)];
+    sample->time_ms = time_ms;
+    sample->temperature = temperature;
+    sample->sensor = sensor;
+    gatt_head++;
+    wiced_rtos_unlock_mutex(gatt_lock);
+}
+
+/*******************************************************************************
+ Function name:  spi_gatt_stats
+
+ Function Description:
+ @brief    Dumps the counters of the notifications.
+
+ @param    void
+
+ @return   void
+ ******************************************************************************/
+
+void spi_gatt_stats(void)
+{
+    WICED_BT_TRACE("GATT: %d notifications, %d readings sent, %d overwritten, "
+                   "%d send failures\n\r",
+                   (int)gatt_notifications, (int)gatt_samples_sent,
+                   (int)gatt_overwritten, (int)gatt_send_failures);
+}
+
+/*******************************************************************************
+ Function name:  spi_gatt_cback
+
+ Function Description:
+ @brief    GATT event handler: tracks the connection and serves the attribute
+           requests of the client.
+
+ @param    event          GATT event code
+ @param    *p_event_data  event data
+
+ @return   wiced_bt_gatt_status_t  status returned to the stack
+ ******************************************************************************/
+
+static wiced_bt_gatt_status_t spi_gatt_cback(wiced_bt_gatt_evt_t event,
+                                             wiced_bt_gatt_event_data_t *p_event_data)
+{
+    wiced_bt_gatt_connection_status_t *p_status;
+    wiced_bt_gatt_attribute_request_t *p_request;
+
+    switch(event)
+    {
+    case GATT_CONNECTION_STATUS_EVT:
+        p_status = &p_event_data->connection_status;
+        if(p_status->connected)
+        {
+            WICED_BT_TRACE("GATT connected, conn_id %d\n\r", p_status->conn_id);
+            gatt_conn_id = p_status->conn_id;
+            gatt_mtu = GATT_DEF_BLE_MTU_SIZE;
+        }
+        else
+        {
+            WICED_BT_TRACE("GATT disconnected, reason %d\n\r", p_status->reason);
+            gatt_conn_id = 0;
+            /* Notifications are configured again on the next connection*/
+            gatt_client_config = GATT_CLIENT_CONFIG_NONE;
+            spi_gatt_schedule();
+            spi_gatt_advertise();
+        }
+        return WICED_BT_GATT_SUCCESS;
+
+    case GATT_ATTRIBUTE_REQUEST_EVT:
+        p_request = &p_event_data->attribute_request;
+        switch(p_request->request_type)
+        {
+        case GATTS_REQ_TYPE_READ:
+            return spi_gatt_read(&p_request->data.read_req);
+
+        case GATTS_REQ_TYPE_WRITE:
+            return spi_gatt_write(&p_request->data.write_req);
+
+        case GATTS_REQ_TYPE_MTU:
+            gatt_mtu = MIN(p_request->data.mtu, SPI_GATT_MAX_MTU);
+            return WICED_BT_GATT_SUCCESS;
+
+        case GATTS_REQ_TYPE_CONF:
+            return WICED_BT_GATT_SUCCESS;
+
+        default:
+            return WICED_BT_GATT_INVALID_PDU;
+        }
+
+    default:
+        return WICED_BT_GATT_SUCCESS;
+    }
+}
+
+/*******************************************************************************
+ Function name:  spi_gatt_read
+
+ Function Description:
+ @brief    Serves a read of the client configuration or the interval.
+
+ @param    *p_read  read request
+
+ @return   wiced_bt_gatt_status_t  status of the read
+ ******************************************************************************/
+
+static wiced_bt_gatt_status_t spi_gatt_read(wiced_bt_gatt_read_t *p_read)
+{
+    uint8_t value[sizeof(uint16_t)];
+
+    switch(p_read->handle)
+    {
+    case HDLD_TEMPERATURE_SAMPLES_CLIENT_CONFIG:
+        value[0] = LO_UINT16(gatt_client_config);
+        value[1] = HI_UINT16(gatt_client_config);
+        break;
+
+    case HDLC_TEMPERATURE_INTERVAL_VALUE:
+        value[0] = LO_UINT16(gatt_interval_ms);
+        value[1] = HI_UINT16(gatt_interval_ms);
+        break;
+
+    default:
+        return WICED_BT_GATT_INVALID_HANDLE;
+    }
+    if(p_read->offset > sizeof(value))
+    {
+        return WICED_BT_GATT_INVALID_OFFSET;
+    }
+    *p_read->p_val_len = MIN(*p_read->p_val_len, sizeof(value) - p_read->offset);
+    memcpy(p_read->p_val, &value[p_read->offset], *p_read->p_val_len);
+    return WICED_BT_GATT_SUCCESS;
+}
+
+/*******************************************************************************
+ Function name:  spi_gatt_write
+
+ Function Description:
+ @brief    Serves a write of the client configuration or the interval and
+           starts, stops or restarts the notifications accordingly.
+
+ @param    *p_write  write request
+
+ @return   wiced_bt_gatt_status_t  status of the write
+ ******************************************************************************/
+
+static wiced_bt_gatt_status_t spi_gatt_write(wiced_bt_gatt_write_t *p_write)
+{
+    uint16_t value;
+
+    if((p_write->offset != 0) || (p_write->val_len != sizeof(uint16_t)))
+    {
+        return WICED_BT_GATT_INVALID_ATTR_LEN;
+    }
+    value = (uint16_t)(p_write->p_val[0] | (p_write->p_val[1] << 8));
+
+    switch(p_write->handle)
+    {
+    case HDLD_TEMPERATURE_SAMPLES_CLIENT_CONFIG:
+        gatt_client_config = value;
+        break;
+
+    case HDLC_TEMPERATURE_INTERVAL_VALUE:
+        if((value < SPI_GATT_INTERVAL_MIN_MS) || (value > SPI_GATT_INTERVAL_MAX_MS))
+        {
+            return WICED_BT_GATT_OUT_OF_RANGE;
+        }
+        gatt_interval_ms = value;
+        break;
+
+    default:
+        return WICED_BT_GATT_WRITE_NOT_PERMIT;
+    }
+    spi_gatt_schedule();
+    return WICED_BT_GATT_SUCCESS;
+}
+
+/*******************************************************************************
+ Function name:  spi_gatt_advertise
+
+ Function Description:
+ @brief    Starts connectable advertisements of the temperature service.
+
+ @param    void
+
+ @return   void
+ ******************************************************************************/
+
+static void spi_gatt_advertise(void)
+{
+    wiced_bt_ble_advert_elem_t advert[2];
+
+    advert[0].advert_type = BTM_BLE_ADVERT_TYPE_FLAG;
+    advert[0].len = sizeof(advert_flags);
+    advert[0].p_data = &advert_flags;
+    advert[1].advert_type = BTM_BLE_ADVERT_TYPE_128SRV_COMPLETE;
+    advert[1].len = sizeof(advert_service);
+    advert[1].p_data = advert_service;
+
+    wiced_bt_ble_set_raw_advertisement_data(2, advert);
+    if(WICED_BT_SUCCESS != wiced_bt_start_advertisements(BTM_BLE_ADVERT_UNDIRECTED_LOW,
+                                                         BLE_ADDR_PUBLIC, NULL))
+    {
+        WICED_BT_TRACE("Failed to start advertisements \n\r");
+    }
+}
+
+/*******************************************************************************
+ Function name:  spi_gatt_schedule
+
+ Function Description:
+ @brief    Runs the notification timer at the current interval while a client
+           has notifications enabled and stops it otherwise, so the timer
+           wakes the device only when there is someone to notify.
+
+ @param    void
+
+ @return   void
+ ******************************************************************************/
+
+static void spi_gatt_schedule(void)
+{
+    if(gatt_conn_id && (gatt_client_config & GATT_CLIENT_CONFIG_NOTIFICATION))
+    {
+        wiced_start_timer(&gatt_notify_timer, gatt_interval_ms);
+    }
+    else if(wiced_is_timer_in_use(&gatt_notify_timer))
+    {
+        wiced_stop_timer(&gatt_notify_timer);
+    }
+}
+
+/*******************************************************************************
+ Function name:  spi_gatt_notify
+
+ Function Description:
+ @brief    Notification timer: sends the queued readings, as many per
+           notification as the MTU takes. Readings that the stack does not
+           take stay queued for the next round. Each notification is built
+           under gatt_lock and sent without it, so spi_gatt_publish never
+           waits on the stack.
+
+ @param    arg  unused
+
+ @return   void
+ ******************************************************************************/
+
+static void spi_gatt_notify(TIMER_PARAM_TYPE arg)
+{
+    const spi_gatt_sample *sample;
+    uint32_t room;
+    uint32_t start;
+    uint32_t index;
+    uint32_t prev_ms;
+    uint32_t delta_ms;
+    uint8_t *p;
+
+    (void)arg;
+    room = MIN(gatt_mtu - GATT_NOTIFICATION_HEADER_SIZE, SPI_GATT_NOTIFY_MAX_SIZE);
+
+    while(gatt_conn_id)
+    {
+        wiced_rtos_lock_mutex(gatt_lock);
+        if(gatt_tail == gatt_head)
+        {
+            wiced_rtos_unlock_mutex(gatt_lock);
+            break;
+        }
+        start = gatt_tail;
+        sample = &gatt_queue[start & (SPI_GATT_QUEUE_SIZE - 1)];
+        prev_ms = sample->time_ms;
+        p = gatt_notification;
+        *p++ = (uint8_t)prev_ms;
+        *p++ = (uint8_t)(prev_ms >> 8);
+        *p++ = (uint8_t)(prev_ms >> 16);
+        *p++ = (uint8_t)(prev_ms >> 24);
+        for(index = start;
+            (index != gatt_head) &&
+            ((uint32_t)(p - gatt_notification) + SPI_GATT_SAMPLE_SIZE <= room);
+            index++)
+        {
+            sample = &gatt_queue[index & (SPI_GATT_QUEUE_SIZE - 1)];
+            delta_ms = sample->time_ms - prev_ms;
+            if(delta_ms > SPI_GATT_MAX_DELTA_MS)
+            {
+                /* The next notification starts from this reading*/
+                break;
+            }
+            prev_ms = sample->time_ms;
+            *p++ = sample->sensor;
+            *p++ = LO_UINT16(delta_ms);
+            *p++ = HI_UINT16(delta_ms);
+            *p++ = LO_UINT16(sample->temperature);
+            *p++ = HI_UINT16(sample->temperature);
+        }
+        wiced_rtos_unlock_mutex(gatt_lock);
+
+        if(WICED_BT_GATT_SUCCESS !=
+           wiced_bt_gatt_send_notification(gatt_conn_id, HDLC_TEMPERATURE_SAMPLES_VALUE,
+                                           (uint16_t)(p - gatt_notification),
+                                           gatt_notification))
+        {
+            gatt_send_failures++;
+            break;
+        }
+        wiced_rtos_lock_mutex(gatt_lock);
+        gatt_notifications++;
+        gatt_samples_sent += index - start;
+        /* Unless spi_gatt_publish overwrote past them while sending*/
+        if((int32_t)(index - gatt_tail) > 0)
+        {
+            gatt_tail = index;
+        }
+        wiced_rtos_unlock_mutex(gatt_lock);
+    }
+}
+#endif
@@ -0,0 +1,119 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+/*******************************************************************************
+ * @file spi_gatt.h
+ *
+ * @brief
+ * GATT temperature service of the SPI master.
+ *
+ * The master keeps the temperature readings of its sensors in a queue and
+ * sends them to a connected client in notifications of the samples
+ * characteristic, as many readings per notification as the ATT MTU takes,
+ * once per notification interval. Batching the readings this way keeps the
+ * radio asleep between intervals rather than waking it for every reading.
+ * The client sets the interval through the interval characteristic.
+ *
+ * A notification of the samples characteristic is the time of its first
+ * reading, uint32 in ms of the master clock, followed by one entry per
+ * reading, oldest first: the sensor index, uint8, the time since the
+ * previous reading, uint16 in ms, and the temperature, int16 in hundredths
+ * of a degree Celsius, all little endian. The time is the time the master
+ * received the reading. The interval characteristic is uint16 in ms.
+ ******************************************************************************/
+
+#ifndef SPI_GATT_H
+#define SPI_GATT_H
+
+#include "wiced.h"
+#include "wiced_bt_cfg.h"
+#include "wiced_bt_gatt.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+/* Publish the readings over GATT*/
+#ifndef SPI_GATT_NOTIFICATIONS
+#define SPI_GATT_NOTIFICATIONS                (1)
+#endif
+
+/* Largest ATT MTU accepted from the client; sizes the notification buffer
+ * and the MTU of the stack settings in wiced_bt_cfg.c*/
+#ifndef SPI_GATT_MAX_MTU
+#define SPI_GATT_MAX_MTU                      (185)
+#endif
+
+/* Service and characteristic UUIDs, least significant byte first*/
+#define SPI_GATT_UUID_SERVICE                 0x41, 0x8c, 0x5b, 0x2a, 0x0e, 0x3f, 0x3a, 0x9c, \
+                                              0x2e, 0x4d, 0x1e, 0x7b, 0x00, 0x1c, 0x6a, 0x5d
+#define SPI_GATT_UUID_SAMPLES                 0x41, 0x8c, 0x5b, 0x2a, 0x0e, 0x3f, 0x3a, 0x9c, \
+                                              0x2e, 0x4d, 0x1e, 0x7b, 0x01, 0x1c, 0x6a, 0x5d
+#define SPI_GATT_UUID_INTERVAL                0x41, 0x8c, 0x5b, 0x2a, 0x0e, 0x3f, 0x3a, 0x9c, \
+                                              0x2e, 0x4d, 0x1e, 0x7b, 0x02, 0x1c, 0x6a, 0x5d
+
+/* Notification of the samples characteristic: header and one reading*/
+#define SPI_GATT_NOTIFY_HEADER_SIZE           (4)
+#define SPI_GATT_SAMPLE_SIZE                  (5)
+
+/* Notification interval characteristic, in ms*/
+#define SPI_GATT_INTERVAL_MIN_MS              (100)
+#define SPI_GATT_INTERVAL_MAX_MS              (60000)
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+/* Attribute handles of the GATT database*/
+typedef enum
+{
+    HDLS_TEMPERATURE_SERVICE = 0x28,
+    HDLC_TEMPERATURE_SAMPLES,
+    HDLC_TEMPERATURE_SAMPLES_VALUE,
+    HDLD_TEMPERATURE_SAMPLES_CLIENT_CONFIG,
+    HDLC_TEMPERATURE_INTERVAL,
+    HDLC_TEMPERATURE_INTERVAL_VALUE
+}spi_gatt_handle;
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+/* Stack settings and buffer pools of wiced_bt_cfg.c*/
+extern const wiced_bt_cfg_settings_t wiced_bt_cfg_settings;
+extern const wiced_bt_cfg_buf_pool_t wiced_bt_cfg_buf_pools[];
+
+void                spi_gatt_init( void );
+void                spi_gatt_publish( uint8_t sensor, int16_t temperature, uint32_t time_ms );
+void                spi_gatt_stats( void );
+
+#endif /* SPI_GATT_H */
@@ -43,6 +43,9 @@
  * Features demonstrated:
  * - SPI WICED APIs
  * - WICED RTOS APIs
+ * - BLE GATT notifications of the temperature readings
+ * - Slave timestamps mapped onto the master clock
+ * - Several ADC channels of the slave read in the same frame
  *
  * Requirements and Usage:
  * Program 1 kit with the spi_master app and another kit with
@@ -58,12 +61,15 @@
  * MISO    WICED_P01    D12
  * MOSI    WICED_P04    D07
  * CS      WICED_P02    D06
+ * DRDY    WICED_P06    (input, driven by the slave; optional)
  * GND
  ******************************************************************************/
 
 /******************************************************************************
  *                                Includes
  ******************************************************************************/
+#include <string.h>
+
 #include "sparcommon.h"
 #include "wiced_bt_dev.h"
 #include "wiced_bt_trace.h"
@@ -72,8 +78,17 @@
 #include "wiced_hal_pspi.h"
 #include "wiced_hal_puart.h"
 #include "wiced_rtos.h"
+#include "wiced_timer.h"
 #include "wiced_bt_stack.h"
 #include "GeneratedSource/cycfg_pins.h"
+#include "spi_delta.h"
+#include "spi_gatt.h"
+#include "spi_log.h"
+#include "spi_master.h"
+#include "spi_pool.h"
+#include "spi_protocol.h"
+#include "spi_stack.h"
+#include "spi_stats.h"
 
 /******************************************************************************
  *                                Macros
@@ -81,22 +96,251 @@
 /* Threads defines */
 /* Sensible stack size for most threads*/
 #define THREAD_STACK_MIN_SIZE                 (1024)
+/* Stack of spi_sensor_thread, see the stack high water mark in the
+ * statistics dump*/
+#ifndef SPI_THREAD_STACK_SIZE
+#define SPI_THREAD_STACK_SIZE                 THREAD_STACK_MIN_SIZE
+#endif
 /* Defining thread priority levels*/
 #define PRIORITY_MEDIUM                       (5)
 
 #define DEFAULT_FREQUENCY                     (1000000u)
 
-/* Header for SPI data packet ensures the SPI sensor connections are intact*/
-#define PACKET_HEADER                         (0xC819)
-/* Manufacturer ID denoting Cypress Semiconductor*/
-#define MANUFACTURER_ID                       (0x000A)
-/* Unit ID denoting temperature is in Celsius scale*/
-#define UNIT_ID                               (0x000B)
 /* Master interrogates sensor every 1 s for temperature reading*/
+#ifndef SLEEP_TIMEOUT
 #define SLEEP_TIMEOUT                         (1000)
+#endif
 /* Delay between transmitting and receiving SPI messages from sensor, to prevent
- * reading earlier responses.*/
+ * reading earlier responses. With the data ready handshake this is only the
+ * upper bound the master waits for the slave before reading anyway.*/
 #define TX_RX_TIMEOUT                         (50)
+/* Interval at which SPI_DRDY is checked while waiting for the slave to get
+ * ready for a new command*/
+#define READY_POLL_INTERVAL_US                (10)
+
+/* Ways of knowing the slave has loaded its response
+ * SPI_HANDSHAKE_FIXED_DELAY: always wait TX_RX_TIMEOUT before reading.
+ * SPI_HANDSHAKE_READY_GPIO:  read as soon as the slave raises SPI_DRDY, falling
+ *                            back to TX_RX_TIMEOUT for slaves without it.*/
+#define SPI_HANDSHAKE_FIXED_DELAY             (0)
+#define SPI_HANDSHAKE_READY_GPIO              (1)
+#ifndef SPI_HANDSHAKE_MODE
+#define SPI_HANDSHAKE_MODE                    SPI_HANDSHAKE_READY_GPIO
+#endif
+
+/* Send the commands of all remaining states in one frame per chip select
+ * window instead of one data_packet per command, see spi_protocol.h*/
+#ifndef SPI_BATCHED_FRAMES
+#define SPI_BATCHED_FRAMES                    (1)
+#endif
+
+/* In packet mode, read temperatures with pipelined packets: each chip select
+ * window clocks out the next command while clocking in the response to the
+ * previous one, see spi_protocol.h*/
+#ifndef SPI_PIPELINED_TRANSFERS
+#define SPI_PIPELINED_TRANSFERS               (0)
+#endif
+#if ( SPI_PIPELINED_TRANSFERS && SPI_BATCHED_FRAMES )
+#error "SPI_PIPELINED_TRANSFERS requires SPI_BATCHED_FRAMES to be 0"
+#endif
+
+/* Times a frame is sent again right away when its reply is damaged or the
+ * slave asks for it again*/
+#define FRAME_RETRANSMITS                     (2)
+
+/* Frames of frame_pool: spi_sensor_thread makes one exchange at a time and
+ * takes a request and a reply frame for it*/
+#define SPI_FRAME_POOL_SIZE                   (2)
+
+/* Train the SPI clock once the sensor is detected: the clock is stepped up
+ * through link_clock_steps while probe frames get through, and settles on the
+ * last step whose error count stayed within LINK_MAX_PROBE_ERRORS. Damaged
+ * frames are only told apart by their CRC, so this needs frames.*/
+#ifndef SPI_LINK_TRAINING
+#define SPI_LINK_TRAINING                     SPI_BATCHED_FRAMES
+#endif
+#if ( SPI_LINK_TRAINING && !SPI_BATCHED_FRAMES )
+#error "SPI_LINK_TRAINING requires SPI_BATCHED_FRAMES"
+#endif
+/* Probe frames exchanged at each clock step*/
+#define LINK_PROBE_FRAMES                     (32)
+/* Probe frames that may fail at a clock step still considered good*/
+#define LINK_MAX_PROBE_ERRORS                 (1)
+/* The clock is trained again when LINK_RETRAIN_ERRORS of the last
+ * LINK_MONITOR_EXCHANGES exchanges needed a retransmit*/
+#define LINK_MONITOR_EXCHANGES                (64)
+#define LINK_RETRAIN_ERRORS                   (8)
+
+/* Keep the descriptor of a detected sensor; after a reset the master only
+ * checks that the sensor answering still has that descriptor instead of
+ * detecting it from scratch*/
+#ifndef SPI_DESCRIPTOR_CACHE
+#define SPI_DESCRIPTOR_CACHE                  (1)
+#endif
+
+/* Read buffered samples with the packed burst read, which delta encodes
+ * them, instead of two bytes per sample; frames only*/
+#ifndef SPI_PACKED_SAMPLES
+#define SPI_PACKED_SAMPLES                    SPI_BATCHED_FRAMES
+#endif
+#if ( SPI_PACKED_SAMPLES && !SPI_BATCHED_FRAMES )
+#error "SPI_PACKED_SAMPLES requires SPI_BATCHED_FRAMES"
+#endif
+
+/* Read the summary of each summary window of the sensor instead of every
+ * buffered reading, polling once per window; frames only. The sensor
+ * averages its readings and keeps min, max and mean per window, see
+ * temperature_sampler.h.*/
+#ifndef SPI_SUMMARY_READS
+#define SPI_SUMMARY_READS                     (0)
+#endif
+#if ( SPI_SUMMARY_READS && !SPI_BATCHED_FRAMES )
+#error "SPI_SUMMARY_READS requires SPI_BATCHED_FRAMES"
+#endif
+/* Poll period when reading summaries. A little shorter than the 5 s summary
+ * window of the sensor, so that with drifting clocks a window is now and
+ * then read twice, which is noticed from its number, rather than missed.*/
+#define SUMMARY_POLL_PERIOD_MS                (4500)
+
+#if ( SPI_SUMMARY_READS )
+#define SENSOR_POLL_PERIOD_MS                 SUMMARY_POLL_PERIOD_MS
+#else
+#define SENSOR_POLL_PERIOD_MS                 SLEEP_TIMEOUT
+#endif
+
+/* Read the temperature only when the sensor signals a change on its data
+ * ready line, and otherwise every SPI_REPORT_HEARTBEAT_MS to notice a sensor
+ * that went away; frames and the data ready handshake only. The sensor
+ * signals a reading that moved by REPORT_THRESHOLD from the one last read,
+ * see report_config.*/
+#ifndef SPI_CHANGE_REPORTING
+#define SPI_CHANGE_REPORTING                  (0)
+#endif
+#if ( SPI_CHANGE_REPORTING && ( !SPI_BATCHED_FRAMES || \
+      ( SPI_HANDSHAKE_MODE != SPI_HANDSHAKE_READY_GPIO ) ) )
+#error "SPI_CHANGE_REPORTING requires SPI_BATCHED_FRAMES and SPI_HANDSHAKE_READY_GPIO"
+#endif
+#if ( SPI_CHANGE_REPORTING && SPI_SUMMARY_READS )
+#error "SPI_CHANGE_REPORTING and SPI_SUMMARY_READS exclude each other"
+#endif
+
+/* Read the temperature with one register burst read, which returns the
+ * report configuration, the status registers and as many buffered samples
+ * as the reply has room for; frames only. The status tells how many samples
+ * are left and whether the sensor dropped any.*/
+#ifndef SPI_REGISTER_READS
+#define SPI_REGISTER_READS                    (0)
+#endif
+#if ( SPI_REGISTER_READS && !SPI_BATCHED_FRAMES )
+#error "SPI_REGISTER_READS requires SPI_BATCHED_FRAMES"
+#endif
+#if ( SPI_REGISTER_READS && ( SPI_SUMMARY_READS || SPI_CHANGE_REPORTING ) )
+#error "SPI_REGISTER_READS excludes SPI_SUMMARY_READS and SPI_CHANGE_REPORTING"
+#endif
+
+/* Read the temperature with the timed burst read, which returns with every
+ * buffered sample the time the sensor took it on its own clock, and report
+ * each sample at that time on the master clock; frames only. The offset
+ * between the clocks is measured with SPI_CLOCK_SYNC.*/
+#ifndef SPI_TIMED_SAMPLES
+#define SPI_TIMED_SAMPLES                     (0)
+#endif
+#if ( SPI_TIMED_SAMPLES && !SPI_BATCHED_FRAMES )
+#error "SPI_TIMED_SAMPLES requires SPI_BATCHED_FRAMES"
+#endif
+#if ( SPI_TIMED_SAMPLES && ( SPI_SUMMARY_READS || SPI_CHANGE_REPORTING || \
+                             SPI_REGISTER_READS ) )
+#error "SPI_TIMED_SAMPLES excludes SPI_SUMMARY_READS, SPI_CHANGE_REPORTING and SPI_REGISTER_READS"
+#endif
+
+/* Measure the offset between the master clock and the clock of each sensor
+ * once the sensor is detected and every SPI_CLOCK_SYNC_PERIOD_MS, which
+ * bounds the error clock drift adds between two measurements. Each
+ * measurement is the best of CLOCK_SYNC_EXCHANGES time commands: the one
+ * with the shortest round trip, half of which bounds its error; frames only.*/
+#ifndef SPI_CLOCK_SYNC
+#define SPI_CLOCK_SYNC                        SPI_TIMED_SAMPLES
+#endif
+#if ( SPI_CLOCK_SYNC && !SPI_BATCHED_FRAMES )
+#error "SPI_CLOCK_SYNC requires SPI_BATCHED_FRAMES"
+#endif
+#if ( SPI_TIMED_SAMPLES && !SPI_CLOCK_SYNC )
+#error "SPI_TIMED_SAMPLES requires SPI_CLOCK_SYNC"
+#endif
+#ifndef SPI_CLOCK_SYNC_PERIOD_MS
+#define SPI_CLOCK_SYNC_PERIOD_MS              (10000)
+#endif
+#define CLOCK_SYNC_EXCHANGES                  (4)
+
+/* Read the last ADC scan of the sensor, several analog channels at once,
+ * in the same frame as the temperature; frames only. SPI_ADC_SCAN_MASK
+ * selects channels with a bit per ADC_INPUT_CHANNEL_SEL, 0 asks for every
+ * channel the sensor scans. The temperature read leaves room in the reply
+ * for SPI_ADC_SCAN_CHANNELS channels; the sensor returns no more than fit.*/
+#ifndef SPI_ADC_SCAN
+#define SPI_ADC_SCAN                          (0)
+#endif
+#if ( SPI_ADC_SCAN && !SPI_BATCHED_FRAMES )
+#error "SPI_ADC_SCAN requires SPI_BATCHED_FRAMES"
+#endif
+#ifndef SPI_ADC_SCAN_MASK
+#define SPI_ADC_SCAN_MASK                     (0)
+#endif
+#ifndef SPI_ADC_SCAN_CHANNELS
+#define SPI_ADC_SCAN_CHANNELS                 (3)
+#endif
+/* Channels that leave the read of the detection frame, the largest batch,
+ * room for the register status and one sample: of the 58 byte payload, its
+ * three commands before the read take 12 bytes, the read record 2 + 12 and
+ * the scan record 6 + 3 per channel*/
+#define ADC_SCAN_BATCH_CHANNELS               (8)
+#if ( SPI_ADC_SCAN_CHANNELS < 1 ) || ( SPI_ADC_SCAN_CHANNELS > ADC_SCAN_BATCH_CHANNELS )
+#error "SPI_ADC_SCAN_CHANNELS must be 1 to ADC_SCAN_BATCH_CHANNELS"
+#endif
+#if ( SPI_ADC_SCAN )
+#define ADC_SCAN_REPLY_SIZE                   (sizeof(frame_record) + ADC_SCAN_HEADER_SIZE + \
+                                               SPI_ADC_SCAN_CHANNELS * ADC_SCAN_CHANNEL_WIRE_SIZE)
+#else
+#define ADC_SCAN_REPLY_SIZE                   (0)
+#endif
+
+/* Serve the register reads and writes other threads submit with
+ * spi_master_submit(), see spi_master.h; frames only*/
+#ifndef SPI_ASYNC_REQUESTS
+#define SPI_ASYNC_REQUESTS                    SPI_BATCHED_FRAMES
+#endif
+#if ( SPI_ASYNC_REQUESTS && !SPI_BATCHED_FRAMES )
+#error "SPI_ASYNC_REQUESTS requires SPI_BATCHED_FRAMES"
+#endif
+/* Requests of request_pool, for submitters that keep none of their own*/
+#ifndef SPI_REQUEST_POOL_SIZE
+#define SPI_REQUEST_POOL_SIZE                 (8)
+#endif
+
+/* Client threads started by the sample application, each reading the
+ * temperature register of the first sensor through spi_master_submit()
+ * every SPI_REQUEST_CLIENT_PERIOD_MS. The clients start together, so their
+ * reads meet and are coalesced.*/
+#ifndef SPI_REQUEST_CLIENTS
+#define SPI_REQUEST_CLIENTS                   (0)
+#endif
+#if ( SPI_REQUEST_CLIENTS && !SPI_ASYNC_REQUESTS )
+#error "SPI_REQUEST_CLIENTS requires SPI_ASYNC_REQUESTS"
+#endif
+#define SPI_REQUEST_CLIENT_PERIOD_MS          (1000)
+
+/* Change and hysteresis in hundredths of a degree Celsius*/
+#define REPORT_THRESHOLD                      (50)
+#define REPORT_HYSTERESIS                     (20)
+#ifndef SPI_REPORT_HEARTBEAT_MS
+#define SPI_REPORT_HEARTBEAT_MS               (30000)
+#endif
+
+/* Interval at which the statistics of every sensor, and with frames those
+ * kept by the sensor, are dumped on the trace output; 0 never dumps them*/
+#ifndef SPI_STATS_PERIOD_MS
+#define SPI_STATS_PERIOD_MS                   (60000)
+#endif
 
 /*To reset SPI master handling sensor when wrong data is sent repeatedly*/
 #define MAX_RETRIES                           (5)
@@ -109,6 +353,34 @@
 
 /* SPI Chip Select CS pin */
 #define SPI_CS                                WICED_P02
+/* Data ready pin, raised by the slave once its response is in the TX FIFO
+ * and lowered once it is ready for the next command */
+#define SPI_DRDY                              WICED_P06
+
+/* Number of sensors in spi_sensors, each on its own chip select and data
+ * ready pin. The pins of the second and third sensor are spare pins of the
+ * evaluation board; change them to match the wiring.*/
+#ifndef SPI_SENSOR_COUNT
+#define SPI_SENSOR_COUNT                      (1)
+#endif
+#if ( SPI_SENSOR_COUNT < 1 ) || ( SPI_SENSOR_COUNT > 3 )
+#error "SPI_SENSOR_COUNT must be 1 to 3, add pins for more sensors"
+#endif
+#define SPI_CS_2                              WICED_P10
+#define SPI_DRDY_2                            WICED_P11
+#define SPI_CS_3                              WICED_P12
+#define SPI_DRDY_3                            WICED_P13
+
+/* A sensor that keeps failing MAX_RETRIES polls after the interface reset
+ * is polled less and less often, at most this long apart, so it takes little
+ * bus time from the others*/
+#define SENSOR_MAX_BACKOFF_MS                 (8000)
+/* A failed poll is repeated this soon rather than a poll period later until
+ * the interface is reset; most faults are over by then, and the slave resets
+ * a stuck interface within a few chip select windows*/
+#ifndef SENSOR_RETRY_DELAY_MS
+#define SENSOR_RETRY_DELAY_MS                 (100)
+#endif
 
 #define SPI                                   SPI1
 
@@ -126,12 +398,43 @@ typedef struct
 /* Enumeration listing SPI sensor commands
  * GET_MANUFACTURER_ID: Command to get Manufacturer ID.
  * GET_UNIT: Command to get unit scale.
- * MEASURE_TEMPERATURE: Command to get temperature reading.*/
+ * MEASURE_TEMPERATURE: Command to get temperature reading.
+ * READ_SAMPLES: Command to get the temperature readings buffered by the
+ *               sensor since the last READ_SAMPLES, frames only.
+ * GET_DESCRIPTOR: Command to get the signature of the sensor descriptor.
+ * GET_STATS: Command to get the statistics kept by the sensor, frames only.
+ * GET_SUMMARY: Command to get the temperature summary of the last complete
+ *              summary window of the sensor, frames only.
+ * READ_PACKED_SAMPLES: READ_SAMPLES with the samples delta encoded, frames
+ *                      only.
+ * REPORT_TEMPERATURE: Command to get the latest temperature reading and have
+ *                     the sensor signal when it changes, frames only.
+ * READ_REGISTERS: Command to read a block of registers of the sensor and
+ *                 buffered samples, frames only.
+ * WRITE_REGISTERS: Command to write a block of registers of the sensor,
+ *                  frames only.
+ * READ_TIMED_SAMPLES: READ_SAMPLES with the time the sensor took each
+ *                     sample, frames only.
+ * GET_TIME: Command to get the time of the clock the sensor times its
+ *           samples with, frames only.
+ * READ_ADC_SCAN: Command to get the last scan of the ADC channels of the
+ *                sensor, frames only.*/
 typedef enum
 {
     GET_MANUFACTURER_ID = 0x01,
     GET_UNIT,
-    MEASURE_TEMPERATURE
+    MEASURE_TEMPERATURE,
+    READ_SAMPLES,
+    GET_DESCRIPTOR,
+    GET_STATS,
+    GET_SUMMARY,
+    READ_PACKED_SAMPLES,
+    REPORT_TEMPERATURE,
+    READ_REGISTERS,
+    WRITE_REGISTERS,
+    READ_TIMED_SAMPLES,
+    GET_TIME,
+    READ_ADC_SCAN
 }sensor_cmd;
 
 /* Enumeration listing SPI Master states
@@ -140,22 +443,242 @@ typedef enum
  *                verification.
  * GET_UNIT: Master checks for presence of SLAVE by verifying received packet
  *           header and obtains response to Unit ID on verification.
+ * READ_DESCRIPTOR: Master verifies the descriptor signature, which also
+ *                  covers the protocol version, and caches the descriptor.
  * GET_TEMPERATURE: Master checks for presence of SLAVE by verifying received
  *                  packet header and obtains response to Temperature reading on
- *                  verification.*/
+ *                  verification.
+ * SENSOR_REATTACH: After a reset, master checks that the sensor still has the
+ *                  cached descriptor and goes straight back to reading the
+ *                  temperature, or detects the sensor again if it has not.*/
 typedef enum
 {
     SENSOR_DETECT,
     READ_UNIT,
-    READ_TEMPERATURE
+    READ_DESCRIPTOR,
+    READ_TEMPERATURE,
+    SENSOR_REATTACH
 }master_state;
 
+/* A sensor on the bus and the master state machine serving it
+ * cs_pin:         chip select pin of the sensor.
+ * drdy_pin:       data ready pin driven by the sensor.
+ * poll_period_ms: time between two reads of the sensor.
+ * priority:       among sensors due at the same time, the one with the
+ *                 highest priority is served first.
+ * state:          master state for this sensor.
+ * retries:        failed exchanges since the last valid one or reset.
+ * failures:       failed exchanges since the last valid one.
+ * next_poll_ms:   time the sensor is due next.
+ * descriptor:     descriptor of the sensor as detected.
+ * descriptor_valid: set once the descriptor was verified.
+ * stats:          statistics of the transactions with the sensor.
+ * next_stats_ms:  time the statistics are dumped next.
+ * The remaining members hold the per sensor state of the optional features.*/
+typedef struct
+{
+    wiced_bt_gpio_numbers_t cs_pin;
+    wiced_bt_gpio_numbers_t drdy_pin;
+    uint32_t                poll_period_ms;
+    uint8_t                 priority;
+
+    master_state            state;
+    uint8_t                 retries;
+    uint32_t                failures;
+    uint64_t                next_poll_ms;
+    sensor_descriptor       descriptor;
+    wiced_bool_t            descriptor_valid;
+    spi_stats               stats;
+    uint64_t                next_stats_ms;
+#if ( SPI_HANDSHAKE_MODE == SPI_HANDSHAKE_READY_GPIO )
+    /* Set once the slave failed to signal a response within TX_RX_TIMEOUT */
+    wiced_bool_t            data_ready_missing;
+#endif
+#if ( SPI_PIPELINED_TRANSFERS )
+    /* Set once a pipelined command is outstanding, so that the next window
+     * returns its response*/
+    wiced_bool_t            pipeline_primed;
+#endif
+#if ( SPI_BATCHED_FRAMES )
+    /* Set when the last burst read was full, more samples may be waiting*/
+    wiced_bool_t            samples_pending;
+    /* Sequence number of the last request frame*/
+    uint8_t                 frame_seq;
+#endif
+#if ( SPI_REGISTER_READS )
+    /* Samples the sensor had dropped when last read, valid once read*/
+    uint16_t                samples_dropped;
+    wiced_bool_t            dropped_valid;
+#endif
+#if ( SPI_ASYNC_REQUESTS )
+    /* Requests submitted for the sensor and those joining a pending read*/
+    uint32_t                requests;
+    uint32_t                coalesced;
+#endif
+#if ( SPI_CHANGE_REPORTING )
+    /* Set from the data ready interrupt, a change is signaled unless the
+       edge came from a response*/
+    volatile wiced_bool_t   change_signaled;
+#endif
+#if ( SPI_SUMMARY_READS )
+    /* Number of the last summary window read, valid once one was read*/
+    uint16_t                summary_window;
+    wiced_bool_t            summary_valid;
+#endif
+#if ( SPI_CLOCK_SYNC )
+    /* Master time in us at which the sensor clock read clock_slave_ms, and
+       half the round trip of that measurement, which bounds its error*/
+    uint64_t                clock_master_us;
+    uint32_t                clock_slave_ms;
+    uint32_t                clock_error_us;
+    /* Set once the offset was measured, cleared when the sensor may have
+       restarted; the offset is measured again at next_sync_ms*/
+    wiced_bool_t            clock_synced;
+    uint64_t                next_sync_ms;
+    uint32_t                clock_syncs;
+#endif
+#if ( SPI_TIMED_SAMPLES )
+    /* Time from taking a sample to receiving it, of the samples received
+       while the clocks were synced*/
+    uint32_t                sample_ages;
+    uint64_t                sample_age_sum_ms;
+    uint32_t                sample_age_max_ms;
+#endif
+#if ( SPI_ADC_SCAN )
+    /* Last ADC scan read, valid once one was read, and the scans read*/
+    adc_scan                scan;
+    wiced_bool_t            scan_valid;
+    uint32_t                scans;
+#endif
+#if ( SPI_LINK_TRAINING )
+    /* Trained SPI clock, 0 until trained*/
+    uint32_t                clock_hz;
+    /* Exchanges and exchanges needing a retransmit since the last check*/
+    uint32_t                link_exchanges;
+    uint32_t                link_errors;
+#endif
+}spi_sensor;
+
 /******************************************************************************
  *                                Variables Definitions
  ******************************************************************************/
 
 static wiced_thread_t       *spi_1;
 
+/* Sensors served by spi_sensor_thread*/
+static spi_sensor            spi_sensors[] =
+{
+    { .cs_pin = SPI_CS,   .drdy_pin = SPI_DRDY,   .poll_period_ms = SENSOR_POLL_PERIOD_MS, .priority = 1 },
+#if ( SPI_SENSOR_COUNT > 1 )
+    { .cs_pin = SPI_CS_2, .drdy_pin = SPI_DRDY_2, .poll_period_ms = SENSOR_POLL_PERIOD_MS, .priority = 1 },
+#endif
+#if ( SPI_SENSOR_COUNT > 2 )
+    { .cs_pin = SPI_CS_3, .drdy_pin = SPI_DRDY_3, .poll_period_ms = SENSOR_POLL_PERIOD_MS, .priority = 1 },
+#endif
+};
+#define SENSOR_COUNT                          (sizeof(spi_sensors) / sizeof(spi_sensors[0]))
+
+#if !( SPI_BATCHED_FRAMES )
+/* Command sent to the sensor in each master state*/
+static const sensor_cmd      state_cmd[] =
+{
+    [SENSOR_DETECT]    = GET_MANUFACTURER_ID,
+    [READ_UNIT]        = GET_UNIT,
+    [READ_DESCRIPTOR]  = GET_DESCRIPTOR,
+    [READ_TEMPERATURE] = MEASURE_TEMPERATURE,
+    [SENSOR_REATTACH]  = GET_DESCRIPTOR
+};
+#else
+/* Command sent to the sensor in each master state when using frames; the
+ * temperature is read as a burst of the samples buffered by the sensor*/
+static const sensor_cmd      frame_state_cmd[] =
+{
+    [SENSOR_DETECT]    = GET_MANUFACTURER_ID,
+    [READ_UNIT]        = GET_UNIT,
+    [READ_DESCRIPTOR]  = GET_DESCRIPTOR,
+#if ( SPI_CHANGE_REPORTING )
+    [READ_TEMPERATURE] = REPORT_TEMPERATURE,
+#elif ( SPI_SUMMARY_READS )
+    [READ_TEMPERATURE] = GET_SUMMARY,
+#elif ( SPI_REGISTER_READS )
+    [READ_TEMPERATURE] = READ_REGISTERS,
+#elif ( SPI_TIMED_SAMPLES )
+    [READ_TEMPERATURE] = READ_TIMED_SAMPLES,
+#elif ( SPI_PACKED_SAMPLES )
+    [READ_TEMPERATURE] = READ_PACKED_SAMPLES,
+#else
+    [READ_TEMPERATURE] = READ_SAMPLES,
+#endif
+    [SENSOR_REATTACH]  = GET_DESCRIPTOR
+};
+#endif
+
+#if ( SPI_CHANGE_REPORTING )
+/* Change reporting set up on every sensor*/
+static const report_config   report_setup =
+{
+    .threshold  = REPORT_THRESHOLD,
+    .hysteresis = REPORT_HYSTERESIS
+};
+#endif
+
+#if ( SPI_LINK_TRAINING )
+/* SPI clocks tried by the link training, lowest first*/
+static const uint32_t        link_clock_steps[] =
+{
+    DEFAULT_FREQUENCY, 2000000u, 3000000u, 4000000u, 6000000u, 8000000u,
+    12000000u
+};
+/* Clock the SPI interface currently runs at*/
+static uint32_t              bus_clock = DEFAULT_FREQUENCY;
+#endif
+
+#if ( SPI_HANDSHAKE_MODE == SPI_HANDSHAKE_READY_GPIO )
+/* Given from the data ready interrupts for every response a slave loads */
+static wiced_semaphore_t    *data_ready;
+#endif
+#if ( SPI_CHANGE_REPORTING || SPI_ASYNC_REQUESTS )
+/* Given for every change a sensor signals and every new pending request,
+ * cuts the idle wait of spi_sensor_thread short. Apart from data_ready, so
+ * only a slave loading its response gives that*/
+static wiced_semaphore_t    *thread_wake;
+#endif
+#if ( SPI_CHANGE_REPORTING )
+/* Sensor selected for a frame exchange; its data ready edge then signals
+ * the response, not a change*/
+static spi_sensor * volatile selected_sensor;
+#endif
+
+/* Stack of spi_sensor_thread, painted when it starts*/
+static spi_stack             spi_thread_stack;
+
+#if ( SPI_BATCHED_FRAMES )
+/* Frames of the exchanges of spi_sensor_thread, kept off its stack*/
+SPI_POOL_DEFINE( frame_pool, spi_frame, SPI_FRAME_POOL_SIZE );
+#endif
+
+#if ( SPI_ASYNC_REQUESTS )
+/* Submitted requests not yet served, oldest first, guarded by
+ * requests_lock; reads that were coalesced hang off the pending read*/
+static spi_request          *requests_head;
+static spi_request          *requests_tail;
+static wiced_mutex_t        *requests_lock;
+/* Requests handed out by spi_master_request_take(), guarded by
+ * requests_lock*/
+SPI_POOL_DEFINE( request_pool, spi_request, SPI_REQUEST_POOL_SIZE );
+#endif
+
+#if ( SPI_REQUEST_CLIENTS )
+/* State of a sample client thread*/
+typedef struct
+{
+    wiced_semaphore_t       *done;
+    wiced_result_t           result;
+}spi_request_client;
+
+static spi_request_client    request_clients[SPI_REQUEST_CLIENTS];
+#endif
+
 /******************************************************************************
  *                                Function Prototypes
  ******************************************************************************/
@@ -164,7 +687,92 @@ wiced_result_t bt_cback( wiced_bt_management_evt_t event,
                          wiced_bt_management_evt_data_t *p_event_data );
 void           initialize_app( void );
 static void    spi_sensor_thread( uint32_t arg);
-void           spi_sensor_utility (data_packet *send_msg, data_packet *rec_msg);
+static spi_sensor *spi_sensor_next( uint64_t now_ms, uint32_t *wait_ms );
+static void    spi_sensor_service( spi_sensor *sensor, uint64_t now_ms );
+static void    spi_sensor_stats( spi_sensor *sensor );
+static void    spi_master_stats( void );
+void           spi_sensor_utility (spi_sensor *sensor, data_packet *send_msg,
+                                   data_packet *rec_msg);
+static void    spi_sensor_reading( spi_sensor *sensor, int16_t data );
+static void    spi_sensor_timed_reading( spi_sensor *sensor, int16_t data,
+                                         uint32_t time_ms );
+static wiced_bool_t spi_sensor_process( spi_sensor *sensor, uint8_t cmd,
+                                        int16_t data );
+#if !( SPI_BATCHED_FRAMES )
+static wiced_bool_t spi_sensor_single( spi_sensor *sensor );
+#endif
+#if ( SPI_PIPELINED_TRANSFERS )
+static wiced_bool_t spi_sensor_pipelined( spi_sensor *sensor );
+#endif
+#if ( SPI_BATCHED_FRAMES )
+static wiced_bool_t spi_sensor_batch( spi_sensor *sensor );
+static wiced_bool_t spi_sensor_samples( spi_sensor *sensor,
+                                        const frame_record *record,
+                                        uint32_t max_samples );
+#if ( SPI_SUMMARY_READS )
+static wiced_bool_t spi_sensor_summary( spi_sensor *sensor,
+                                        const frame_record *record );
+#endif
+#if ( SPI_PACKED_SAMPLES )
+static wiced_bool_t spi_sensor_packed_samples( spi_sensor *sensor,
+                                               const frame_record *record,
+                                               uint32_t max_samples );
+#endif
+#if ( SPI_REGISTER_READS )
+static wiced_bool_t spi_sensor_registers( spi_sensor *sensor,
+                                          const frame_record *record );
+#endif
+#if ( SPI_TIMED_SAMPLES )
+static wiced_bool_t spi_sensor_timed_samples( spi_sensor *sensor,
+                                              const frame_record *record,
+                                              uint32_t max_samples );
+#endif
+#if ( SPI_ADC_SCAN )
+static wiced_bool_t spi_sensor_adc_scan( spi_sensor *sensor,
+                                         const frame_record *record );
+#endif
+static wiced_bool_t spi_sensor_transfer( spi_sensor *sensor,
+                                         spi_frame *send_frame,
+                                         spi_frame *rec_frame );
+wiced_bool_t   spi_sensor_frame_utility( spi_sensor *sensor,
+                                         spi_frame *send_frame,
+                                         spi_frame *rec_frame );
+static void    spi_sensor_resync( spi_sensor *sensor );
+static wiced_bool_t spi_frames_take( spi_frame **send_frame,
+                                     spi_frame **rec_frame );
+static void    spi_frames_give( spi_frame *send_frame, spi_frame *rec_frame );
+#endif
+#if ( SPI_ASYNC_REQUESTS )
+static wiced_bool_t spi_requests_serve( void );
+static void    spi_request_complete( spi_request *request,
+                                     wiced_result_t result,
+                                     const uint8_t *data );
+#endif
+#if ( SPI_REQUEST_CLIENTS )
+static void    spi_request_client_thread( uint32_t arg );
+static void    spi_request_client_done( spi_request *request,
+                                        wiced_result_t result );
+#endif
+#if ( SPI_LINK_TRAINING )
+static void    spi_link_train( spi_sensor *sensor );
+static uint32_t spi_link_probe( spi_sensor *sensor );
+static void    spi_link_set_clock( uint32_t clock );
+static void    spi_link_monitor( spi_sensor *sensor, wiced_bool_t retransmitted );
+#endif
+#if ( SPI_CLOCK_SYNC )
+static void    spi_clock_sync( spi_sensor *sensor, uint64_t now_ms );
+#endif
+#if ( SPI_TIMED_SAMPLES )
+static uint64_t spi_clock_to_master( const spi_sensor *sensor, uint32_t slave_ms );
+#endif
+static void    spi_count_reply( spi_sensor *sensor, wiced_bool_t valid,
+                                uint16_t header );
+static void    spi_clear_data_ready( void );
+static void    spi_wait_for_slave_ready( spi_sensor *sensor );
+static void    spi_wait_for_response( spi_sensor *sensor );
+#if ( SPI_HANDSHAKE_MODE == SPI_HANDSHAKE_READY_GPIO )
+static void    spi_data_ready_cback( void *data, uint8_t port_pin );
+#endif
 
 /******************************************************************************
  *                                Function Definitions
@@ -187,7 +795,8 @@ void           spi_sensor_utility (data_packet *send_msg, data_packet *rec_msg);
 APPLICATION_START()
 {
     wiced_set_debug_uart( WICED_ROUTE_DEBUG_TO_PUART );
-    if(WICED_BT_SUCCESS != wiced_bt_stack_init( bt_cback, NULL, NULL ))
+    if(WICED_BT_SUCCESS != wiced_bt_stack_init( bt_cback, &wiced_bt_cfg_settings,
+                                                 wiced_bt_cfg_buf_pools ))
     {
         WICED_BT_TRACE("Bluetooth LE stack initialization failed \n\r");
     }
@@ -218,6 +827,10 @@ wiced_result_t bt_cback( wiced_bt_management_evt_t event,
 
         WICED_BT_TRACE("\n\rSample SPI Master Application\n\n\r");
 
+#if ( SPI_GATT_NOTIFICATIONS )
+        /* Readings are published from the first poll on*/
+        spi_gatt_init();
+#endif
         initialize_app();
 
         break;
@@ -240,18 +853,58 @@ wiced_result_t bt_cback( wiced_bt_management_evt_t event,
 
 void initialize_app( void )
 {
+    uint32_t i;
+#if ( SPI_REQUEST_CLIENTS )
+    wiced_thread_t *client;
+#endif
+
     wiced_hal_pspi_init(SPI,
                         DEFAULT_FREQUENCY,
                         SPI_LSB_FIRST,
                         SPI_SS_ACTIVE_LOW,
                         SPI_MODE_0);
 
+#if ( SPI_HANDSHAKE_MODE == SPI_HANDSHAKE_READY_GPIO )
+    data_ready = wiced_rtos_create_semaphore();
+    wiced_rtos_init_semaphore(data_ready);
+
+#endif
+#if ( SPI_CHANGE_REPORTING || SPI_ASYNC_REQUESTS )
+    thread_wake = wiced_rtos_create_semaphore();
+    wiced_rtos_init_semaphore(thread_wake);
+#endif
+#if ( SPI_ASYNC_REQUESTS )
+    requests_lock = wiced_rtos_create_mutex();
+    wiced_rtos_init_mutex(requests_lock);
+#endif
+
+    for(i = 0; i < SENSOR_COUNT; i++)
+    {
+        spi_sensors[i].next_stats_ms = SPI_STATS_PERIOD_MS;
+
+        /* No sensor is selected until its transaction starts */
+        wiced_hal_gpio_configure_pin(spi_sensors[i].cs_pin,
+                                     GPIO_OUTPUT_ENABLE,
+                                     GPIO_PIN_OUTPUT_HIGH);
+#if ( SPI_HANDSHAKE_MODE == SPI_HANDSHAKE_READY_GPIO )
+        /* The slave drives its data ready pin; the pull down keeps it low
+           when no slave or a slave without the handshake is connected */
+        wiced_hal_gpio_configure_pin(spi_sensors[i].drdy_pin,
+                                     GPIO_INPUT_ENABLE | GPIO_PULL_DOWN |
+                                     GPIO_EN_INT_RISING_EDGE,
+                                     GPIO_PIN_OUTPUT_LOW);
+        wiced_hal_gpio_register_pin_for_interrupt(spi_sensors[i].drdy_pin,
+                                                  spi_data_ready_cback,
+                                                  NULL);
+#endif
+    }
+
     spi_1 = wiced_rtos_create_thread();
     if ( WICED_SUCCESS == wiced_rtos_init_thread(spi_1,
                                                  PRIORITY_MEDIUM,
                                                  "SPI 1 instance",
                                                  spi_sensor_thread,
-                                                 THREAD_STACK_MIN_SIZE,
+                                                 SPI_THREAD_STACK_SIZE,
                                                  NULL ) )
     {
         WICED_BT_TRACE( "SPI Sensor thread created\n\r" );
@@ -261,13 +914,33 @@ void initialize_app( void )
         WICED_BT_TRACE( "Failed to create SPI Sensor thread \n\r" );
     }
 
+#if ( SPI_REQUEST_CLIENTS )
+    for(i = 0; i < SPI_REQUEST_CLIENTS; i++)
+    {
+        request_clients[i].done = wiced_rtos_create_semaphore();
+        wiced_rtos_init_semaphore(request_clients[i].done);
+        client = wiced_rtos_create_thread();
+        if ( WICED_SUCCESS != wiced_rtos_init_thread(client,
+                                                     PRIORITY_MEDIUM,
+                                                     "SPI request client",
+                                                     spi_request_client_thread,
+                                                     THREAD_STACK_MIN_SIZE,
+                                                     (void *)(uintptr_t)i ) )
+        {
+            WICED_BT_TRACE( "Failed to create SPI request client thread \n\r" );
+        }
+    }
+#endif
 }
 
 /*******************************************************************************
  Function name:  spi_sensor_thread
 
  Function Description:
- @brief    Starts and maintains transfer of SPI sensor data.
+ @brief    Starts and maintains transfer of SPI sensor data. One transaction
+           at a time is made with the sensor that is due next, so the
+           sensors of spi_sensors share the bus without one of them holding
+           up the others.
 
  @param    arg  unused argument
 
@@ -276,160 +949,2109 @@ void initialize_app( void )
 
 void spi_sensor_thread(uint32_t arg )
 {
-    data_packet send_data;
-    data_packet rec_data;
-    wiced_result_t result;
-    uint8_t num_retries = RESET_COUNT;
-    uint32_t count;
-    master_state curr_state = SENSOR_DETECT;
-    int8_t dec_temp;
-    uint8_t frac_temp;
+    spi_sensor *sensor;
+    uint64_t now_ms;
+    uint64_t next_stats_ms = SPI_STATS_PERIOD_MS;
+    uint32_t wait_ms;
+#if ( SPI_ASYNC_REQUESTS )
+    wiced_bool_t requests_left;
+#endif
+
+    spi_stack_paint(&spi_thread_stack, SPI_THREAD_STACK_SIZE);
     WICED_BT_TRACE("Inside SPI Sensor Thread\n\r");
 
     while(WICED_TRUE)
     {
-        switch(curr_state)
+#if ( SPI_ASYNC_REQUESTS )
+        /* One frame of submitted requests goes ahead of each poll, so
+           neither the requests nor the polls starve*/
+        requests_left = spi_requests_serve();
+#endif
+        now_ms = clock_SystemTimeMicroseconds64() / 1000;
+        if(SPI_STATS_PERIOD_MS && (now_ms >= next_stats_ms))
         {
-        case SENSOR_DETECT:
-
-            /* Configuring send_data data packet to contain command
-               GET_MANUFACTURER_ID*/
-            send_data.data = GET_MANUFACTURER_ID;
-            send_data.header = PACKET_HEADER;
-            WICED_BT_TRACE("Sensor detect packet ready\n\r");
-
-            /* This function is responsible for transmitting and receiving SPI
-               data. It uses the send_data data packet, configured before, to
-               transmit and stores the received data packet to rec_data*/
-            spi_sensor_utility(&send_data,&rec_data);
-            WICED_BT_TRACE("Data sent \n\r");
-            if(PACKET_HEADER == rec_data.header)
-            {
-                if(MANUFACTURER_ID == rec_data.data)
-                {
-                    WICED_BT_TRACE("Manufacturer: Cypress Semiconductor\n\r");
-                    curr_state = READ_UNIT;
-                    num_retries = RESET_COUNT;
-                }
-                else
-                {
-                    num_retries++;
-                    WICED_BT_TRACE("Unknown manufacturer \n\r");
-                }
-            }
-            else
+            spi_master_stats();
+            next_stats_ms = now_ms + SPI_STATS_PERIOD_MS;
+        }
+        sensor = spi_sensor_next(now_ms, &wait_ms);
+        if(NULL == sensor)
+        {
+#if ( SPI_ASYNC_REQUESTS )
+            if(requests_left)
             {
-                WICED_BT_TRACE("Failed to get manufacturer ID\n\r");
-                num_retries++;
+                continue;
             }
-            break;
+#endif
+            /* Print what the transactions logged while nothing is due*/
+            spi_log_flush();
+#if ( SPI_CHANGE_REPORTING || SPI_ASYNC_REQUESTS )
+            /* A sensor signaling a change or a request being submitted
+               cuts the wait short*/
+            wiced_rtos_get_semaphore(thread_wake, wait_ms);
+#else
+            wiced_rtos_delay_milliseconds(wait_ms, ALLOW_THREAD_TO_SLEEP);
+#endif
+            continue;
+        }
+        spi_sensor_service(sensor, now_ms);
+    }
+}
 
-        case READ_UNIT:
+/*******************************************************************************
+ Function name:  spi_sensor_next
 
-            /* Configuring send_data data packet to contain command GET_UNIT*/
-            send_data.data = GET_UNIT;
-            send_data.header = PACKET_HEADER;
-            spi_sensor_utility(&send_data,&rec_data);
-            if(PACKET_HEADER == rec_data.header)
-            {
-                if(UNIT_ID == rec_data.data)
-                {
-                    WICED_BT_TRACE("Unit: Celsius \n\r");
-                    curr_state = READ_TEMPERATURE;
-                    num_retries = RESET_COUNT;
-                }
-                else
-                {
-                    num_retries++;
-                    WICED_BT_TRACE("Unknown unit \n\r");
-                }
-            }
-            else
-            {
-                num_retries++;
-            }
-            break;
+ Function Description:
+ @brief    Picks the sensor to serve next: of the sensors that are due, the
+           one with the highest priority, and among those the one that has
+           waited longest. A sensor that signaled a change is due at once.
 
-        case READ_TEMPERATURE:
+ @param    now_ms    current time
+ @param    *wait_ms  time until the next sensor is due, if none is due now
 
-            /* Configuring send_data data packet to contain command
-               MEASURE_TEMPERATURE*/
-            send_data.data = MEASURE_TEMPERATURE;
-            send_data.header = PACKET_HEADER;
-            spi_sensor_utility(&send_data,&rec_data);
-            if(PACKET_HEADER == rec_data.header)
-            {
-                num_retries = RESET_COUNT;
+ @return   spi_sensor*  sensor to serve, NULL if none is due
+ ******************************************************************************/
 
-                /* The temperature data received is 16 bit integer. Say if
-                   temperature is 23.45 Celsius, the received temperature data
-                   is 2345. So, to obtain the decimal and fractional parts, the
-                   quotient and remainder are found.*/
-                dec_temp = (rec_data.data / NORM_FACTOR);
+static spi_sensor *spi_sensor_next(uint64_t now_ms, uint32_t *wait_ms)
+{
+    spi_sensor *next = NULL;
+    uint64_t earliest = UINT64_MAX;
+    uint32_t i;
 
-                /* Fractional part cannot be negative */
-                frac_temp = ABS(rec_data.data % NORM_FACTOR);
-                WICED_BT_TRACE("Temperature Value %d.%d \r\n",
-                                dec_temp,frac_temp);
+    for(i = 0; i < SENSOR_COUNT; i++)
+    {
+        spi_sensor *sensor = &spi_sensors[i];
+
+#if ( SPI_CHANGE_REPORTING )
+        if(sensor->change_signaled && (READ_TEMPERATURE == sensor->state))
+        {
+            sensor->next_poll_ms = MIN(sensor->next_poll_ms, now_ms);
+        }
+#endif
+        if(sensor->next_poll_ms > now_ms)
+        {
+            earliest = MIN(earliest, sensor->next_poll_ms);
+        }
+        else if((NULL == next) || (sensor->priority > next->priority) ||
+                ((sensor->priority == next->priority) &&
+                 (sensor->next_poll_ms < next->next_poll_ms)))
+        {
+            next = sensor;
+        }
+    }
+    *wait_ms = (uint32_t)(earliest - now_ms);
+    return next;
+}
+
+/*******************************************************************************
+ Function name:  spi_sensor_service
+
+ Function Description:
+ @brief    Makes one transaction with a sensor, advances its state machine
+           and schedules its next poll.
+
+ @param    *sensor  sensor to serve
+ @param    now_ms   current time
+
+ @return   none
+ ******************************************************************************/
+
+static void spi_sensor_service(spi_sensor *sensor, uint64_t now_ms)
+{
+    wiced_bool_t valid;
+    uint32_t delay_ms = sensor->poll_period_ms;
+#if !( SPI_BATCHED_FRAMES )
+    master_state state = sensor->state;
+#endif
+
+#if ( SPI_LINK_TRAINING )
+    /* Sensors may run at different clocks*/
+    spi_link_set_clock(sensor->clock_hz ? sensor->clock_hz : DEFAULT_FREQUENCY);
+#endif
+#if ( SPI_BATCHED_FRAMES )
+    /* One frame carries the command of the current state and of every
+       state after it, so a freshly detected sensor yields its unit and
+       first temperature readings in the same transaction*/
+    valid = spi_sensor_batch(sensor);
+#elif ( SPI_PIPELINED_TRANSFERS )
+    valid = (READ_TEMPERATURE == sensor->state) ?
+            spi_sensor_pipelined(sensor) :
+            spi_sensor_single(sensor);
+#else
+    valid = spi_sensor_single(sensor);
+#endif
+    if(valid)
+    {
+        sensor->retries = RESET_COUNT;
+        sensor->failures = 0;
+    }
+    else
+    {
+        /* The command is sent again with the next poll*/
+        sensor->stats.retries++;
+        sensor->retries++;
+        sensor->failures++;
+    }
+    if(sensor->retries > MAX_RETRIES)
+    {
+        /* If the number of retries exceeds the maximum, the current
+           state is changed to SENSOR_DETECT and the SPI interface is reset.
+           This reset resolves clock synchronization issues and ensures the
+           data is interpreted correctly. A sensor detected before only
+           has to show it is still the same one.*/
+#if ( SPI_DESCRIPTOR_CACHE )
+        sensor->state = sensor->descriptor_valid ? SENSOR_REATTACH :
+                                                   SENSOR_DETECT;
+#else
+        sensor->state = SENSOR_DETECT;
+#endif
+        sensor->retries = RESET_COUNT;
+        sensor->stats.resets++;
+        wiced_hal_pspi_reset(SPI);
+#if ( SPI_LINK_TRAINING )
+        /* Redetect at the default clock, the sensor may have changed*/
+        sensor->clock_hz = 0;
+#endif
+#if ( SPI_CLOCK_SYNC )
+        /* The sensor may have restarted its clock*/
+        sensor->clock_synced = WICED_FALSE;
+        sensor->next_sync_ms = 0;
+#endif
+    }
+#if ( SPI_LINK_TRAINING )
+    if((READ_TEMPERATURE == sensor->state) && !sensor->clock_hz)
+    {
+        spi_link_train(sensor);
+    }
+#endif
+#if ( SPI_CLOCK_SYNC )
+    if((READ_TEMPERATURE == sensor->state) && (now_ms >= sensor->next_sync_ms))
+    {
+        spi_clock_sync(sensor, now_ms);
+    }
+#endif
+#if ( SPI_CHANGE_REPORTING )
+    /* Between changes the sensor is only read to check it is still there*/
+    if(valid && (READ_TEMPERATURE == sensor->state))
+    {
+        delay_ms = SPI_REPORT_HEARTBEAT_MS;
+    }
+#endif
+#if ( SPI_BATCHED_FRAMES )
+    /* Drain a backlog of buffered samples without waiting*/
+    if(valid && sensor->samples_pending)
+    {
+        delay_ms = 0;
+    }
+#else
+    /* Read a sensor that reattached right away*/
+    if(valid && (SENSOR_REATTACH == state))
+    {
+        delay_ms = 0;
+    }
+#endif
+    if(!valid && (sensor->failures <= MAX_RETRIES))
+    {
+        delay_ms = MIN(delay_ms, SENSOR_RETRY_DELAY_MS);
+    }
+    if(sensor->failures > 2 * MAX_RETRIES)
+    {
+        /* Back off from a sensor that is still failing well after the
+           reset, doubling the wait with every further failure*/
+        delay_ms = MAX(sensor->poll_period_ms, 1) <<
+                   MIN(sensor->failures - 2 * MAX_RETRIES, 13);
+        delay_ms = MAX(MIN(delay_ms, SENSOR_MAX_BACKOFF_MS),
+                       sensor->poll_period_ms);
+    }
+    sensor->next_poll_ms = now_ms + delay_ms;
+
+    if(SPI_STATS_PERIOD_MS && (READ_TEMPERATURE == sensor->state) &&
+       (now_ms >= sensor->next_stats_ms))
+    {
+        spi_sensor_stats(sensor);
+        sensor->next_stats_ms = now_ms + SPI_STATS_PERIOD_MS;
+    }
+#if ( SPI_CHANGE_REPORTING )
+    /* The sensor was just read; a change it signaled between the exchanges
+       is signaled again with its next reading*/
+    sensor->change_signaled = WICED_FALSE;
+#endif
+}
+
+/*******************************************************************************
+ Function name:  spi_sensor_stats
+
+ Function Description:
+ @brief    Dumps the statistics of the transactions with a sensor and, with
+           frames, reads and dumps the statistics the sensor keeps of the
+           same link.
+
+ @param    *sensor  sensor in READ_TEMPERATURE
+
+ @return   none
+ ******************************************************************************/
+
+static void spi_sensor_stats(spi_sensor *sensor)
+{
+#if ( SPI_BATCHED_FRAMES )
+    spi_frame *send_frame;
+    spi_frame *rec_frame;
+    const frame_record *record = NULL;
+    uint32_t offset = 0;
+    spi_stats slave_stats;
+#endif
+#if ( SPI_CLOCK_SYNC )
+    int64_t offset_us;
+#endif
+
+    WICED_BT_TRACE("Statistics of sensor %d\n\r", (int)(sensor - spi_sensors) + 1);
+    spi_stats_dump("master", &sensor->stats);
+#if ( SPI_ASYNC_REQUESTS )
+    WICED_BT_TRACE("Requests: %d submitted, %d coalesced\n\r",
+                   (int)sensor->requests, (int)sensor->coalesced);
+#endif
+#if ( SPI_CLOCK_SYNC )
+    /* Master clock minus sensor clock*/
+    offset_us = (int64_t)(sensor->clock_master_us -
+                          (uint64_t)sensor->clock_slave_ms * 1000);
+    WICED_BT_TRACE("Clock offset: %s%d.%03d ms, error %d us, %d syncs\n\r",
+                   (offset_us < 0) ? "-" : "", (int)(ABS(offset_us) / 1000),
+                   (int)(ABS(offset_us) % 1000), (int)sensor->clock_error_us,
+                   (int)sensor->clock_syncs);
+#endif
+#if ( SPI_TIMED_SAMPLES )
+    WICED_BT_TRACE("Sample age: mean %d ms, max %d ms, %d samples\n\r",
+                   sensor->sample_ages ?
+                   (int)(sensor->sample_age_sum_ms / sensor->sample_ages) : 0,
+                   (int)sensor->sample_age_max_ms, (int)sensor->sample_ages);
+#endif
+#if ( SPI_ADC_SCAN )
+    WICED_BT_TRACE("ADC scans: %d read, %d channels in the last\n\r",
+                   (int)sensor->scans, (int)sensor->scan.count);
+#endif
+#if ( SPI_BATCHED_FRAMES )
+    if(!spi_frames_take(&send_frame, &rec_frame))
+    {
+        return;
+    }
+    spi_frame_init(send_frame);
+    spi_frame_add(send_frame, GET_STATS, 0, NULL);
+    spi_frame_seal(send_frame, ++sensor->frame_seq);
+    if(spi_sensor_transfer(sensor, send_frame, rec_frame))
+    {
+        record = spi_frame_next(rec_frame, &offset);
+    }
+    if((NULL == record) || (GET_STATS != record->cmd) ||
+       (SPI_STATS_WIRE_SIZE != record->length))
+    {
+        WICED_BT_TRACE("Failed to read the statistics of the sensor\n\r");
+    }
+    else
+    {
+        spi_stats_unpack(&slave_stats, record->data);
+        spi_stats_dump("slave", &slave_stats);
+    }
+    spi_frames_give(send_frame, rec_frame);
+#endif
+}
+
+/*******************************************************************************
+ Function name:  spi_master_stats
+
+ Function Description:
+ @brief    Dumps the use of what all sensors share: the stack of the SPI
+           thread, the pools and the GATT notifications.
+
+ @return   none
+ ******************************************************************************/
 
+static void spi_master_stats( void )
+{
+    WICED_BT_TRACE("SPI thread stack: %d of %d bytes used\n\r",
+                   (int)spi_stack_used(&spi_thread_stack),
+                   (int)SPI_THREAD_STACK_SIZE);
+#if ( SPI_BATCHED_FRAMES )
+    WICED_BT_TRACE("Frame pool: %d of %d used at most, %d times empty\n\r",
+                   (int)frame_pool.peak, (int)frame_pool.count,
+                   (int)frame_pool.failures);
+#endif
+#if ( SPI_ASYNC_REQUESTS )
+    WICED_BT_TRACE("Request pool: %d of %d used at most, %d times empty\n\r",
+                   (int)request_pool.peak, (int)request_pool.count,
+                   (int)request_pool.failures);
+#endif
+#if ( SPI_GATT_NOTIFICATIONS )
+    spi_gatt_stats();
+#endif
+}
+
+#if !( SPI_BATCHED_FRAMES )
+/*******************************************************************************
+ Function name:  spi_sensor_single
+
+ Function Description:
+ @brief    Sends the command of the current state in one data packet and
+           applies the response.
+
+ @param    *sensor  sensor, its state is advanced by the response
+
+ @return   wiced_bool_t  WICED_TRUE if the response was the expected one
+ ******************************************************************************/
+
+static wiced_bool_t spi_sensor_single(spi_sensor *sensor)
+{
+    data_packet send_data;
+    data_packet rec_data;
+
+    /* Configuring send_data data packet to contain the command of the
+       current state*/
+    send_data.data = state_cmd[sensor->state];
+    send_data.header = PACKET_HEADER;
+
+    /* This function is responsible for transmitting and receiving SPI
+       data. It uses the send_data data packet, configured before, to
+       transmit and stores the received data packet to rec_data*/
+    spi_sensor_utility(sensor, &send_data, &rec_data);
+    if(PACKET_HEADER == rec_data.header)
+    {
+        return spi_sensor_process(sensor, (uint8_t)send_data.data,
+                                  rec_data.data);
+    }
+    if(SENSOR_DETECT == sensor->state)
+    {
+        spi_log_write(SPI_LOG_NO_MANUFACTURER, 0, 0);
+    }
+    return WICED_FALSE;
+}
+#endif
+
+#if ( SPI_PIPELINED_TRANSFERS )
+/*******************************************************************************
+ Function name:  spi_sensor_pipelined
+
+ Function Description:
+ @brief    Reads the temperature with pipelined packets. A single full duplex
+           exchange sends the next MEASURE_TEMPERATURE command and receives
+           the response to the previous one, which the slave loaded as soon
+           as it got that command. The first exchange only primes the
+           pipeline.
+
+ @param    *sensor  sensor in READ_TEMPERATURE
+
+ @return   wiced_bool_t  WICED_TRUE unless the response was invalid
+ ******************************************************************************/
+
+static wiced_bool_t spi_sensor_pipelined(spi_sensor *sensor)
+{
+    data_packet send_data;
+    data_packet rec_data;
+    wiced_bool_t valid = WICED_TRUE;
+    uint64_t start_us;
+
+    send_data.data = MEASURE_TEMPERATURE;
+    send_data.header = PIPELINE_HEADER;
+
+    /* The slave signals once the response to the outstanding command is
+       loaded, which normally happened long before*/
+    if(sensor->pipeline_primed)
+    {
+        spi_wait_for_response(sensor);
+    }
+    spi_clear_data_ready();
+    start_us = clock_SystemTimeMicroseconds64();
+
+    wiced_hal_gpio_set_pin_output(sensor->cs_pin, GPIO_PIN_OUTPUT_LOW);
+    wiced_hal_pspi_exchange_data(SPI,
+                                 sizeof(send_data),
+                                 (uint8_t*)&send_data,
+                                 (uint8_t*)&rec_data);
+    wiced_hal_gpio_set_pin_output(sensor->cs_pin, GPIO_PIN_OUTPUT_HIGH);
+
+    spi_stats_add_transaction(&sensor->stats,
+                              (uint32_t)(clock_SystemTimeMicroseconds64() - start_us));
+    if(sensor->pipeline_primed)
+    {
+        spi_count_reply(sensor, (PIPELINE_HEADER == rec_data.header) ?
+                                WICED_TRUE : WICED_FALSE,
+                        rec_data.header);
+        valid = (PIPELINE_HEADER == rec_data.header) ?
+                spi_sensor_process(sensor, MEASURE_TEMPERATURE, rec_data.data) :
+                WICED_FALSE;
+    }
+    /* After a bad response the next exchange starts over*/
+    sensor->pipeline_primed = valid;
+    return valid;
+}
+#endif
+
+/*******************************************************************************
+ Function name:  spi_sensor_reading
+
+ Function Description:
+ @brief    Reports a temperature reading of a sensor taken just now.
+
+ @param    *sensor  sensor the reading comes from
+ @param    data     temperature in hundredths of a degree Celsius
+
+ @return   none
+ ******************************************************************************/
+
+static void spi_sensor_reading(spi_sensor *sensor, int16_t data)
+{
+    spi_sensor_timed_reading(sensor, data,
+                             (uint32_t)(clock_SystemTimeMicroseconds64() / 1000));
+}
+
+/*******************************************************************************
+ Function name:  spi_sensor_timed_reading
+
+ Function Description:
+ @brief    Reports a temperature reading of a sensor on the trace output and,
+           with GATT notifications, to the connected client.
+
+ @param    *sensor  sensor the reading comes from
+ @param    data     temperature in hundredths of a degree Celsius
+ @param    time_ms  time the reading was taken on the master clock
+
+ @return   none
+ ******************************************************************************/
+
+static void spi_sensor_timed_reading(spi_sensor *sensor, int16_t data,
+                                     uint32_t time_ms)
+{
+    /* The temperature data received is 16 bit integer. Say if
+       temperature is 23.45 Celsius, the received temperature data
+       is 2345. So, to obtain the decimal and fractional parts, the
+       quotient and remainder are found. Fractional part cannot be
+       negative.*/
+    spi_log_write(SPI_LOG_TEMPERATURE, data / NORM_FACTOR, ABS(data % NORM_FACTOR));
+#if ( SPI_GATT_NOTIFICATIONS )
+    spi_gatt_publish((uint8_t)(sensor - spi_sensors), data, time_ms);
+#else
+    (void)sensor;
+    (void)time_ms;
+#endif
+}
+
+/*******************************************************************************
+ Function name:  spi_sensor_process
+
+ Function Description:
+ @brief    Applies one response of the sensor to the master state machine.
+           In SENSOR_DETECT the manufacturer is verified, in READ_UNIT the
+           unit, in READ_DESCRIPTOR and SENSOR_REATTACH the descriptor, and
+           temperature readings are reported in READ_TEMPERATURE.
+
+ @param    *sensor  sensor, its state is advanced when the response
+                    verifies it
+ @param    cmd      command the response belongs to
+ @param    data     response data
+
+ @return   wiced_bool_t  WICED_TRUE if the response was the expected one
+ ******************************************************************************/
+
+static wiced_bool_t spi_sensor_process(spi_sensor *sensor, uint8_t cmd,
+                                       int16_t data)
+{
+    switch(cmd)
+    {
+    case GET_MANUFACTURER_ID:
+        if(MANUFACTURER_ID == data)
+        {
+            WICED_BT_TRACE("Manufacturer: Cypress Semiconductor\n\r");
+            sensor->descriptor.manufacturer = data;
+            sensor->state = READ_UNIT;
+            return WICED_TRUE;
+        }
+        WICED_BT_TRACE("Unknown manufacturer \n\r");
+        break;
+
+    case GET_UNIT:
+        if(UNIT_ID == data)
+        {
+            WICED_BT_TRACE("Unit: Celsius \n\r");
+            sensor->descriptor.unit = data;
+            sensor->state = READ_DESCRIPTOR;
+            return WICED_TRUE;
+        }
+        WICED_BT_TRACE("Unknown unit \n\r");
+        break;
+
+    case GET_DESCRIPTOR:
+        /* The sensor must speak the protocol version of this master*/
+        sensor->descriptor.version = SPI_PROTOCOL_VERSION;
+        if((uint16_t)data == spi_descriptor_signature(&sensor->descriptor))
+        {
+            if(SENSOR_REATTACH == sensor->state)
+            {
+                WICED_BT_TRACE("Sensor reattached \n\r");
             }
             else
             {
-                num_retries++;
+                WICED_BT_TRACE("Protocol version %d \n\r", SPI_PROTOCOL_VERSION);
             }
-            break;
-
-        default:
-            break;
+            sensor->descriptor_valid = WICED_TRUE;
+            sensor->state = READ_TEMPERATURE;
+            return WICED_TRUE;
         }
-        if(num_retries > MAX_RETRIES)
+        if(SENSOR_REATTACH == sensor->state)
         {
-            /* If the number of retries exceeds the maximum, the current
-               state is changed to SENSOR_DETECT and the SPI interface is reset.
-               This reset resolves clock synchronization issues and ensures the
-               data is interpreted correctly.*/
-            curr_state = SENSOR_DETECT;
-            num_retries = RESET_COUNT;
-            wiced_hal_pspi_reset(SPI);
+            WICED_BT_TRACE("Sensor changed, detecting it again \n\r");
+            sensor->descriptor_valid = WICED_FALSE;
+            sensor->state = SENSOR_DETECT;
+            break;
         }
-        wiced_rtos_delay_milliseconds(SLEEP_TIMEOUT, ALLOW_THREAD_TO_SLEEP);
+        WICED_BT_TRACE("Unsupported protocol version \n\r");
+        break;
+
+    case MEASURE_TEMPERATURE:
+#if ( SPI_CHANGE_REPORTING )
+    case REPORT_TEMPERATURE:
+#endif
+        spi_sensor_reading(sensor, data);
+        return WICED_TRUE;
+
+    default:
+        spi_log_write(SPI_LOG_UNSUPPORTED, cmd, 0);
+        break;
     }
+    return WICED_FALSE;
 }
 
+#if ( SPI_BATCHED_FRAMES )
 /*******************************************************************************
- Function name: spi_sensor_utility
+ Function name:  spi_sensor_batch
 
  Function Description:
- @brief    function that performs SPI transactions with SPI sensor
+ @brief    Sends the commands of the current and all following states in one
+           frame, SENSOR_REATTACH being followed by READ_TEMPERATURE, and
+           applies the responses in order. Processing stops at the
+           first response that does not verify, so later responses are only
+           used once the sensor has been identified.
 
- @param   *send_msg  pointer to the data packet that is sent.
-*@param   *rec_msg   pointer to the data packet that is received.
+ @param    *sensor  sensor, its state is advanced by the responses
 
- @return void
+ @return   wiced_bool_t  WICED_TRUE if every command got its expected response
  ******************************************************************************/
 
-void spi_sensor_utility(data_packet *send_msg,data_packet *rec_msg)
+static wiced_bool_t spi_sensor_batch(spi_sensor *sensor)
 {
-    /* Chip select is set to LOW to select the slave for SPI transactions*/
-    wiced_hal_gpio_set_pin_output(SPI_CS, GPIO_PIN_OUTPUT_LOW);
-
-    WICED_BT_TRACE("Sending data to slave\n\r");
+    spi_frame *send_frame;
+    spi_frame *rec_frame;
+    const frame_record *record;
+    uint32_t offset = 0;
+    uint32_t num_cmds = 0;
+    uint8_t max_samples = SAMPLES_MAX_PER_RECORD;
+    int32_t room;
+    uint32_t s;
+    wiced_bool_t valid = WICED_TRUE;
+
+    if(!spi_frames_take(&send_frame, &rec_frame))
+    {
+        return WICED_FALSE;
+    }
+    spi_frame_init(send_frame);
+    for(s = sensor->state; ;
+        s = (SENSOR_REATTACH == s) ? READ_TEMPERATURE : (s + 1))
+    {
+        /* Reply bytes left for the data of this record, after the records
+           before it and the scan; signed, as the scan may take them all*/
+        room = (int32_t)FRAME_MAX_PAYLOAD - (int32_t)sizeof(frame_record) -
+               (int32_t)(num_cmds * (sizeof(frame_record) + sizeof(int16_t))) -
+               (int32_t)ADC_SCAN_REPLY_SIZE;
+        room = MAX(room, 0);
+        if(READ_SAMPLES == frame_state_cmd[s])
+        {
+            /* The sensor sends fewer if the reply has no room for more*/
+            max_samples = (uint8_t)(room / (int32_t)sizeof(int16_t));
+            spi_frame_add(send_frame, READ_SAMPLES,
+                          sizeof(max_samples), &max_samples);
+        }
+#if ( SPI_PACKED_SAMPLES )
+        else if(READ_PACKED_SAMPLES == frame_state_cmd[s])
+        {
+            /* At least one byte per sample behind the count of samples
+               left*/
+            max_samples = (uint8_t)MIN(MAX(room - 1, 0), (int32_t)PACKED_SAMPLES_MAX);
+            spi_frame_add(send_frame, READ_PACKED_SAMPLES,
+                          sizeof(max_samples), &max_samples);
+        }
+#endif
+#if ( SPI_TIMED_SAMPLES )
+        else if(READ_TIMED_SAMPLES == frame_state_cmd[s])
+        {
+            /* Four bytes per sample behind the time of the first*/
+            max_samples = (uint8_t)MIN(MAX(room - TIMED_SAMPLES_HEADER_SIZE, 0) /
+                                       TIMED_SAMPLE_WIRE_SIZE,
+                                       (int32_t)TIMED_SAMPLES_MAX_PER_RECORD);
+            spi_frame_add(send_frame, READ_TIMED_SAMPLES,
+                          sizeof(max_samples), &max_samples);
+        }
+#endif
+#if ( SPI_REGISTER_READS )
+        else if(READ_REGISTERS == frame_state_cmd[s])
+        {
+            /* From the report configuration on, through the status
+               registers into the sample window*/
+            uint8_t data[REGISTER_READ_WIRE_SIZE];
 
-    /* Sending command to slave*/
-    wiced_hal_pspi_tx_data(SPI,
-                           sizeof(*send_msg),
-                           (uint8_t*)send_msg);
-    /*Allowing slave time to fill its rx buffers before receiving*/
-    wiced_rtos_delay_milliseconds(TX_RX_TIMEOUT,ALLOW_THREAD_TO_SLEEP);
+            data[0] = REG_REPORT_THRESHOLD;
+            data[1] = (uint8_t)(room & ~1);
+            spi_frame_add(send_frame, READ_REGISTERS, sizeof(data), data);
+        }
+#endif
+#if ( SPI_CHANGE_REPORTING )
+        else if(REPORT_TEMPERATURE == frame_state_cmd[s])
+        {
+            /* Sent with every read, so a sensor that restarted is set up
+               again*/
+            uint8_t data[REPORT_CONFIG_WIRE_SIZE];
 
-    WICED_BT_TRACE("Receiving data from slave\n\r");
+            spi_report_config_pack(&report_setup, data);
+            spi_frame_add(send_frame, REPORT_TEMPERATURE, sizeof(data), data);
+        }
+#endif
+        else
+        {
+            spi_frame_add(send_frame, frame_state_cmd[s], 0, NULL);
+        }
+        num_cmds++;
+        if(READ_TEMPERATURE == s)
+        {
+            break;
+        }
+    }
+#if ( SPI_ADC_SCAN )
+    {
+        /* Answered after the temperature, in the room left for it*/
+        const uint8_t mask[ADC_SCAN_MASK_WIRE_SIZE] =
+        {
+            (uint8_t)SPI_ADC_SCAN_MASK, (uint8_t)(SPI_ADC_SCAN_MASK >> 8),
+            (uint8_t)(SPI_ADC_SCAN_MASK >> 16), (uint8_t)(SPI_ADC_SCAN_MASK >> 24)
+        };
 
-    /* Receving response from slave*/
-    wiced_hal_pspi_rx_data(SPI,
-                           sizeof(*rec_msg),
-                           (uint8_t*)rec_msg);
-    /* Chip select is set to HIGH to unselect the slave for SPI transactions*/
-    wiced_hal_gpio_set_pin_output(SPI_CS, GPIO_PIN_OUTPUT_HIGH);
+        spi_frame_add(send_frame, READ_ADC_SCAN, sizeof(mask), mask);
+        num_cmds++;
+    }
+#endif
 
+    sensor->samples_pending = WICED_FALSE;
+    spi_frame_seal(send_frame, ++sensor->frame_seq);
+    if(!spi_sensor_transfer(sensor, send_frame, rec_frame))
+    {
+        spi_log_write(SPI_LOG_FRAME_INVALID, 0, 0);
+        valid = WICED_FALSE;
+    }
+
+    while(valid && (NULL != (record = spi_frame_next(rec_frame, &offset))))
+    {
+        /* Replies come in request order, so each record must answer the
+           command of the state reached so far*/
+#if ( SPI_ADC_SCAN )
+        if((READ_ADC_SCAN == (record->cmd & ~RECORD_ERROR)) &&
+           (READ_TEMPERATURE == sensor->state))
+        {
+            valid = spi_sensor_adc_scan(sensor, record);
+        }
+        else
+#endif
+        if(frame_state_cmd[sensor->state] != record->cmd)
+        {
+            valid = WICED_FALSE;
+        }
+        else if(READ_SAMPLES == record->cmd)
+        {
+            valid = spi_sensor_samples(sensor, record, max_samples);
+        }
+#if ( SPI_PACKED_SAMPLES )
+        else if(READ_PACKED_SAMPLES == record->cmd)
+        {
+            valid = spi_sensor_packed_samples(sensor, record, max_samples);
+        }
+#endif
+#if ( SPI_TIMED_SAMPLES )
+        else if(READ_TIMED_SAMPLES == record->cmd)
+        {
+            valid = spi_sensor_timed_samples(sensor, record, max_samples);
+        }
+#endif
+#if ( SPI_REGISTER_READS )
+        else if(READ_REGISTERS == record->cmd)
+        {
+            valid = spi_sensor_registers(sensor, record);
+        }
+#endif
+#if ( SPI_SUMMARY_READS )
+        else if(GET_SUMMARY == record->cmd)
+        {
+            valid = spi_sensor_summary(sensor, record);
+        }
+#endif
+        else if(sizeof(int16_t) != record->length)
+        {
+            valid = WICED_FALSE;
+        }
+        else
+        {
+            valid = spi_sensor_process(sensor, record->cmd,
+                                       spi_record_int16(record));
+        }
+        num_cmds--;
+    }
+    spi_frames_give(send_frame, rec_frame);
+    return (valid && (0 == num_cmds)) ? WICED_TRUE : WICED_FALSE;
+}
+
+/*******************************************************************************
+ Function name:  spi_sensor_transfer
+
+ Function Description:
+ @brief    Exchanges a sealed request frame for its reply, sending it again
+           up to FRAME_RETRANSMITS times when the slave asks for it or the
+           reply is damaged. A damaged reply may leave part of it in the
+           slave, which is cleared out with spi_sensor_resync first; the
+           slave answers a repeated request from its last reply, so commands
+           are not executed twice.
+
+ @param    *sensor      sensor to exchange the frame with
+ @param    *send_frame  sealed request frame
+ @param    *rec_frame   reply frame
+
+ @return   wiced_bool_t  WICED_TRUE if a reply with records was received
+ ******************************************************************************/
+
+static wiced_bool_t spi_sensor_transfer(spi_sensor *sensor,
+                                        spi_frame *send_frame,
+                                        spi_frame *rec_frame)
+{
+    uint32_t attempt;
+
+    for(attempt = 0; attempt <= FRAME_RETRANSMITS; attempt++)
+    {
+        if(!spi_sensor_frame_utility(sensor, send_frame, rec_frame))
+        {
+            spi_log_write(SPI_LOG_FRAME_DAMAGED, 0, 0);
+            spi_sensor_resync(sensor);
+        }
+        else if(0 == rec_frame->hdr.length)
+        {
+            spi_log_write(SPI_LOG_FRAME_NAK, 0, 0);
+        }
+        else if(rec_frame->hdr.seq == send_frame->hdr.seq)
+        {
+            break;
+        }
+    }
+    sensor->stats.retries += MIN(attempt, FRAME_RETRANSMITS);
+#if ( SPI_LINK_TRAINING )
+    spi_link_monitor(sensor, (0 != attempt) ? WICED_TRUE : WICED_FALSE);
+#endif
+    return (attempt <= FRAME_RETRANSMITS) ? WICED_TRUE : WICED_FALSE;
+}
+
+/*******************************************************************************
+ Function name:  spi_sensor_samples
+
+ Function Description:
+ @brief    Reports the temperature samples of a burst read, oldest first.
+
+ @param    *sensor      sensor the samples come from
+ @param    *record      reply record of READ_SAMPLES
+ @param    max_samples  number of samples that were asked for
+
+ @return   wiced_bool_t  WICED_TRUE if the record is well formed
+ ******************************************************************************/
+
+static wiced_bool_t spi_sensor_samples(spi_sensor *sensor,
+                                       const frame_record *record,
+                                       uint32_t max_samples)
+{
+    uint32_t count = record->length / sizeof(int16_t);
+    uint32_t i;
+    int16_t data;
+
+    if((record->length % sizeof(int16_t)) || (count > max_samples))
+    {
+        return WICED_FALSE;
+    }
+    for(i = 0; i < count; i++)
+    {
+        data = (int16_t)(record->data[2 * i] | (record->data[2 * i + 1] << 8));
+        spi_sensor_reading(sensor, data);
+    }
+    sensor->samples_pending = (count == max_samples) ? WICED_TRUE : WICED_FALSE;
+    return WICED_TRUE;
+}
+
+#if ( SPI_PACKED_SAMPLES )
+/*******************************************************************************
+ Function name:  spi_sensor_packed_samples
+
+ Function Description:
+ @brief    Decodes and reports the temperature samples of a packed burst
+           read, oldest first.
+
+ @param    *sensor      sensor the samples come from
+ @param    *record      reply record of READ_PACKED_SAMPLES
+ @param    max_samples  number of samples that were asked for
+
+ @return   wiced_bool_t  WICED_TRUE if the record is well formed
+ ******************************************************************************/
+
+static wiced_bool_t spi_sensor_packed_samples(spi_sensor *sensor,
+                                              const frame_record *record,
+                                              uint32_t max_samples)
+{
+    int16_t samples[PACKED_SAMPLES_MAX];
+    uint32_t count;
+    uint32_t i;
+
+    if((record->length < 1) ||
+       !spi_delta_decode(&record->data[1], record->length - 1, samples,
+                         MIN(max_samples, PACKED_SAMPLES_MAX), &count))
+    {
+        return WICED_FALSE;
+    }
+    for(i = 0; i < count; i++)
+    {
+        spi_sensor_reading(sensor, samples[i]);
+    }
+    /* The sensor says how many samples it still holds*/
+    sensor->samples_pending = (0 != record->data[0]) ? WICED_TRUE : WICED_FALSE;
+    return WICED_TRUE;
+}
+#endif
+
+#if ( SPI_REGISTER_READS )
+/*******************************************************************************
+ Function name:  spi_sensor_registers
+
+ Function Description:
+ @brief    Reports the temperature samples of a register burst read, oldest
+           first, and the samples the sensor dropped since the last read.
+
+ @param    *sensor      sensor the registers come from
+ @param    *record      reply record of READ_REGISTERS from
+                        REG_REPORT_THRESHOLD on
+
+ @return   wiced_bool_t  WICED_TRUE if the record is well formed
+ ******************************************************************************/
+
+static wiced_bool_t spi_sensor_registers(spi_sensor *sensor,
+                                         const frame_record *record)
+{
+    const uint8_t *status = &record->data[REG_SAMPLES_PENDING - REG_REPORT_THRESHOLD];
+    uint16_t pending;
+    uint16_t dropped;
+    uint32_t offset;
+    int16_t data;
+
+    if((record->length < REG_SAMPLES - REG_REPORT_THRESHOLD) ||
+       (record->length & 1))
+    {
+        return WICED_FALSE;
+    }
+    for(offset = REG_SAMPLES - REG_REPORT_THRESHOLD;
+        offset < record->length; offset += sizeof(int16_t))
+    {
+        data = (int16_t)(record->data[offset] | (record->data[offset + 1] << 8));
+        spi_sensor_reading(sensor, data);
+    }
+
+    /* The status registers were read before the samples were taken*/
+    pending = (uint16_t)(status[0] | (status[1] << 8));
+    dropped = (uint16_t)(status[2] | (status[3] << 8));
+    sensor->samples_pending =
+        (pending > (record->length - (REG_SAMPLES - REG_REPORT_THRESHOLD)) /
+                   sizeof(int16_t)) ? WICED_TRUE : WICED_FALSE;
+    if(sensor->dropped_valid && (dropped != sensor->samples_dropped))
+    {
+        spi_log_write(SPI_LOG_SAMPLES_DROPPED,
+                      (uint16_t)(dropped - sensor->samples_dropped), 0);
+    }
+    sensor->samples_dropped = dropped;
+    sensor->dropped_valid = WICED_TRUE;
+    return WICED_TRUE;
+}
+#endif
+
+#if ( SPI_TIMED_SAMPLES )
+/*******************************************************************************
+ Function name:  spi_sensor_timed_samples
+
+ Function Description:
+ @brief    Reports the temperature samples of a timed burst read, oldest
+           first, each at the time the sensor took it, and keeps track of
+           how old the samples were when they arrived. Until the clocks are
+           synced the newest sample is taken to be read just now.
+
+ @param    *sensor      sensor the samples come from
+ @param    *record      reply record of READ_TIMED_SAMPLES
+ @param    max_samples  number of samples that were asked for
+
+ @return   wiced_bool_t  WICED_TRUE if the record is well formed
+ ******************************************************************************/
+
+static wiced_bool_t spi_sensor_timed_samples(spi_sensor *sensor,
+                                             const frame_record *record,
+                                             uint32_t max_samples)
+{
+    int16_t samples[TIMED_SAMPLES_MAX_PER_RECORD];
+    uint32_t times_ms[TIMED_SAMPLES_MAX_PER_RECORD];
+    uint64_t now_us = clock_SystemTimeMicroseconds64();
+    uint64_t time_us;
+    uint32_t age_ms;
+    uint32_t count;
+    uint32_t i;
+
+    if(!spi_timed_samples_unpack(record->data, record->length, samples, times_ms,
+                                 MIN(max_samples, TIMED_SAMPLES_MAX_PER_RECORD),
+                                 &count))
+    {
+        return WICED_FALSE;
+    }
+    if(!sensor->clock_synced && count)
+    {
+        sensor->clock_master_us = now_us;
+        sensor->clock_slave_ms  = times_ms[count - 1];
+    }
+    for(i = 0; i < count; i++)
+    {
+        /* Within the error of the offset a sample may seem to come from
+           the future*/
+        time_us = MIN(spi_clock_to_master(sensor, times_ms[i]), now_us);
+        spi_sensor_timed_reading(sensor, samples[i], (uint32_t)(time_us / 1000));
+        if(sensor->clock_synced)
+        {
+            age_ms = (uint32_t)((now_us - time_us) / 1000);
+            sensor->sample_ages++;
+            sensor->sample_age_sum_ms += age_ms;
+            sensor->sample_age_max_ms = MAX(sensor->sample_age_max_ms, age_ms);
+        }
+    }
+    sensor->samples_pending = (count == max_samples) ? WICED_TRUE : WICED_FALSE;
+    return WICED_TRUE;
+}
+#endif
+
+#if ( SPI_ADC_SCAN )
+/*******************************************************************************
+ Function name:  spi_sensor_adc_scan
+
+ Function Description:
+ @brief    Reports the channels of an ADC scan the first time it is read. A
+           sensor that could not answer the scan, for lack of room in the
+           reply or because it does not know the command, only misses it.
+
+ @param    *sensor      sensor the scan comes from
+ @param    *record      reply record of READ_ADC_SCAN, empty until the sensor
+                        has completed a scan
+
+ @return   wiced_bool_t  WICED_TRUE if the record is well formed
+ ******************************************************************************/
+
+static wiced_bool_t spi_sensor_adc_scan(spi_sensor *sensor,
+                                        const frame_record *record)
+{
+    adc_scan scan;
+    uint32_t i;
+
+    if(record->cmd & RECORD_ERROR)
+    {
+        spi_log_write(SPI_LOG_UNSUPPORTED, READ_ADC_SCAN, 0);
+        return WICED_TRUE;
+    }
+    if(0 == record->length)
+    {
+        return WICED_TRUE;
+    }
+    if(!spi_adc_scan_unpack(&scan, record->data, record->length))
+    {
+        return WICED_FALSE;
+    }
+    if(sensor->scan_valid && (scan.time_ms == sensor->scan.time_ms))
+    {
+        /* Read before, the next scan is not complete yet*/
+        return WICED_TRUE;
+    }
+    for(i = 0; i < scan.count; i++)
+    {
+        spi_log_write(SPI_LOG_ADC_CHANNEL, scan.channel[i], scan.mv[i]);
+    }
+    sensor->scan = scan;
+    sensor->scan_valid = WICED_TRUE;
+    sensor->scans++;
+    return WICED_TRUE;
+}
+#endif
+
+#if ( SPI_SUMMARY_READS )
+/*******************************************************************************
+ Function name:  spi_sensor_summary
+
+ Function Description:
+ @brief    Reports the temperature summary of a summary window the first time
+           it is read, and how many windows were missed since the last one.
+
+ @param    *sensor      sensor the summary comes from
+ @param    *record      reply record of GET_SUMMARY, empty until the sensor
+                        has completed a window
+
+ @return   wiced_bool_t  WICED_TRUE if the record is well formed
+ ******************************************************************************/
+
+static wiced_bool_t spi_sensor_summary(spi_sensor *sensor,
+                                       const frame_record *record)
+{
+    temperature_summary summary;
+    uint16_t missed;
+
+    if(0 == record->length)
+    {
+        return WICED_TRUE;
+    }
+    if(SUMMARY_WIRE_SIZE != record->length)
+    {
+        return WICED_FALSE;
+    }
+    spi_summary_unpack(&summary, record->data);
+    if(sensor->summary_valid)
+    {
+        if(summary.window == sensor->summary_window)
+        {
+            /* Read before, the next window is not complete yet*/
+            return WICED_TRUE;
+        }
+        missed = summary.window - sensor->summary_window - 1;
+        if(missed)
+        {
+            spi_log_write(SPI_LOG_SUMMARY_MISSED, missed, 0);
+        }
+    }
+    sensor->summary_window = summary.window;
+    sensor->summary_valid = WICED_TRUE;
+
+    /* Fractional parts cannot be negative */
+    spi_log_write(SPI_LOG_SUMMARY, summary.window, summary.count);
+    spi_log_write(SPI_LOG_SUMMARY_MIN,
+                  summary.min / NORM_FACTOR, ABS(summary.min % NORM_FACTOR));
+    spi_log_write(SPI_LOG_SUMMARY_MAX,
+                  summary.max / NORM_FACTOR, ABS(summary.max % NORM_FACTOR));
+    spi_log_write(SPI_LOG_SUMMARY_MEAN,
+                  summary.mean / NORM_FACTOR, ABS(summary.mean % NORM_FACTOR));
+    return WICED_TRUE;
+}
+#endif
+#endif
+
+/*******************************************************************************
+ Function name: spi_sensor_utility
+
+ Function Description:
+ @brief    function that performs SPI transactions with SPI sensor
+
+ @param   *sensor    sensor to select.
+ @param   *send_msg  pointer to the data packet that is sent.
+*@param   *rec_msg   pointer to the data packet that is received.
+
+ @return void
+ ******************************************************************************/
+
+void spi_sensor_utility(spi_sensor *sensor, data_packet *send_msg,
+                        data_packet *rec_msg)
+{
+    uint64_t start_us;
+
+    spi_wait_for_slave_ready(sensor);
+    start_us = clock_SystemTimeMicroseconds64();
+
+    /* Chip select is set to LOW to select the slave for SPI transactions*/
+    wiced_hal_gpio_set_pin_output(sensor->cs_pin, GPIO_PIN_OUTPUT_LOW);
+
+    spi_log_write(SPI_LOG_SENDING, 0, 0);
+
+    spi_clear_data_ready();
+
+    /* Sending command to slave*/
+    wiced_hal_pspi_tx_data(SPI,
+                           sizeof(*send_msg),
+                           (uint8_t*)send_msg);
+    /*Allowing slave time to fill its rx buffers before receiving*/
+    spi_wait_for_response(sensor);
+
+    spi_log_write(SPI_LOG_RECEIVING, 0, 0);
+
+    /* Receving response from slave*/
+    wiced_hal_pspi_rx_data(SPI,
+                           sizeof(*rec_msg),
+                           (uint8_t*)rec_msg);
+    /* Chip select is set to HIGH to unselect the slave for SPI transactions*/
+    wiced_hal_gpio_set_pin_output(sensor->cs_pin, GPIO_PIN_OUTPUT_HIGH);
+
+    spi_stats_add_transaction(&sensor->stats,
+                              (uint32_t)(clock_SystemTimeMicroseconds64() - start_us));
+    spi_count_reply(sensor, (PACKET_HEADER == rec_msg->header) ? WICED_TRUE : WICED_FALSE,
+                    rec_msg->header);
     return;
 }
+
+#if ( SPI_BATCHED_FRAMES )
+/*******************************************************************************
+ Function name: spi_sensor_frame_utility
+
+ Function Description:
+ @brief    function that exchanges one frame with the SPI sensor. The request
+           frame and the reply frame share a single chip select window.
+
+ @param   *sensor      sensor to select.
+ @param   *send_frame  pointer to the frame that is sent.
+*@param   *rec_frame   pointer to the frame that is received.
+
+ @return wiced_bool_t  WICED_TRUE if a reply frame with a matching CRC was
+                       received
+ ******************************************************************************/
+
+wiced_bool_t spi_sensor_frame_utility(spi_sensor *sensor,
+                                      spi_frame *send_frame,
+                                      spi_frame *rec_frame)
+{
+    wiced_bool_t valid = WICED_FALSE;
+    uint64_t start_us;
+
+    spi_wait_for_slave_ready(sensor);
+    start_us = clock_SystemTimeMicroseconds64();
+
+#if ( SPI_CHANGE_REPORTING )
+    selected_sensor = sensor;
+#endif
+    /* Chip select is set to LOW to select the slave for SPI transactions*/
+    wiced_hal_gpio_set_pin_output(sensor->cs_pin, GPIO_PIN_OUTPUT_LOW);
+
+    spi_clear_data_ready();
+
+    /* Sending all commands to slave in one go*/
+    wiced_hal_pspi_tx_data(SPI,
+                           spi_frame_size(send_frame),
+                           (uint8_t*)send_frame);
+    spi_wait_for_response(sensor);
+
+    /* The reply header tells how much payload follows*/
+    wiced_hal_pspi_rx_data(SPI,
+                           sizeof(rec_frame->hdr),
+                           (uint8_t*)&rec_frame->hdr);
+    if(spi_frame_header_valid(&rec_frame->hdr))
+    {
+        wiced_hal_pspi_rx_data(SPI,
+                               rec_frame->hdr.length + FRAME_CRC_SIZE,
+                               rec_frame->payload);
+        valid = spi_frame_crc_valid(rec_frame);
+    }
+
+    /* Chip select is set to HIGH to unselect the slave for SPI transactions*/
+    wiced_hal_gpio_set_pin_output(sensor->cs_pin, GPIO_PIN_OUTPUT_HIGH);
+#if ( SPI_CHANGE_REPORTING )
+    selected_sensor = NULL;
+#endif
+
+    spi_stats_add_transaction(&sensor->stats,
+                              (uint32_t)(clock_SystemTimeMicroseconds64() - start_us));
+    spi_count_reply(sensor, valid, rec_frame->hdr.header);
+    return valid;
+}
+
+/*******************************************************************************
+ Function name: spi_sensor_resync
+
+ Function Description:
+ @brief    Clocks a full frame of SPI_IDLE_BYTE through the slave, emptying
+           its TX FIFO of a reply that was not read completely. The slave
+           ignores the idle bytes, so both sides start the next frame in
+           step without resetting the interface.
+
+ @param   *sensor  sensor to resynchronize
+
+ @return void
+ ******************************************************************************/
+
+static void spi_sensor_resync( spi_sensor *sensor )
+{
+    uint8_t idle[FRAME_MAX_SIZE];
+
+    memset(idle, SPI_IDLE_BYTE, sizeof(idle));
+
+    wiced_hal_gpio_set_pin_output(sensor->cs_pin, GPIO_PIN_OUTPUT_LOW);
+    wiced_hal_pspi_tx_data(SPI, sizeof(idle), idle);
+    wiced_hal_gpio_set_pin_output(sensor->cs_pin, GPIO_PIN_OUTPUT_HIGH);
+}
+
+/*******************************************************************************
+ Function name: spi_frames_take
+
+ Function Description:
+ @brief    Takes the request and reply frame of an exchange from frame_pool.
+
+ @param   **send_frame  request frame
+ @param   **rec_frame   reply frame
+
+ @return  wiced_bool_t  WICED_TRUE if both frames were taken
+ ******************************************************************************/
+
+static wiced_bool_t spi_frames_take( spi_frame **send_frame,
+                                     spi_frame **rec_frame )
+{
+    *send_frame = spi_pool_take(&frame_pool);
+    *rec_frame = spi_pool_take(&frame_pool);
+    if((NULL == *send_frame) || (NULL == *rec_frame))
+    {
+        spi_frames_give(*send_frame, *rec_frame);
+        return WICED_FALSE;
+    }
+    return WICED_TRUE;
+}
+
+/*******************************************************************************
+ Function name: spi_frames_give
+
+ Function Description:
+ @brief    Gives the frames of an exchange back to frame_pool.
+
+ @param   *send_frame  request frame, or NULL
+ @param   *rec_frame   reply frame, or NULL
+
+ @return void
+ ******************************************************************************/
+
+static void spi_frames_give( spi_frame *send_frame, spi_frame *rec_frame )
+{
+    spi_pool_give(&frame_pool, send_frame);
+    spi_pool_give(&frame_pool, rec_frame);
+}
+#endif
+
+#if ( SPI_ASYNC_REQUESTS )
+/*******************************************************************************
+ Function name: spi_master_submit
+
+ Function Description:
+ @brief    Queues a register read or write for the SPI thread and returns at
+           once, see spi_master.h. A read of the same registers of the same
+           sensor that is still pending, with no write to the sensor queued
+           behind it, is joined instead of being sent again.
+
+ @param   *request  request, owned by the SPI thread until it is completed
+
+ @return  wiced_result_t  WICED_SUCCESS if the request was queued,
+                          WICED_BADARG if it is malformed,
+                          WICED_NOT_AVAILABLE before the master is started
+ ******************************************************************************/
+
+wiced_result_t spi_master_submit( spi_request *request )
+{
+    spi_request *pending;
+    spi_request *joined = NULL;
+    spi_sensor *sensor;
+
+    if((NULL == request) || (NULL == request->cback) ||
+       (request->sensor >= SENSOR_COUNT) ||
+       ((SPI_REQUEST_READ != request->type) &&
+        (SPI_REQUEST_WRITE != request->type)) ||
+       (0 == request->length) || (request->address & 1) ||
+       (request->length & 1) ||
+       ((request->address + request->length) > SPI_REQUEST_MAX_DATA))
+    {
+        return WICED_BADARG;
+    }
+    if(NULL == thread_wake)
+    {
+        return WICED_NOT_AVAILABLE;
+    }
+    sensor = &spi_sensors[request->sensor];
+    request->next = NULL;
+    request->coalesced = NULL;
+
+    wiced_rtos_lock_mutex(requests_lock);
+    if(SPI_REQUEST_READ == request->type)
+    {
+        for(pending = requests_head; NULL != pending; pending = pending->next)
+        {
+            if(pending->sensor != request->sensor)
+            {
+                continue;
+            }
+            /* The read must not return what a later write changes*/
+            if(SPI_REQUEST_WRITE == pending->type)
+            {
+                joined = NULL;
+            }
+            else if((pending->address == request->address) &&
+                    (pending->length == request->length))
+            {
+                joined = pending;
+            }
+        }
+    }
+    sensor->requests++;
+    if(NULL != joined)
+    {
+        /* Completed after the read joined, in the order submitted*/
+        while(NULL != joined->coalesced)
+        {
+            joined = joined->coalesced;
+        }
+        joined->coalesced = request;
+        sensor->coalesced++;
+    }
+    else if(NULL == requests_tail)
+    {
+        requests_head = request;
+        requests_tail = request;
+    }
+    else
+    {
+        requests_tail->next = request;
+        requests_tail = request;
+    }
+    wiced_rtos_unlock_mutex(requests_lock);
+
+    if(NULL == joined)
+    {
+        wiced_rtos_set_semaphore(thread_wake);
+    }
+    return WICED_SUCCESS;
+}
+
+/*******************************************************************************
+ Function name: spi_master_request_take
+
+ Function Description:
+ @brief    Takes a request from the static request pool, for submitters that
+           keep no request of their own. Any thread may call this.
+
+ @param   void
+
+ @return  spi_request*  cleared request, NULL if the pool is empty
+ ******************************************************************************/
+
+spi_request *spi_master_request_take( void )
+{
+    spi_request *request;
+
+    if(NULL == requests_lock)
+    {
+        return NULL;
+    }
+    wiced_rtos_lock_mutex(requests_lock);
+    request = spi_pool_take(&request_pool);
+    wiced_rtos_unlock_mutex(requests_lock);
+    if(NULL != request)
+    {
+        memset(request, 0, sizeof(*request));
+    }
+    return request;
+}
+
+/*******************************************************************************
+ Function name: spi_master_request_give
+
+ Function Description:
+ @brief    Gives a request taken with spi_master_request_take() back once it
+           is completed; may be called from its completion callback.
+
+ @param   *request  completed request
+
+ @return void
+ ******************************************************************************/
+
+void spi_master_request_give( spi_request *request )
+{
+    wiced_rtos_lock_mutex(requests_lock);
+    spi_pool_give(&request_pool, request);
+    wiced_rtos_unlock_mutex(requests_lock);
+}
+
+/*******************************************************************************
+ Function name: spi_requests_serve
+
+ Function Description:
+ @brief    Serves the oldest pending requests of one sensor in one frame:
+           the request at the head of the queue and the requests of the same
+           sensor behind it, in order, as long as they and their replies fit
+           in a frame. Requests for a sensor that is not detected fail.
+
+ @param   void
+
+ @return  wiced_bool_t  WICED_TRUE if requests are left pending
+ ******************************************************************************/
+
+static wiced_bool_t spi_requests_serve( void )
+{
+    spi_request *batch[FRAME_MAX_PAYLOAD / (sizeof(frame_record) +
+                                            REGISTER_READ_WIRE_SIZE)];
+    spi_request **link;
+    spi_request *request;
+    spi_sensor *sensor;
+    spi_frame *send_frame;
+    spi_frame *rec_frame;
+    const frame_record *record;
+    uint8_t data[SPI_REQUEST_MAX_DATA + 1];
+    uint32_t send_room = FRAME_MAX_PAYLOAD;
+    uint32_t reply_room = FRAME_MAX_PAYLOAD;
+    uint32_t send_size;
+    uint32_t reply_size;
+    uint32_t offset = 0;
+    uint32_t count = 0;
+    uint32_t i;
+    wiced_bool_t left;
+    wiced_result_t result;
+
+    /* Requests stay queued until frames are free*/
+    if(!spi_frames_take(&send_frame, &rec_frame))
+    {
+        return WICED_FALSE;
+    }
+    wiced_rtos_lock_mutex(requests_lock);
+    if(NULL == requests_head)
+    {
+        wiced_rtos_unlock_mutex(requests_lock);
+        spi_frames_give(send_frame, rec_frame);
+        return WICED_FALSE;
+    }
+    sensor = &spi_sensors[requests_head->sensor];
+    requests_tail = NULL;
+    for(link = &requests_head; NULL != (request = *link); )
+    {
+        if(&spi_sensors[request->sensor] == sensor)
+        {
+            send_size = sizeof(frame_record) +
+                        ((SPI_REQUEST_READ == request->type) ?
+                         REGISTER_READ_WIRE_SIZE : (1 + request->length));
+            reply_size = sizeof(frame_record) +
+                         ((SPI_REQUEST_READ == request->type) ?
+                          request->length : 0);
+            if((send_size > send_room) || (reply_size > reply_room) ||
+               (count == sizeof(batch) / sizeof(batch[0])))
+            {
+                /* Later requests of the sensor stay behind this one*/
+                sensor = NULL;
+            }
+            else
+            {
+                send_room -= send_size;
+                reply_room -= reply_size;
+                batch[count++] = request;
+                *link = request->next;
+                continue;
+            }
+        }
+        requests_tail = request;
+        link = &request->next;
+    }
+    left = (NULL != requests_head) ? WICED_TRUE : WICED_FALSE;
+    wiced_rtos_unlock_mutex(requests_lock);
+
+    sensor = &spi_sensors[batch[0]->sensor];
+    if(READ_TEMPERATURE != sensor->state)
+    {
+        for(i = 0; i < count; i++)
+        {
+            spi_request_complete(batch[i], WICED_NOT_AVAILABLE, NULL);
+        }
+        spi_frames_give(send_frame, rec_frame);
+        return left;
+    }
+
+#if ( SPI_LINK_TRAINING )
+    spi_link_set_clock(sensor->clock_hz ? sensor->clock_hz : DEFAULT_FREQUENCY);
+#endif
+    spi_frame_init(send_frame);
+    for(i = 0; i < count; i++)
+    {
+        request = batch[i];
+        data[0] = request->address;
+        if(SPI_REQUEST_READ == request->type)
+        {
+            data[1] = request->length;
+            spi_frame_add(send_frame, READ_REGISTERS,
+                          REGISTER_READ_WIRE_SIZE, data);
+        }
+        else
+        {
+            memcpy(&data[1], request->data, request->length);
+            spi_frame_add(send_frame, WRITE_REGISTERS,
+                          1 + request->length, data);
+        }
+    }
+    spi_frame_seal(send_frame, ++sensor->frame_seq);
+    if(!spi_sensor_transfer(sensor, send_frame, rec_frame))
+    {
+        spi_log_write(SPI_LOG_FRAME_INVALID, 0, 0);
+        for(i = 0; i < count; i++)
+        {
+            spi_request_complete(batch[i], WICED_ERROR, NULL);
+        }
+        spi_frames_give(send_frame, rec_frame);
+        return left;
+    }
+
+    /* Replies come in request order*/
+    for(i = 0; i < count; i++)
+    {
+        request = batch[i];
+        record = spi_frame_next(rec_frame, &offset);
+        result = WICED_ERROR;
+        if(NULL != record)
+        {
+            if(((SPI_REQUEST_READ == request->type) ?
+                READ_REGISTERS : WRITE_REGISTERS) != record->cmd)
+            {
+                if(record->cmd & RECORD_ERROR)
+                {
+                    result = WICED_BADARG;
+                }
+            }
+            else if((SPI_REQUEST_WRITE == request->type) ||
+                    (request->length == record->length))
+            {
+                result = WICED_SUCCESS;
+            }
+        }
+        spi_request_complete(request, result,
+                             ((WICED_SUCCESS == result) &&
+                              (SPI_REQUEST_READ == request->type)) ?
+                             record->data : NULL);
+    }
+    spi_frames_give(send_frame, rec_frame);
+    return left;
+}
+
+/*******************************************************************************
+ Function name: spi_request_complete
+
+ Function Description:
+ @brief    Completes a served request and the reads coalesced with it,
+           handing each the data read.
+
+ @param   *request  served request
+ @param   result    result of the request
+ @param   *data     registers read, NULL for writes and failed reads
+
+ @return void
+ ******************************************************************************/
+
+static void spi_request_complete( spi_request *request, wiced_result_t result,
+                                  const uint8_t *data )
+{
+    spi_request *next;
+
+    while(NULL != request)
+    {
+        /* The callback may submit the request again*/
+        next = request->coalesced;
+        if(NULL != data)
+        {
+            memcpy(request->data, data, request->length);
+        }
+        request->cback(request, result);
+        request = next;
+    }
+}
+#endif
+
+#if ( SPI_REQUEST_CLIENTS )
+/*******************************************************************************
+ Function name: spi_request_client_thread
+
+ Function Description:
+ @brief    Sample client of the request interface: reads the temperature
+           register of the first sensor every SPI_REQUEST_CLIENT_PERIOD_MS
+           and waits for the completion without touching the bus.
+
+ @param    arg  index of the client in request_clients
+
+ @return   none
+ ******************************************************************************/
+
+static void spi_request_client_thread( uint32_t arg )
+{
+    spi_request_client *client = &request_clients[arg];
+    spi_request *request;
+    int16_t data;
+
+    while(WICED_TRUE)
+    {
+        wiced_rtos_delay_milliseconds(SPI_REQUEST_CLIENT_PERIOD_MS,
+                                      ALLOW_THREAD_TO_SLEEP);
+        if(NULL == (request = spi_master_request_take()))
+        {
+            continue;
+        }
+        request->sensor = 0;
+        request->type = SPI_REQUEST_READ;
+        request->address = REG_TEMPERATURE;
+        request->length = sizeof(int16_t);
+        request->cback = spi_request_client_done;
+        request->context = client;
+        if(WICED_SUCCESS == spi_master_submit(request))
+        {
+            wiced_rtos_get_semaphore(client->done, WICED_WAIT_FOREVER);
+            if(WICED_SUCCESS == client->result)
+            {
+                data = (int16_t)(request->data[0] | (request->data[1] << 8));
+                /* Fractional part cannot be negative */
+                WICED_BT_TRACE("Client read %d.%02d\n\r", data / NORM_FACTOR,
+                               ABS(data % NORM_FACTOR));
+            }
+        }
+        spi_master_request_give(request);
+    }
+}
+
+/*******************************************************************************
+ Function name: spi_request_client_done
+
+ Function Description:
+ @brief    Completion callback of the sample clients, runs on the SPI thread
+           and wakes the client.
+
+ @param   *request  completed request
+ @param   result    result of the request
+
+ @return void
+ ******************************************************************************/
+
+static void spi_request_client_done( spi_request *request, wiced_result_t result )
+{
+    spi_request_client *client = request->context;
+
+    client->result = result;
+    wiced_rtos_set_semaphore(client->done);
+}
+#endif
+
+#if ( SPI_LINK_TRAINING )
+/*******************************************************************************
+ Function name: spi_link_train
+
+ Function Description:
+ @brief    Finds the fastest SPI clock the link to the sensor carries
+           reliably. Starting from DEFAULT_FREQUENCY, each step of
+           link_clock_steps is probed with LINK_PROBE_FRAMES frames; the
+           first step with more than LINK_MAX_PROBE_ERRORS failures ends the
+           search and the clock backs off to the step before it.
+
+ @param    *sensor  sensor to train the clock for
+
+ @return void
+ ******************************************************************************/
+
+static void spi_link_train( spi_sensor *sensor )
+{
+    uint32_t step;
+    uint32_t good = 0;
+    uint32_t errors;
+
+    for(step = 0;
+        step < sizeof(link_clock_steps) / sizeof(link_clock_steps[0]);
+        step++)
+    {
+        spi_link_set_clock(link_clock_steps[step]);
+        errors = spi_link_probe(sensor);
+        WICED_BT_TRACE("Link training: %d Hz, %d errors\n\r",
+                       link_clock_steps[step], errors);
+        if(errors > LINK_MAX_PROBE_ERRORS)
+        {
+            break;
+        }
+        good = step;
+    }
+    if(good != step)
+    {
+        spi_link_set_clock(link_clock_steps[good]);
+    }
+    WICED_BT_TRACE("SPI clock set to %d Hz\n\r", link_clock_steps[good]);
+
+    sensor->clock_hz       = link_clock_steps[good];
+    sensor->link_exchanges = 0;
+    sensor->link_errors    = 0;
+}
+
+/*******************************************************************************
+ Function name: spi_link_probe
+
+ Function Description:
+ @brief    Exchanges LINK_PROBE_FRAMES frames asking for the Manufacturer ID,
+           which has no side effects on the sensor, at the current clock.
+
+ @param    *sensor  sensor to probe
+
+ @return uint32_t  number of probes without a correct reply
+ ******************************************************************************/
+
+static uint32_t spi_link_probe( spi_sensor *sensor )
+{
+    spi_frame *send_frame;
+    spi_frame *rec_frame;
+    const frame_record *record;
+    uint32_t offset;
+    uint32_t errors = 0;
+    uint32_t i;
+
+    if(!spi_frames_take(&send_frame, &rec_frame))
+    {
+        return LINK_PROBE_FRAMES;
+    }
+    for(i = 0; i < LINK_PROBE_FRAMES; i++)
+    {
+        spi_frame_init(send_frame);
+        spi_frame_add(send_frame, GET_MANUFACTURER_ID, 0, NULL);
+        spi_frame_seal(send_frame, ++sensor->frame_seq);
+
+        offset = 0;
+        if(!spi_sensor_frame_utility(sensor, send_frame, rec_frame))
+        {
+            /* Leave no partial reply behind for the next probe*/
+            spi_sensor_resync(sensor);
+            errors++;
+        }
+        else if((rec_frame->hdr.seq != send_frame->hdr.seq) ||
+                (NULL == (record = spi_frame_next(rec_frame, &offset))) ||
+                (GET_MANUFACTURER_ID != record->cmd) ||
+                (sizeof(int16_t) != record->length) ||
+                (MANUFACTURER_ID != spi_record_int16(record)))
+        {
+            errors++;
+        }
+    }
+    spi_frames_give(send_frame, rec_frame);
+    return errors;
+}
+
+/*******************************************************************************
+ Function name: spi_link_set_clock
+
+ Function Description:
+ @brief    Initializes the SPI interface again if it runs at another clock.
+
+ @param    clock  SPI clock in Hz
+
+ @return void
+ ******************************************************************************/
+
+static void spi_link_set_clock( uint32_t clock )
+{
+    if(clock == bus_clock)
+    {
+        return;
+    }
+    bus_clock = clock;
+    wiced_hal_pspi_init(SPI,
+                        clock,
+                        SPI_LSB_FIRST,
+                        SPI_SS_ACTIVE_LOW,
+                        SPI_MODE_0);
+}
+
+/*******************************************************************************
+ Function name: spi_link_monitor
+
+ Function Description:
+ @brief    Keeps track of the exchanges that needed a retransmit and has the
+           clock trained again when they spike, as they do when the link
+           degrades at the trained clock.
+
+ @param    *sensor        sensor of the exchange
+ @param    retransmitted  WICED_TRUE if the last exchange was retransmitted
+
+ @return void
+ ******************************************************************************/
+
+static void spi_link_monitor( spi_sensor *sensor, wiced_bool_t retransmitted )
+{
+    if(!sensor->clock_hz)
+    {
+        return;
+    }
+    sensor->link_exchanges++;
+    if(retransmitted)
+    {
+        sensor->link_errors++;
+    }
+    if(sensor->link_errors >= LINK_RETRAIN_ERRORS)
+    {
+        WICED_BT_TRACE("Link errors, training the SPI clock again\n\r");
+        spi_link_set_clock(DEFAULT_FREQUENCY);
+        sensor->clock_hz = 0;
+    }
+    else if(sensor->link_exchanges >= LINK_MONITOR_EXCHANGES)
+    {
+        sensor->link_exchanges = 0;
+        sensor->link_errors    = 0;
+    }
+}
+#endif
+
+#if ( SPI_CLOCK_SYNC )
+/*******************************************************************************
+ Function name: spi_clock_sync
+
+ Function Description:
+ @brief    Measures the offset of the sensor clock to the master clock with
+           CLOCK_SYNC_EXCHANGES time commands. The sensor reads its clock
+           between the request leaving and the reply arriving, so the middle
+           of that round trip is taken as the time it read; the exchange
+           with the shortest round trip is kept. Each exchange is sent once,
+           as a reply resent from an earlier request would carry a stale
+           time. A failed measurement keeps the last offset.
+
+ @param    *sensor  sensor in READ_TEMPERATURE
+ @param    now_ms   current time
+
+ @return void
+ ******************************************************************************/
+
+static void spi_clock_sync( spi_sensor *sensor, uint64_t now_ms )
+{
+    spi_frame *send_frame;
+    spi_frame *rec_frame;
+    const frame_record *record;
+    slave_time time;
+    uint64_t start_us;
+    uint32_t round_trip_us;
+    uint32_t best_us = 0;
+    wiced_bool_t measured = WICED_FALSE;
+    uint32_t offset;
+    uint32_t i;
+
+    sensor->next_sync_ms = now_ms + SPI_CLOCK_SYNC_PERIOD_MS;
+    if(!spi_frames_take(&send_frame, &rec_frame))
+    {
+        return;
+    }
+    for(i = 0; i < CLOCK_SYNC_EXCHANGES; i++)
+    {
+        spi_frame_init(send_frame);
+        spi_frame_add(send_frame, GET_TIME, 0, NULL);
+        spi_frame_seal(send_frame, ++sensor->frame_seq);
+
+        offset = 0;
+        start_us = clock_SystemTimeMicroseconds64();
+        if(!spi_sensor_frame_utility(sensor, send_frame, rec_frame))
+        {
+            /* Leave no partial reply behind for the next exchange*/
+            spi_sensor_resync(sensor);
+            continue;
+        }
+        round_trip_us = (uint32_t)(clock_SystemTimeMicroseconds64() - start_us);
+        if((rec_frame->hdr.seq != send_frame->hdr.seq) ||
+           (NULL == (record = spi_frame_next(rec_frame, &offset))) ||
+           (GET_TIME != record->cmd) ||
+           (SLAVE_TIME_WIRE_SIZE != record->length) ||
+           (measured && (round_trip_us >= best_us)))
+        {
+            continue;
+        }
+        spi_slave_time_unpack(&time, record->data);
+        sensor->clock_master_us = start_us + round_trip_us / 2 - time.us;
+        sensor->clock_slave_ms  = time.ms;
+        best_us  = round_trip_us;
+        measured = WICED_TRUE;
+    }
+    spi_frames_give(send_frame, rec_frame);
+    if(measured)
+    {
+        sensor->clock_error_us = best_us / 2;
+        sensor->clock_synced   = WICED_TRUE;
+        sensor->clock_syncs++;
+        spi_log_write(SPI_LOG_CLOCK_SYNC, (int16_t)MIN(sensor->clock_error_us, 0x7FFF),
+                      (int32_t)((int64_t)(sensor->clock_master_us -
+                                          (uint64_t)sensor->clock_slave_ms * 1000) / 1000));
+    }
+}
+#endif
+
+#if ( SPI_TIMED_SAMPLES )
+/*******************************************************************************
+ Function name: spi_clock_to_master
+
+ Function Description:
+ @brief    Maps a time of the sensor clock to the master clock with the
+           offset last measured. The sensor time is taken to be within 24
+           days of the measurement, so that its wrapping does not matter.
+
+ @param    *sensor    sensor whose clock the time is of
+ @param    slave_ms   time of the sensor clock in milliseconds
+
+ @return uint64_t  time of the master clock in microseconds
+ ******************************************************************************/
+
+static uint64_t spi_clock_to_master( const spi_sensor *sensor, uint32_t slave_ms )
+{
+    return sensor->clock_master_us +
+           (int64_t)(int32_t)(slave_ms - sensor->clock_slave_ms) * 1000;
+}
+#endif
+
+/*******************************************************************************
+ Function name: spi_count_reply
+
+ Function Description:
+ @brief    Counts a reply that did not verify as invalid, and also as an
+           underrun when it consisted of idle bytes because the slave had
+           not loaded it in time.
+
+ @param    *sensor  sensor the reply came from
+ @param    valid    WICED_TRUE if the reply verified
+ @param    header   header field of the reply
+
+ @return   none
+ ******************************************************************************/
+
+static void spi_count_reply(spi_sensor *sensor, wiced_bool_t valid,
+                            uint16_t header)
+{
+    if(valid)
+    {
+        return;
+    }
+    sensor->stats.invalid++;
+    if(SPI_IDLE_HEADER == header)
+    {
+        sensor->stats.underruns++;
+    }
+}
+
+/*******************************************************************************
+ Function name: spi_clear_data_ready
+
+ Function Description:
+ @brief    Drops ready signals left over from earlier responses, so that only
+           the response to the next command releases spi_wait_for_response.
+
+ @return void
+ ******************************************************************************/
+
+static void spi_clear_data_ready( void )
+{
+#if ( SPI_HANDSHAKE_MODE == SPI_HANDSHAKE_READY_GPIO )
+    while(WICED_SUCCESS == wiced_rtos_get_semaphore(data_ready, WICED_NO_WAIT))
+    {
+    }
+#endif
+}
+
+/*******************************************************************************
+ Function name: spi_wait_for_slave_ready
+
+ Function Description:
+ @brief    Waits until the slave has taken back the data ready signal of its
+           last response, which it does once it can receive a new command.
+           Only matters when commands follow each other closely; the wait is
+           bounded by TX_RX_TIMEOUT.
+
+ @param  *sensor  sensor about to be selected
+
+ @return void
+ ******************************************************************************/
+
+static void spi_wait_for_slave_ready( spi_sensor *sensor )
+{
+#if ( SPI_HANDSHAKE_MODE == SPI_HANDSHAKE_READY_GPIO )
+    uint32_t waited;
+
+    for(waited = 0;
+        wiced_hal_gpio_get_pin_input_status(sensor->drdy_pin) &&
+        (waited < TX_RX_TIMEOUT * 1000);
+        waited += READY_POLL_INTERVAL_US)
+    {
+        wiced_rtos_delay_microseconds(READY_POLL_INTERVAL_US);
+    }
+#endif
+}
+
+/*******************************************************************************
+ Function name: spi_wait_for_response
+
+ Function Description:
+ @brief    Waits until the slave has loaded its response to the command just
+           sent. With SPI_HANDSHAKE_READY_GPIO this returns on the rising edge
+           of the sensor's data ready pin and uses TX_RX_TIMEOUT only as the
+           upper bound. The interrupt is shared by all sensors, so an edge
+           only counts while the pin of this sensor is high.
+
+ @param  *sensor  selected sensor
+
+ @return void
+ ******************************************************************************/
+
+static void spi_wait_for_response( spi_sensor *sensor )
+{
+#if ( SPI_HANDSHAKE_MODE == SPI_HANDSHAKE_READY_GPIO )
+    uint64_t now_us = clock_SystemTimeMicroseconds64();
+    uint64_t deadline_us = now_us + (uint64_t)TX_RX_TIMEOUT * 1000;
+
+    while((now_us < deadline_us) &&
+          (WICED_SUCCESS == wiced_rtos_get_semaphore(data_ready,
+                                (uint32_t)((deadline_us - now_us + 999) / 1000))))
+    {
+        if(wiced_hal_gpio_get_pin_input_status(sensor->drdy_pin))
+        {
+            return;
+        }
+        /* Edge of another sensor, such as a change it signals*/
+        now_us = clock_SystemTimeMicroseconds64();
+    }
+    if(!sensor->data_ready_missing)
+    {
+        /* Slaves without the handshake are still served after the fixed
+           delay, which has elapsed by now*/
+        WICED_BT_TRACE("No data ready signal, using fixed delay\n\r");
+        sensor->data_ready_missing = WICED_TRUE;
+    }
+#else
+    (void)sensor;
+    wiced_rtos_delay_milliseconds(TX_RX_TIMEOUT, ALLOW_THREAD_TO_SLEEP);
+#endif
+}
+
+#if ( SPI_HANDSHAKE_MODE == SPI_HANDSHAKE_READY_GPIO )
+/*******************************************************************************
+ Function name: spi_data_ready_cback
+
+ Function Description:
+ @brief    Interrupt handler of the data ready pins, releases
+           spi_wait_for_response, or with SPI_CHANGE_REPORTING the idle wait
+           of spi_sensor_thread when a sensor signals a change. The edge of
+           the sensor selected for an exchange is its response and signals
+           no change.
+
+ @param  data      unused
+ @param  port_pin  pin that raised the interrupt
+
+ @return void
+ ******************************************************************************/
+
+static void spi_data_ready_cback( void *data, uint8_t port_pin )
+{
+#if ( SPI_CHANGE_REPORTING )
+    wiced_bool_t changed = WICED_FALSE;
+    uint32_t i;
+
+    for(i = 0; i < SENSOR_COUNT; i++)
+    {
+        if((spi_sensors[i].drdy_pin == port_pin) &&
+           (&spi_sensors[i] != selected_sensor))
+        {
+            spi_sensors[i].change_signaled = WICED_TRUE;
+            changed = WICED_TRUE;
+        }
+    }
+#endif
+    wiced_hal_gpio_clear_pin_interrupt_status(port_pin);
+    wiced_rtos_set_semaphore(data_ready);
+#if ( SPI_CHANGE_REPORTING )
+    if(changed)
+    {
+        wiced_rtos_set_semaphore(thread_wake);
+    }
+#endif
+}
+#endif
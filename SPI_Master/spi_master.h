@@ -0,0 +1,129 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+/*******************************************************************************
+ * @file spi_master.h
+ *
+ * @brief
+ * Request interface of the SPI master for threads other than the SPI thread.
+ *
+ * Only spi_sensor_thread drives the bus. Other threads, such as the BLE and
+ * application logic, read and write the registers of a sensor, see the
+ * register map in spi_protocol.h, by submitting a spi_request with
+ * spi_master_submit(). The call returns at once; the SPI thread serves
+ * pending requests ahead of its next poll, packing as many of them into one
+ * frame as fit, and completes each with its callback.
+ *
+ * A read submitted while the same read of the same sensor is still pending
+ * is not sent again but completed with the reply to the pending one, unless
+ * a write to that sensor was submitted in between. Writes are never
+ * coalesced.
+ *
+ * The request belongs to the SPI thread from submission until its callback
+ * returns and must not be changed or freed meanwhile. The callback runs on
+ * the SPI thread; it should only copy the data out or signal an event,
+ * such as a semaphore the submitting thread waits on, and may submit the
+ * request again. Requests need the batched frames of the master.
+ *
+ * A submitter that keeps no request of its own takes one from the static
+ * pool of the master with spi_master_request_take() and gives it back with
+ * spi_master_request_give() once it is completed; nothing is allocated
+ * from the heap.
+ ******************************************************************************/
+
+#ifndef SPI_MASTER_H
+#define SPI_MASTER_H
+
+#include "wiced.h"
+#include "spi_protocol.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+/* Largest register block a request reads or writes; requests reach up to
+ * the sample window, whose samples belong to the polls of the SPI thread*/
+#define SPI_REQUEST_MAX_DATA                  (REG_SAMPLES)
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+/* Kinds of request
+ * SPI_REQUEST_READ:  read length bytes of registers from address into data.
+ * SPI_REQUEST_WRITE: write length bytes of data to the registers from
+ *                    address on.*/
+typedef enum
+{
+    SPI_REQUEST_READ,
+    SPI_REQUEST_WRITE
+}spi_request_type;
+
+typedef struct spi_request spi_request;
+
+/* Completion callback of a request
+ * result: WICED_SUCCESS, WICED_NOT_AVAILABLE if the sensor is not detected,
+ *         WICED_BADARG if the sensor refused the registers, WICED_ERROR if
+ *         no valid reply was received.*/
+typedef void (*spi_request_cback)( spi_request *request, wiced_result_t result );
+
+/* A register read or write
+ * sensor:   index of the sensor in the sensor table of the master.
+ * type:     read or write.
+ * address:  first register, even.
+ * length:   bytes to read or write, even, up to SPI_REQUEST_MAX_DATA.
+ * data:     data to write, or the data read once completed.
+ * cback:    completion callback.
+ * context:  for the submitter, not used by the master.
+ * next, coalesced: kept by the master while the request is pending.*/
+struct spi_request
+{
+    uint8_t             sensor;
+    spi_request_type    type;
+    uint8_t             address;
+    uint8_t             length;
+    uint8_t             data[SPI_REQUEST_MAX_DATA];
+    spi_request_cback   cback;
+    void               *context;
+    spi_request        *next;
+    spi_request        *coalesced;
+};
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+wiced_result_t      spi_master_submit( spi_request *request );
+spi_request        *spi_master_request_take( void );
+void                spi_master_request_give( spi_request *request );
+
+#endif /* SPI_MASTER_H */
@@ -0,0 +1,116 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+/*******************************************************************************
+ * @file wiced_bt_cfg.c
+ *
+ * @brief
+ * Bluetooth stack settings and buffer pools of the SPI master.
+ *
+ * The master is a peripheral that one client at a time connects to for the
+ * notifications of spi_gatt.c. It advertises at a low duty cycle for as long
+ * as nobody is connected and takes an ATT MTU of up to SPI_GATT_MAX_MTU, so a
+ * notification carries as many readings as spi_gatt.c packs into it. The
+ * large buffer pool holds the ACL packet of such a notification.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include "wiced_bt_cfg.h"
+#include "spi_gatt.h"
+
+/******************************************************************************
+ *                                Variables Definitions
+ ******************************************************************************/
+
+/* Stack settings, passed to wiced_bt_stack_init()*/
+const wiced_bt_cfg_settings_t wiced_bt_cfg_settings =
+{
+    .device_name                         = (uint8_t *)"SPI Master",
+    .device_class                        = { 0x00, 0x00, 0x00 },
+    .security_requirement_mask           = BTM_SEC_NONE,
+    .max_simultaneous_links              = 1,
+
+    .ble_scan_cfg =
+    {
+        .scan_mode                       = BTM_BLE_SCAN_MODE_PASSIVE,
+
+        /* Connection parameters the master asks a client for, in 1.25 ms
+           and 10 ms units*/
+        .conn_min_interval               = WICED_BT_CFG_DEFAULT_CONN_MIN_INTERVAL,
+        .conn_max_interval               = WICED_BT_CFG_DEFAULT_CONN_MAX_INTERVAL,
+        .conn_latency                    = WICED_BT_CFG_DEFAULT_CONN_LATENCY,
+        .conn_supervision_timeout        = WICED_BT_CFG_DEFAULT_CONN_SUPERVISION_TIMEOUT,
+    },
+
+    .ble_advert_cfg =
+    {
+        .channel_map                     = BTM_BLE_ADVERT_CHNL_37 |
+                                           BTM_BLE_ADVERT_CHNL_38 |
+                                           BTM_BLE_ADVERT_CHNL_39,
+
+        /* Undirected advertising at a low duty cycle, 1.28 s in 0.625 ms
+           units, without a time limit; see spi_gatt_advertise()*/
+        .high_duty_min_interval          = WICED_BT_CFG_DEFAULT_HIGH_DUTY_ADV_MIN_INTERVAL,
+        .high_duty_max_interval          = WICED_BT_CFG_DEFAULT_HIGH_DUTY_ADV_MAX_INTERVAL,
+        .high_duty_duration              = 30,
+        .low_duty_min_interval           = 2048,
+        .low_duty_max_interval           = 2048,
+        .low_duty_duration               = 0,
+    },
+
+    .gatt_cfg =
+    {
+        .appearance                      = APPEARANCE_GENERIC_THERMOMETER,
+        .client_max_links                = 0,
+        .server_max_links                = SPI_GATT_NOTIFICATIONS ? 1 : 0,
+        .max_attr_len                    = SPI_GATT_MAX_MTU,
+        .max_mtu_size                    = SPI_GATT_MAX_MTU,
+    },
+
+    .addr_resolution_db_size             = 5,
+    .max_number_of_buffer_pools          = WICED_BT_CFG_NUM_BUF_POOLS,
+    .rpa_refresh_timeout                 = WICED_BT_CFG_DEFAULT_RANDOM_ADDRESS_NEVER_CHANGE,
+    .ble_white_list_size                 = 0,
+    .default_ble_power_level             = 0,
+};
+
+/* Buffer pools of the stack, smallest first*/
+const wiced_bt_cfg_buf_pool_t wiced_bt_cfg_buf_pools[WICED_BT_CFG_NUM_BUF_POOLS] =
+{
+/*  { buf_size, buf_count } */
+    { 64,       12 },   /* Small: HCI events and GATT requests*/
+    { 360,      4  },   /* Medium: HCI and L2CAP control messages*/
+    { 360,      8  },   /* Large: ACL packets, a full notification each*/
+    { 1024,     0  },   /* Extra large: unused*/
+};
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+################################################################################
+# \file thermistor_lut.py
+#
+# \brief
+# Generates the fixed-point conversion table of thermistor_lut.c.
+#
+# The thermistor sits between the ADC input and ground with a reference
+# resistor to VDDIO, so the input voltage divided by VDDIO is a ratio that
+# only depends on the temperature. The table holds the temperature, in
+# hundredths of a degree Celsius, at evenly spaced values of that ratio
+# over the operating range, from the beta model of the thermistor:
+#
+#     R(T) = R25 * exp(beta * (1 / T - 1 / 298.15 K))
+#
+# Run by the slave makefile and the host simulator before building, e.g.
+#     python3 thermistor_lut.py --output thermistor_lut_table.h
+#
+################################################################################
+# \copyright
+# Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+################################################################################
+
+import argparse
+import math
+import os
+
+KELVIN_OFFSET = 273.15
+T25_KELVIN    = 25.0 + KELVIN_OFFSET
+
+
+def divider_ratio(celsius, r25, beta, rref):
+    """Input voltage over VDDIO at a temperature."""
+    r = r25 * math.exp(beta * (1.0 / (celsius + KELVIN_OFFSET) - 1.0 / T25_KELVIN))
+    return r / (r + rref)
+
+
+def temperature(ratio, r25, beta, rref):
+    """Temperature in degree Celsius at a divider ratio strictly in (0, 1)."""
+    r = rref * ratio / (1.0 - ratio)
+    return 1.0 / (1.0 / T25_KELVIN + math.log(r / r25) / beta) - KELVIN_OFFSET
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--r25", type=float, default=100000.0,
+                        help="thermistor resistance at 25 C in ohm (NCU15WF104)")
+    parser.add_argument("--beta", type=float, default=4250.0,
+                        help="thermistor beta constant in K (NCU15WF104)")
+    parser.add_argument("--rref", type=float, default=100000.0,
+                        help="reference resistor to VDDIO in ohm")
+    parser.add_argument("--min", type=float, default=-40.0,
+                        help="lowest temperature of the table in C")
+    parser.add_argument("--max", type=float, default=125.0,
+                        help="highest temperature of the table in C")
+    parser.add_argument("--ratio-bits", type=int, default=16,
+                        help="fractional bits of the divider ratio")
+    parser.add_argument("--step-bits", type=int, default=8,
+                        help="log2 of the ratio step between two entries")
+    parser.add_argument("--output", required=True, help="header to write")
+    args = parser.parse_args()
+
+    one  = 1 << args.ratio_bits
+    step = 1 << args.step_bits
+    # The ratio falls as the temperature rises; round the range out to
+    # whole steps so both ends are covered
+    first = int(divider_ratio(args.max, args.r25, args.beta, args.rref) * one) // step * step
+    last  = -(-int(divider_ratio(args.min, args.r25, args.beta, args.rref) * one) // step) * step
+    last  = min(last, one - step)
+
+    # The entries at both ends lie a little outside the range, so that
+    # readings near its limits still interpolate between true values
+    entries = []
+    for q in range(max(first, step), last + 1, step):
+        entries.append(int(round(temperature(q / one, args.r25, args.beta, args.rref) * 100.0)))
+    first = max(first, step)
+    if max(abs(v) for v in entries) > 0x7FFF:
+        parser.error("temperatures do not fit into 16 bits, narrow the range")
+    if any(a < b for a, b in zip(entries, entries[1:])):
+        parser.error("the table does not fall with the ratio")
+
+    # Worst error of the interpolated table over the range, for the header
+    worst = 0.0
+    for tenth in range(int(args.min * 10), int(args.max * 10) + 1):
+        celsius = tenth / 10.0
+        q = int(divider_ratio(celsius, args.r25, args.beta, args.rref) * one) - first
+        i, f = q >> args.step_bits, q & (step - 1)
+        # As thermistor_lut_convert(), which relies on falling entries
+        value = entries[i] - (((entries[i] - entries[i + 1]) * f) >> args.step_bits)
+        worst = max(worst, abs(value / 100.0 - celsius))
+
+    if os.path.dirname(args.output):
+        os.makedirs(os.path.dirname(args.output), exist_ok=True)
+    with open(args.output, "w") as out:
+        out.write("/* Generated by thermistor_lut.py, do not edit.\n")
+        out.write(" * R25 %.0f ohm, beta %.0f K, reference %.0f ohm, %.0f to %.0f C;\n"
+                  % (args.r25, args.beta, args.rref, args.min, args.max))
+        out.write(" * worst interpolation error %.2f C*/\n\n" % worst)
+        out.write("#ifndef THERMISTOR_LUT_TABLE_H\n#define THERMISTOR_LUT_TABLE_H\n\n")
+        out.write("#define THERMISTOR_LUT_R25                   (%.0f)\n" % args.r25)
+        out.write("#define THERMISTOR_LUT_BETA                  (%.0f)\n" % args.beta)
+        out.write("#define THERMISTOR_LUT_RREF                  (%.0f)\n" % args.rref)
+        out.write("#define THERMISTOR_LUT_RATIO_BITS            (%d)\n" % args.ratio_bits)
+        out.write("#define THERMISTOR_LUT_STEP_BITS             (%d)\n" % args.step_bits)
+        out.write("#define THERMISTOR_LUT_FIRST                 (%d)\n" % first)
+        out.write("#define THERMISTOR_LUT_SIZE                  (%d)\n\n" % len(entries))
+        out.write("/* Temperature in 1/100 C at ratio THERMISTOR_LUT_FIRST + i steps*/\n")
+        out.write("static const int16_t thermistor_lut[THERMISTOR_LUT_SIZE] =\n{\n")
+        for i in range(0, len(entries), 8):
+            out.write("    " + ", ".join("%6d" % v for v in entries[i:i + 8]) + ",\n")
+        out.write("};\n\n#endif /* THERMISTOR_LUT_TABLE_H */\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -43,6 +43,8 @@
  * Features demonstrated:
  * - SPI WICED APIs
  * - ADC sampling the analog temperature values from the on-board thermistor
+ * - Application timer sampling the thermistor in the background
+ * - Scan of several ADC channels returned in one frame
  *
  * Requirements and Usage:
  * Connect the SPI lines and ground on both the boards.
@@ -57,6 +59,7 @@
  * MISO    WICED_P01    D12
  * MOSI    WICED_P04    D07
  * CS      WICED_P02    D06
+ * DRDY    WICED_P06    (output, raised when a response is ready; optional)
  * GND
  ******************************************************************************/
 
@@ -77,30 +80,95 @@
 #include "wiced_timer.h"
 #include "wiced_rtos.h"
 #include "wiced_hal_adc.h"
+#include "spi_log.h"
+#include "spi_delta.h"
+#include "spi_protocol.h"
+#include "spi_stack.h"
+#include "spi_stats.h"
+#include "temperature_sampler.h"
 
 /******************************************************************************
  *                                Macros
  ******************************************************************************/
 
-/* Manufacturer ID denoting Cypress Semiconductor */
-#define MANUFACTURER_ID                     (0x000A)
-
-/* Unit ID denoting temperature is in Celsius scale */
-#define UNIT_ID                             (0x000B)
+/* Threads defines */
+/* Sensible stack size for most threads*/
+#define THREAD_STACK_MIN_SIZE               (1024)
+/* Stack of spi_slave_thread, see the stack high water mark dumped with the
+ * statistics*/
+#ifndef SPI_THREAD_STACK_SIZE
+#define SPI_THREAD_STACK_SIZE               THREAD_STACK_MIN_SIZE
+#endif
+/* Defining thread priority levels*/
+#define PRIORITY_MEDIUM                     (5)
 
 #define SPI                                 SPI1
+
+/* Data ready pin, raised once a response is in the TX FIFO so the master can
+ * read it without waiting a fixed delay, and pulsed between transactions to
+ * signal a temperature change the master asked to be told of */
+#define SPI_DRDY                            WICED_P06
+/* Length of the pulse signaling a change*/
+#define CHANGE_PULSE_US                     (10)
+
+/* Ways of noticing a command from the master
+ * SPI_SLAVE_POLLING:      check the RX FIFO every SLEEP_TIMEOUT.
+ * SPI_SLAVE_EVENT_DRIVEN: sleep until chip select goes low, then serve the
+ *                         command at once.*/
+#define SPI_SLAVE_POLLING                   (0)
+#define SPI_SLAVE_EVENT_DRIVEN              (1)
+#ifndef SPI_SLAVE_MODE
+#define SPI_SLAVE_MODE                      SPI_SLAVE_EVENT_DRIVEN
+#endif
+
+/* Pin sensing chip select edges. This is the pSPI chip select pin itself;
+ * on boards where it cannot raise GPIO interrupts while used by pSPI, wire
+ * chip select to a spare pin as well and name that pin here.*/
+#define SPI_CS_SENSE                        WICED_P02
+/* Events waiting for the worker thread */
+#define SPI_EVENT_QUEUE_LENGTH              (8)
+
+/* ADC channels returned by the scan command, read with the thermistor
+ * reading after each scan command: the supply and the core supply. Add the
+ * inputs of further analog sensors here.*/
+#ifndef SPI_SCAN_CHANNELS
+#define SPI_SCAN_CHANNELS                   ADC_INPUT_VDDIO, ADC_INPUT_VDD_CORE
+#endif
+
 enum
 {
     SEND_MANUFACTURER_ID    =   0x01,
     SEND_UNIT,
-    SEND_TEMPERATURE
+    SEND_TEMPERATURE,
+    SEND_SAMPLES,
+    SEND_DESCRIPTOR,
+    SEND_STATS,
+    SEND_SUMMARY,
+    SEND_PACKED_SAMPLES,
+    SEND_REPORT,
+    SEND_REGISTERS,
+    STORE_REGISTERS,
+    SEND_TIMED_SAMPLES,
+    SEND_TIME,
+    SEND_ADC_SCAN,
+    /* Size of the command table*/
+    SEND_COMMAND_LIMIT
 };
 
-#define PACKET_HEADER                       (0xC819)
 #define SLEEP_TIMEOUT                       (1)
+/* Interval at which the RX FIFO is checked while bytes of a request are
+ * known to be on their way */
+#define RX_POLL_INTERVAL_US                 (10)
+/* Time to wait for the rest of a request once chip select went low or a
+ * frame header arrived */
+#define REQUEST_RX_TIMEOUT_US               (5000)
 #define NORM_FACTOR                         (100)
 #define MAX_RETRIES                         (25)
 #define RESET_COUNT                         (0)
+/* Chip select windows in a row without a request while nothing was left for
+ * the master to read, after which the pSPI block is taken to be stuck and is
+ * reset*/
+#define MAX_SILENT_WINDOWS                  (3)
 
 /******************************************************************************
  *                                Structures
@@ -113,6 +181,61 @@ typedef struct
     uint16_t header;
 }data_packet;
 
+/* Events posted to the worker thread in SPI_SLAVE_EVENT_DRIVEN mode
+ * SPI_EVENT_SELECTED: chip select went low, a request is arriving.
+ * SPI_EVENT_RELEASED: chip select went high, the master is done.
+ * SPI_EVENT_CHANGED:  the temperature changed enough to signal the master.*/
+typedef enum
+{
+    SPI_EVENT_SELECTED,
+    SPI_EVENT_RELEASED,
+    SPI_EVENT_CHANGED
+}spi_slave_event;
+
+/* First bytes of a request, a data_packet or the header of a frame */
+typedef union
+{
+    data_packet     packet;
+    spi_frame       frame;
+}spi_request;
+
+/* Computes the 16 bit answer to a command when it is asked for*/
+typedef uint16_t (*command_value_handler)(void);
+
+/* Adds the record answering a command to a reply frame*/
+typedef void (*command_record_handler)(spi_frame *reply,
+                                       const frame_record *request);
+
+/* Entry of the command table, see register_command()
+ * registered: the command is supported.
+ * value:      precomputed answer, used when there is no handler.
+ * get_value:  handler of an answer that changes, NULL for constant ones.
+ * add_record: handler of an answer that is not a single value; such
+ *             commands are only supported in frames.*/
+typedef struct
+{
+    wiced_bool_t            registered;
+    uint16_t                value;
+    command_value_handler   get_value;
+    command_record_handler  add_record;
+}slave_command;
+
+/* Takes a 16 bit value written to a register by the master*/
+typedef void (*register_write_handler)(uint16_t value);
+
+/* Entry of the register map, see map_register()
+ * mapped:    the register exists.
+ * value:     precomputed contents, used when there is no read handler.
+ * get_value: handler of contents that change, NULL for constant ones.
+ * set_value: handler of a value written, NULL for read only registers.*/
+typedef struct
+{
+    wiced_bool_t            mapped;
+    uint16_t                value;
+    command_value_handler   get_value;
+    register_write_handler  set_value;
+}slave_register;
+
 /******************************************************************************
  *                                Function Prototypes
  ******************************************************************************/
@@ -121,17 +244,147 @@ wiced_result_t      bt_cback(wiced_bt_management_evt_t event,
 
 static void         initialize_app(void);
 
-static int16_t      get_ambient_temperature(void);
+static void         spi_slave_thread(uint32_t arg);
 
-extern void         thermistor_init(void);
+static wiced_bool_t spi_slave_service(uint8_t *retries);
+
+#if ( SPI_SLAVE_MODE == SPI_SLAVE_EVENT_DRIVEN )
+static void         spi_slave_rearm(void);
+
+static void         spi_cs_cback(void *data, uint8_t port_pin);
+#endif
+
+static uint16_t     get_ambient_temperature(void);
+
+static void         register_command(uint8_t cmd, uint16_t value,
+                                     command_value_handler get_value,
+                                     command_record_handler add_record);
+
+static const slave_command *find_command(uint16_t cmd);
+
+static void         map_register(uint8_t address, uint16_t value,
+                                 command_value_handler get_value,
+                                 register_write_handler set_value);
+
+static const slave_register *find_register(uint32_t address);
+
+static wiced_bool_t get_response(uint16_t cmd, uint16_t *data);
+
+static void         send_response(uint16_t data, uint16_t header);
+
+static wiced_bool_t receive_frame(spi_frame *frame);
+
+static void         send_frame_response(const spi_frame *request);
+
+static void         send_frame_nak(uint8_t seq);
 
-extern int16_t      thermistor_read(thermistor_cfg_t *p_thermistor_cfg);
+static void         flush_rx(void);
+
+static void         add_stats_record(spi_frame *reply,
+                                     const frame_record *request);
+
+static void         add_samples_record(spi_frame *reply,
+                                       const frame_record *request);
+
+static void         add_summary_record(spi_frame *reply,
+                                       const frame_record *request);
+
+static void         add_packed_samples_record(spi_frame *reply,
+                                              const frame_record *request);
+
+static void         add_report_record(spi_frame *reply,
+                                      const frame_record *request);
+
+static void         add_registers_record(spi_frame *reply,
+                                         const frame_record *request);
+
+static void         store_registers_record(spi_frame *reply,
+                                           const frame_record *request);
+
+static void         add_timed_samples_record(spi_frame *reply,
+                                             const frame_record *request);
+
+static void         add_time_record(spi_frame *reply,
+                                    const frame_record *request);
+
+static void         add_adc_scan_record(spi_frame *reply,
+                                        const frame_record *request);
+
+static uint16_t     get_report_threshold(void);
+
+static void         set_report_threshold(uint16_t value);
+
+static uint16_t     get_report_hysteresis(void);
+
+static void         set_report_hysteresis(uint16_t value);
+
+static uint16_t     get_samples_pending(void);
+
+static uint16_t     get_samples_dropped(void);
+
+static void         temperature_changed(int16_t reading);
+
+static void         signal_change(void);
+
+extern void         thermistor_init(void);
 
 /******************************************************************************
  *                          Variables Definitions
  ******************************************************************************/
 thermistor_cfg_t  thermistor_cfg;    // configuration structure for thermistor
 
+static wiced_thread_t   *spi_1;
+
+/* Stack of spi_slave_thread, painted when it starts*/
+static spi_stack        spi_thread_stack;
+
+/* Channels of the ADC scan, see SPI_SCAN_CHANNELS*/
+static const ADC_INPUT_CHANNEL_SEL scan_channels[] = { SPI_SCAN_CHANNELS };
+
+/* What this sensor reports to the master*/
+static const sensor_descriptor descriptor =
+{
+    .manufacturer = MANUFACTURER_ID,
+    .unit         = UNIT_ID,
+    .version      = SPI_PROTOCOL_VERSION
+};
+
+#if ( SPI_SLAVE_MODE == SPI_SLAVE_EVENT_DRIVEN )
+/* Chip select events for spi_slave_thread*/
+static wiced_queue_t    *spi_events;
+
+/* Set when the pSPI block is to be reset once chip select is released*/
+static wiced_bool_t     reset_pending = WICED_FALSE;
+#endif
+
+/* Set while a pipelined response waits in the TX FIFO for the next chip
+ * select window*/
+static wiced_bool_t     response_preloaded = WICED_FALSE;
+
+/* Last reply frame and the sequence number and CRC of the request it
+ * answers, sent again when the master repeats that request*/
+static spi_frame        last_reply;
+static uint8_t          last_request_seq;
+static uint16_t         last_request_crc;
+static wiced_bool_t     last_reply_valid = WICED_FALSE;
+
+/* Statistics of this side of the link, read by the master with SEND_STATS*/
+static spi_stats        slave_stats;
+
+/* Commands served by the slave, indexed by command code*/
+static slave_command    commands[SEND_COMMAND_LIMIT];
+
+/* Registers in front of the sample window, indexed by address / 2*/
+static slave_register   registers[REG_SAMPLES / sizeof(uint16_t)];
+
+/* Change reporting as last set up by the report command or the report
+ * registers*/
+static report_config    report_setup;
+
+/* Reading the master is to be told of, set from the sampling timer*/
+static volatile wiced_bool_t change_pending = WICED_FALSE;
+static volatile int16_t change_reading;
+
 /******************************************************************************
  *                                Function Definitions
  ******************************************************************************/
@@ -207,14 +460,39 @@ wiced_result_t bt_cback(wiced_bt_management_evt_t event,
  ******************************************************************************/
 void initialize_app(void)
 {
-    data_packet     send_data;
-    data_packet     rec_data;
-    uint32_t        rx_fifo_count       = 0;
-    uint32_t        tx_fifo_count       = 0;
-    uint8_t         retries             = RESET_COUNT;
-    int16_t         thermistor_reading  = 0;
     WICED_BT_TRACE("Initializing Application\n\r");
 
+    /* Answers that never change are worked out once here, so serving them
+       is a table lookup*/
+    register_command(SEND_MANUFACTURER_ID, MANUFACTURER_ID, NULL, NULL);
+    register_command(SEND_UNIT, UNIT_ID, NULL, NULL);
+    register_command(SEND_DESCRIPTOR, spi_descriptor_signature(&descriptor),
+                     NULL, NULL);
+    register_command(SEND_TEMPERATURE, 0, get_ambient_temperature, NULL);
+    register_command(SEND_SAMPLES, 0, NULL, add_samples_record);
+    register_command(SEND_STATS, 0, NULL, add_stats_record);
+    register_command(SEND_SUMMARY, 0, NULL, add_summary_record);
+    register_command(SEND_PACKED_SAMPLES, 0, NULL, add_packed_samples_record);
+    register_command(SEND_REPORT, 0, NULL, add_report_record);
+    register_command(SEND_REGISTERS, 0, NULL, add_registers_record);
+    register_command(STORE_REGISTERS, 0, NULL, store_registers_record);
+    register_command(SEND_TIMED_SAMPLES, 0, NULL, add_timed_samples_record);
+    register_command(SEND_TIME, 0, NULL, add_time_record);
+    register_command(SEND_ADC_SCAN, 0, NULL, add_adc_scan_record);
+
+    map_register(REG_MANUFACTURER, MANUFACTURER_ID, NULL, NULL);
+    map_register(REG_UNIT, UNIT_ID, NULL, NULL);
+    map_register(REG_VERSION, SPI_PROTOCOL_VERSION, NULL, NULL);
+    map_register(REG_SIGNATURE, spi_descriptor_signature(&descriptor),
+                 NULL, NULL);
+    map_register(REG_REPORT_THRESHOLD, 0, get_report_threshold,
+                 set_report_threshold);
+    map_register(REG_REPORT_HYSTERESIS, 0, get_report_hysteresis,
+                 set_report_hysteresis);
+    map_register(REG_TEMPERATURE, 0, get_ambient_temperature, NULL);
+    map_register(REG_SAMPLES_PENDING, 0, get_samples_pending, NULL);
+    map_register(REG_SAMPLES_DROPPED, 0, get_samples_dropped, NULL);
+
     /*Initialize SPI slave*/
     wiced_hal_pspi_init( SPI,
                          0,
@@ -226,122 +504,1250 @@ void initialize_app(void)
     wiced_hal_pspi_slave_enable_rx(SPI);
     wiced_hal_pspi_slave_enable_tx(SPI);
 
+    /* No response pending yet*/
+    wiced_hal_gpio_configure_pin(SPI_DRDY,
+                                 GPIO_OUTPUT_ENABLE | GPIO_PULL_UP_DOWN_NONE,
+                                 GPIO_PIN_OUTPUT_LOW);
+
+#if ( SPI_SLAVE_MODE == SPI_SLAVE_EVENT_DRIVEN )
+    spi_events = wiced_rtos_create_queue();
+    wiced_rtos_init_queue(spi_events, "SPI events", sizeof(uint32_t),
+                          SPI_EVENT_QUEUE_LENGTH);
+
+    wiced_hal_gpio_configure_pin(SPI_CS_SENSE,
+                                 GPIO_INPUT_ENABLE | GPIO_PULL_UP_DOWN_NONE |
+                                 GPIO_EN_INT_BOTH_EDGE,
+                                 GPIO_PIN_OUTPUT_HIGH);
+    wiced_hal_gpio_register_pin_for_interrupt(SPI_CS_SENSE, spi_cs_cback,
+                                              NULL);
+#endif
+
+    /* The thermistor is sampled from a timer on this thread, so commands are
+       served from their own thread and this callback has to return*/
+    temperature_sampler_on_change(temperature_changed);
+    temperature_sampler_scan_channels(scan_channels,
+                                      sizeof(scan_channels) / sizeof(scan_channels[0]));
+    temperature_sampler_start(&thermistor_cfg);
+
+    spi_1 = wiced_rtos_create_thread();
+    if ( WICED_SUCCESS == wiced_rtos_init_thread(spi_1,
+                                                 PRIORITY_MEDIUM,
+                                                 "SPI slave",
+                                                 spi_slave_thread,
+                                                 SPI_THREAD_STACK_SIZE,
+                                                 NULL ) )
+    {
+        WICED_BT_TRACE( "SPI slave thread created\n\r" );
+    }
+    else
+    {
+        WICED_BT_TRACE( "Failed to create SPI slave thread \n\r" );
+    }
+}
+
+/*******************************************************************************
+ Function name: spi_slave_thread
+
+ Function Description:
+ @brief    Waits for and responds to SPI master commands
+
+ @param  arg             unused argument
+
+ @return void
+ ******************************************************************************/
+static void spi_slave_thread(uint32_t arg)
+{
+    uint8_t         retries             = RESET_COUNT;
+#if ( SPI_SLAVE_MODE == SPI_SLAVE_EVENT_DRIVEN )
+    uint32_t        event;
+    uint32_t        waited;
+    uint32_t        pending;
+    wiced_bool_t    expecting;
+    uint8_t         silent_windows      = RESET_COUNT;
+#endif
+
+    spi_stack_paint(&spi_thread_stack, SPI_THREAD_STACK_SIZE);
+#if ( SPI_SLAVE_MODE == SPI_SLAVE_EVENT_DRIVEN )
+    /* Drop whatever arrived before chip select edges were being sensed*/
+    if(wiced_hal_gpio_get_pin_input_status(SPI_CS_SENSE))
+    {
+        spi_slave_rearm();
+    }
+
     while(WICED_TRUE)
     {
-        /* Checking tx_fifo count to know if the last response was sent to
-           master.*/
-        tx_fifo_count = wiced_hal_pspi_slave_get_tx_fifo_count(SPI);
-        if(tx_fifo_count == 0)// tell why check tx_fifo count
+        /* Print what the last transactions logged before going to sleep,
+           unless the master is already waiting*/
+        wiced_rtos_get_queue_occupancy(spi_events, &pending);
+        if(0 == pending)
         {
-            wiced_hal_pspi_slave_enable_rx(SPI);
+            spi_log_flush();
+        }
+
+        /* Sleeps until the master selects the slave*/
+        wiced_rtos_pop_from_queue(spi_events, &event, WICED_WAIT_FOREVER);
+        if(SPI_EVENT_CHANGED == event)
+        {
+            signal_change();
+            continue;
+        }
+        if(SPI_EVENT_RELEASED == event)
+        {
+            /* When the interrupt was served late, the chip select edge that
+               started this window was reported as released too; serve a
+               command that arrived in it before rearming*/
+            if(spi_slave_service(&retries) && !response_preloaded)
+            {
+                /* The master has already clocked in idle bytes instead of
+                   the response*/
+                slave_stats.underruns++;
+            }
+            spi_slave_rearm();
+            continue;
+        }
 
-            /*Check for number of bytes received*/
-            rx_fifo_count = wiced_hal_pspi_slave_get_rx_fifo_count(SPI);
+        /* With nothing left in the TX FIFO the master has a request to
+           send rather than a reply to collect*/
+        expecting = (0 == wiced_hal_pspi_slave_get_tx_fifo_count(SPI));
 
-            if(sizeof(rec_data) <= rx_fifo_count)
+        /* The command follows the chip select edge within a few bytes
+           times, it is waited for without giving up the CPU*/
+        for(waited = 0; waited < REQUEST_RX_TIMEOUT_US;
+            waited += RX_POLL_INTERVAL_US)
+        {
+            if(spi_slave_service(&retries))
             {
-                if (SPIFFY_SUCCESS
-                        != wiced_hal_pspi_slave_rx_data(SPI, sizeof(rec_data),
-                                                        (uint8_t*) &rec_data))
-                {
-                    WICED_BT_TRACE("Receive failed\n\r");
-                }
-                wiced_hal_pspi_slave_disable_rx(SPI);
-
-                if(rec_data.header == PACKET_HEADER)
-                {
-                    switch (rec_data.data)
-                    {
-                    case SEND_MANUFACTURER_ID:
-                        WICED_BT_TRACE("Received Command:\t\t\t\t %x\n\r",
-                                        rec_data.data);
-
-                        /* Configuring send_data data packet to contain response
-                           for command SEND_MANUFACTURER_ID*/
-                        send_data.data = MANUFACTURER_ID;
-                        send_data.header = PACKET_HEADER;
-                        wiced_hal_pspi_slave_tx_data(SPI,
-                                                     sizeof(send_data),
-                                                     (uint8_t*) &send_data);
-                        WICED_BT_TRACE("Sent Number:\t\t\t\t\t %x\n\r",
-                                        send_data.data);
-                        break;
-
-                    case SEND_UNIT:
-                        WICED_BT_TRACE("Received Command:\t\t\t\t %x\n\r",
-                                        rec_data.data);
-
-                        /* Configuring send_data data packet to contain response
-                           for command SEND_UNIT*/
-                        send_data.data = UNIT_ID;
-                        send_data.header = PACKET_HEADER;
-                        wiced_hal_pspi_slave_tx_data(SPI,
-                                                     sizeof(send_data),
-                                                     (uint8_t*) &send_data);
-                        WICED_BT_TRACE("Sent Number:\t\t\t\t\t %x\n\r",
-                                        send_data.data);
-                        break;
-
-                    case SEND_TEMPERATURE:
-                        WICED_BT_TRACE("Received Command:\t\t\t\t %x\n\r",
-                                        rec_data.data);
-
-                        /* Configuring send_data data packet to contain response
-                           for command SEND_TEMPERATURE*/
-                        send_data.data = get_ambient_temperature();
-                        send_data.header = PACKET_HEADER;
-                        wiced_hal_pspi_slave_tx_data(SPI,
-                                                     sizeof(send_data),
-                                                     (uint8_t*) &send_data);
-                        WICED_BT_TRACE("Sent Number:\t\t\t\t\t %x\n\r",
-                                        send_data.data);
-                        break;
-
-                    default:
-                        WICED_BT_TRACE("Invalid Command:\t\t\t\t %x\n\r",
-                                        rec_data.data);
-                    }
-                }
-                else
-                {
-                    retries++;
-                    if(retries > MAX_RETRIES)
-                    {
-                        /* If the number of retries exceeds the maximum,
-                           SPI interface is reset. This reset resolves clock
-                           synchronization issues and ensures the data is
-                           interpreted correctly.*/
-                        retries = RESET_COUNT;
-                        wiced_hal_pspi_reset(SPI);
-                        wiced_hal_pspi_slave_enable_tx(SPI);
-                    }
-                }
+                break;
             }
+            wiced_rtos_delay_microseconds(RX_POLL_INTERVAL_US);
+        }
+
+        /* A pSPI block that stopped receiving never sees an invalid
+           request either, only windows going by without one*/
+        if(!expecting || (waited < REQUEST_RX_TIMEOUT_US))
+        {
+            silent_windows = RESET_COUNT;
         }
+        else if(++silent_windows >= MAX_SILENT_WINDOWS)
+        {
+            silent_windows = RESET_COUNT;
+            reset_pending = WICED_TRUE;
+        }
+    }
+#else
+    while(WICED_TRUE)
+    {
+        spi_slave_service(&retries);
+        signal_change();
+        spi_log_flush();
         wiced_rtos_delay_milliseconds(SLEEP_TIMEOUT, ALLOW_THREAD_TO_SLEEP);
     }
+#endif
+}
+
+/*******************************************************************************
+ Function name: spi_slave_service
+
+ Function Description:
+ @brief    Receives and answers one command if one is waiting in the RX FIFO
+
+ @param  *retries        count of consecutive unrecognized packets
+
+ @return wiced_bool_t    WICED_TRUE if a packet was received
+ ******************************************************************************/
+static wiced_bool_t spi_slave_service(uint8_t *retries)
+{
+    spi_request     rec_data;
+    uint16_t        response;
+    wiced_bool_t    valid;
+    uint32_t        rx_fifo_count       = 0;
+    uint32_t        tx_fifo_count       = 0;
+    uint64_t        start_us;
+
+    /* Checking tx_fifo count to know if the last response was sent to
+       master.*/
+    tx_fifo_count = wiced_hal_pspi_slave_get_tx_fifo_count(SPI);
+    if(tx_fifo_count != 0)
+    {
+        return WICED_FALSE;
+    }
+    wiced_hal_pspi_slave_enable_rx(SPI);
+#if ( SPI_SLAVE_MODE == SPI_SLAVE_POLLING )
+    /* Ready for the next command*/
+    wiced_hal_gpio_set_pin_output(SPI_DRDY, GPIO_PIN_OUTPUT_LOW);
+#endif
+
+    /*Check for number of bytes received*/
+    rx_fifo_count = wiced_hal_pspi_slave_get_rx_fifo_count(SPI);
+    if(sizeof(rec_data.packet) > rx_fifo_count)
+    {
+        return WICED_FALSE;
+    }
+    start_us = clock_SystemTimeMicroseconds64();
+
+    if (SPIFFY_SUCCESS
+            != wiced_hal_pspi_slave_rx_data(SPI,
+                                            sizeof(rec_data.packet),
+                                            (uint8_t*) &rec_data.packet))
+    {
+        spi_log_write(SPI_LOG_RECEIVE_FAILED, 0, 0);
+    }
+
+    /* The master clocks out idle bytes to empty the TX FIFO after losing
+       track of a reply; they carry no command*/
+    if(SPI_IDLE_BYTE == ((uint8_t*) &rec_data)[0])
+    {
+        flush_rx();
+        return WICED_TRUE;
+    }
+
+    /* A frame header announces more bytes, which have to be read before
+       receiving is stopped*/
+    valid = WICED_FALSE;
+    if(rec_data.packet.header == FRAME_HEADER)
+    {
+        valid = receive_frame(&rec_data.frame);
+    }
+    /* Whatever follows a damaged request belongs to it*/
+    if(!valid && (rec_data.packet.header != PACKET_HEADER) &&
+       (rec_data.packet.header != PIPELINE_HEADER))
+    {
+        flush_rx();
+    }
+    wiced_hal_pspi_slave_disable_rx(SPI);
+
+    /* The previous response has been read, withdraw its data ready signal
+       before working on the new command*/
+    wiced_hal_gpio_set_pin_output(SPI_DRDY, GPIO_PIN_OUTPUT_LOW);
+
+    if(rec_data.packet.header == PACKET_HEADER)
+    {
+        *retries = RESET_COUNT;
+        if(get_response(rec_data.packet.data, &response))
+        {
+            send_response(response, PACKET_HEADER);
+        }
+    }
+    else if(rec_data.packet.header == PIPELINE_HEADER)
+    {
+        /* The master collects the response while sending its next command,
+           so receiving stays enabled*/
+        *retries = RESET_COUNT;
+        if(get_response(rec_data.packet.data, &response))
+        {
+            send_response(response, PIPELINE_HEADER);
+            response_preloaded = WICED_TRUE;
+        }
+        wiced_hal_pspi_slave_enable_rx(SPI);
+    }
+    else if(valid)
+    {
+        *retries = RESET_COUNT;
+        send_frame_response(&rec_data.frame);
+    }
+    else
+    {
+        slave_stats.invalid++;
+        (*retries)++;
+        if(*retries > MAX_RETRIES)
+        {
+            /* If the number of retries exceeds the maximum, SPI interface is
+               reset. This reset resolves clock synchronization issues and
+               ensures the data is interpreted correctly.*/
+            *retries = RESET_COUNT;
+#if ( SPI_SLAVE_MODE == SPI_SLAVE_EVENT_DRIVEN )
+            /* The master is still clocking this window; resetting under it
+               would turn its retransmit into another failure, so the reset
+               waits for chip select to be released*/
+            reset_pending = WICED_TRUE;
+#else
+            spi_log_write(SPI_LOG_RESETTING, 0, 0);
+            slave_stats.resets++;
+            wiced_hal_pspi_reset(SPI);
+            wiced_hal_pspi_slave_enable_tx(SPI);
+#endif
+        }
+        else
+        {
+            /* Asking for the request again resynchronizes at once, the
+               reset is left for a master that keeps sending garbage*/
+            send_frame_nak(rec_data.frame.hdr.seq);
+        }
+    }
+    spi_stats_add_transaction(&slave_stats,
+                              (uint32_t)(clock_SystemTimeMicroseconds64() - start_us));
+    return WICED_TRUE;
+}
+
+#if ( SPI_SLAVE_MODE == SPI_SLAVE_EVENT_DRIVEN )
+/*******************************************************************************
+ Function name: spi_slave_rearm
+
+ Function Description:
+ @brief    Prepares for the next command once the master released chip
+           select. A response still in the TX FIFO or a command still in the
+           RX FIFO belongs to a window that is over and is dropped, so the
+           next command cannot be answered with stale data; only the
+           response to a pipelined command is kept for the next window.
+           A reset asked for by spi_slave_service or by windows going by
+           without a request is made here too, between two windows.
+           Receiving is
+           enabled right away, since the command follows the next chip
+           select edge more quickly than this thread wakes up, and SPI_DRDY
+           is lowered to tell the master so.
+
+ @param  void
+
+ @return void
+ ******************************************************************************/
+static void spi_slave_rearm(void)
+{
+    uint32_t        pending = 0;
+    wiced_bool_t    leftover;
+
+    /* A pipelined response is meant for the next window, and the next
+       pipelined command may already be on its way*/
+    leftover = !response_preloaded &&
+               ((0 != wiced_hal_pspi_slave_get_tx_fifo_count(SPI)) ||
+                (0 != wiced_hal_pspi_slave_get_rx_fifo_count(SPI)));
+
+    /* If the master has started another window by now, the FIFOs may hold
+       its data rather than leftovers*/
+    wiced_rtos_get_queue_occupancy(spi_events, &pending);
+    if((leftover || reset_pending) && (0 == pending) &&
+       wiced_hal_gpio_get_pin_input_status(SPI_CS_SENSE))
+    {
+        spi_log_write(reset_pending ? SPI_LOG_RESETTING : SPI_LOG_DROPPING,
+                      0, 0);
+        reset_pending = WICED_FALSE;
+        slave_stats.resets++;
+        wiced_hal_pspi_reset(SPI);
+        wiced_hal_pspi_slave_enable_tx(SPI);
+    }
+    wiced_hal_pspi_slave_enable_rx(SPI);
+
+    /* A low SPI_DRDY tells the master a new command can be sent*/
+    if(!response_preloaded)
+    {
+        wiced_hal_gpio_set_pin_output(SPI_DRDY, GPIO_PIN_OUTPUT_LOW);
+    }
+    response_preloaded = WICED_FALSE;
+}
+
+/*******************************************************************************
+ Function name: spi_cs_cback
+
+ Function Description:
+ @brief    Interrupt handler of SPI_CS_SENSE, passes chip select edges on to
+           spi_slave_thread. The edge is told from the current level, so an
+           interrupt served after the window ended reports it as released.
+
+ @param  data            unused
+ @param  port_pin        pin that raised the interrupt
+
+ @return void
+ ******************************************************************************/
+static void spi_cs_cback(void *data, uint8_t port_pin)
+{
+    uint32_t        event;
+
+    wiced_hal_gpio_clear_pin_interrupt_status(port_pin);
+    event = wiced_hal_gpio_get_pin_input_status(port_pin) ?
+            SPI_EVENT_RELEASED : SPI_EVENT_SELECTED;
+    if(WICED_SUCCESS != wiced_rtos_push_to_queue(spi_events, &event,
+                                                 WICED_NO_WAIT))
+    {
+        WICED_BT_TRACE("SPI event queue full\n\r");
+    }
+}
+#endif
+
+/*******************************************************************************
+ Function name:  register_command
+
+ Function Description:
+ @brief    Adds a command to the command table. A command is answered with
+           the record added by add_record if there is one, else with the
+           value returned by get_value if there is one, else with the
+           precomputed value.
+
+ @param  cmd             Command code, below SEND_COMMAND_LIMIT.
+ @param  value           Precomputed answer.
+ @param  get_value       Handler computing the answer, or NULL.
+ @param  add_record      Handler adding the answer to a reply frame, or NULL.
+
+ @return void
+ ******************************************************************************/
+
+static void register_command(uint8_t cmd, uint16_t value,
+                             command_value_handler get_value,
+                             command_record_handler add_record)
+{
+    if(cmd >= SEND_COMMAND_LIMIT)
+    {
+        return;
+    }
+    commands[cmd].registered = WICED_TRUE;
+    commands[cmd].value      = value;
+    commands[cmd].get_value  = get_value;
+    commands[cmd].add_record = add_record;
+}
+
+/*******************************************************************************
+ Function name:  find_command
+
+ Function Description:
+ @brief    Looks up a command received from the master in the command table.
+
+ @param  cmd                    Received command.
+
+ @return const slave_command*   Table entry, NULL if the command is not
+                                supported.
+ ******************************************************************************/
+
+static const slave_command *find_command(uint16_t cmd)
+{
+    if((cmd >= SEND_COMMAND_LIMIT) || !commands[cmd].registered)
+    {
+        return NULL;
+    }
+    return &commands[cmd];
+}
+
+/*******************************************************************************
+ Function name:  map_register
+
+ Function Description:
+ @brief    Adds a register to the register map. A register reads as the
+           value returned by get_value if there is one, else as the
+           precomputed value, and can be written if it has a set_value.
+
+ @param  address         Even byte address, below REG_SAMPLES.
+ @param  value           Precomputed contents.
+ @param  get_value       Handler reading the contents, or NULL.
+ @param  set_value       Handler taking a written value, or NULL.
+
+ @return void
+ ******************************************************************************/
+
+static void map_register(uint8_t address, uint16_t value,
+                         command_value_handler get_value,
+                         register_write_handler set_value)
+{
+    if((address >= REG_SAMPLES) || (address & 1))
+    {
+        return;
+    }
+    registers[address / sizeof(uint16_t)].mapped    = WICED_TRUE;
+    registers[address / sizeof(uint16_t)].value     = value;
+    registers[address / sizeof(uint16_t)].get_value = get_value;
+    registers[address / sizeof(uint16_t)].set_value = set_value;
+}
+
+/*******************************************************************************
+ Function name:  find_register
+
+ Function Description:
+ @brief    Looks up a register addressed by the master in the register map.
+
+ @param  address                Byte address.
+
+ @return const slave_register*  Table entry, NULL if no register starts at
+                                the address.
+ ******************************************************************************/
+
+static const slave_register *find_register(uint32_t address)
+{
+    if((address >= REG_SAMPLES) || (address & 1) ||
+       !registers[address / sizeof(uint16_t)].mapped)
+    {
+        return NULL;
+    }
+    return &registers[address / sizeof(uint16_t)];
+}
+
+/*******************************************************************************
+ Function name:  get_response
+
+ Function Description:
+ @brief    Looks up the 16 bit response to a command received from the
+           master.
+
+ @param  cmd             Received command.
+ @param  *data           Response to the command.
+
+ @return wiced_bool_t    WICED_FALSE if the command is not supported or is
+                         not answered with a single value.
+ ******************************************************************************/
+
+static wiced_bool_t get_response(uint16_t cmd, uint16_t *data)
+{
+    const slave_command *command = find_command(cmd);
+
+    if((NULL == command) || (NULL != command->add_record))
+    {
+        spi_log_write(SPI_LOG_INVALID_COMMAND, cmd, 0);
+        slave_stats.invalid++;
+        return WICED_FALSE;
+    }
+    spi_log_write(SPI_LOG_COMMAND, cmd, 0);
+    *data = (NULL != command->get_value) ? command->get_value() : command->value;
+    return WICED_TRUE;
+}
+
+/*******************************************************************************
+ Function name:  send_response
+
+ Function Description:
+ @brief    Loads a response packet into the TX FIFO and signals the master
+           that it can be read.
+
+ @param  data            Response to the received command.
+ @param  header          PACKET_HEADER, or PIPELINE_HEADER for the response to
+                         a pipelined command.
+
+ @return void
+ ******************************************************************************/
+
+static void send_response(uint16_t data, uint16_t header)
+{
+    data_packet     send_data;
+
+    send_data.data = data;
+    send_data.header = header;
+    wiced_hal_pspi_slave_tx_data(SPI,
+                                 sizeof(send_data),
+                                 (uint8_t*) &send_data);
+    wiced_hal_gpio_set_pin_output(SPI_DRDY, GPIO_PIN_OUTPUT_HIGH);
+    spi_log_write(SPI_LOG_SENT_NUMBER, (int16_t)send_data.data, 0);
+}
+
+/*******************************************************************************
+ Function name:  receive_frame
+
+ Function Description:
+ @brief    Reads the payload and CRC of a frame whose header has been
+           received. The master sends the whole frame at once, so the payload
+           is at most a few byte times behind; it is waited for at most
+           REQUEST_RX_TIMEOUT_US.
+
+ @param  *frame          Frame with the received header, gets the payload.
+
+ @return wiced_bool_t    WICED_TRUE if a complete frame with a matching CRC
+                         was received.
+ ******************************************************************************/
+
+static wiced_bool_t receive_frame(spi_frame *frame)
+{
+    uint32_t        waited;
+
+    if(!spi_frame_header_valid(&frame->hdr))
+    {
+        spi_log_write(SPI_LOG_FRAME_LENGTH, frame->hdr.length, 0);
+        return WICED_FALSE;
+    }
+    for(waited = 0;
+        wiced_hal_pspi_slave_get_rx_fifo_count(SPI) <
+        (uint32_t)(frame->hdr.length + FRAME_CRC_SIZE);
+        waited += RX_POLL_INTERVAL_US)
+    {
+        if(waited >= REQUEST_RX_TIMEOUT_US)
+        {
+            spi_log_write(SPI_LOG_FRAME_TIMEOUT, 0, 0);
+            return WICED_FALSE;
+        }
+        wiced_rtos_delay_microseconds(RX_POLL_INTERVAL_US);
+    }
+    if(SPIFFY_SUCCESS != wiced_hal_pspi_slave_rx_data(SPI,
+                                               frame->hdr.length + FRAME_CRC_SIZE,
+                                               frame->payload))
+    {
+        return WICED_FALSE;
+    }
+    if(!spi_frame_crc_valid(frame))
+    {
+        spi_log_write(SPI_LOG_FRAME_CRC, 0, 0);
+        return WICED_FALSE;
+    }
+    return WICED_TRUE;
+}
+
+/*******************************************************************************
+ Function name:  send_frame_response
+
+ Function Description:
+ @brief    Answers every command of a request frame in one reply frame,
+           loads it into the TX FIFO and signals the master that it can be
+           read. Unsupported commands are answered with RECORD_ERROR set.
+           A request repeated by the master, because the reply did not reach
+           it, gets the previous reply again; its commands are not executed
+           twice, so no buffered samples are lost.
+
+ @param  *request        Received request frame.
+
+ @return void
+ ******************************************************************************/
+
+static void send_frame_response(const spi_frame *request)
+{
+    const frame_record  *record;
+    const slave_command *command;
+    uint32_t             offset  = 0;
+    uint16_t             data;
+    uint16_t             crc     = spi_frame_crc(request);
+
+    if(!last_reply_valid || (request->hdr.seq != last_request_seq) ||
+       (crc != last_request_crc))
+    {
+        spi_frame_init(&last_reply);
+        while(NULL != (record = spi_frame_next(request, &offset)))
+        {
+            command = find_command(record->cmd);
+            if((NULL != command) && (NULL != command->add_record))
+            {
+                command->add_record(&last_reply, record);
+            }
+            else if(get_response(record->cmd, &data))
+            {
+                spi_frame_add(&last_reply, record->cmd, sizeof(data), &data);
+            }
+            else
+            {
+                spi_frame_add(&last_reply, record->cmd | RECORD_ERROR, 0, NULL);
+            }
+        }
+        spi_frame_seal(&last_reply, request->hdr.seq);
+        last_request_seq = request->hdr.seq;
+        last_request_crc = crc;
+        last_reply_valid = WICED_TRUE;
+    }
+    else
+    {
+        spi_log_write(SPI_LOG_REPEATED, 0, 0);
+        slave_stats.retries++;
+    }
+    wiced_hal_pspi_slave_tx_data(SPI,
+                                 spi_frame_size(&last_reply),
+                                 (uint8_t*) &last_reply);
+    wiced_hal_gpio_set_pin_output(SPI_DRDY, GPIO_PIN_OUTPUT_HIGH);
+    spi_log_write(SPI_LOG_SENT_FRAME, spi_frame_size(&last_reply), 0);
+}
+
+/*******************************************************************************
+ Function name:  send_frame_nak
+
+ Function Description:
+ @brief    Answers a damaged or unrecognized request with a frame without
+           records, which makes the master send the request again.
+
+ @param  seq             Sequence number as received, may be damaged too.
+
+ @return void
+ ******************************************************************************/
+
+static void send_frame_nak(uint8_t seq)
+{
+    spi_frame           nak;
+
+    spi_frame_init(&nak);
+    spi_frame_seal(&nak, seq);
+    wiced_hal_pspi_slave_tx_data(SPI,
+                                 spi_frame_size(&nak),
+                                 (uint8_t*) &nak);
+    wiced_hal_gpio_set_pin_output(SPI_DRDY, GPIO_PIN_OUTPUT_HIGH);
+    spi_log_write(SPI_LOG_SENT_NAK, 0, 0);
+}
+
+/*******************************************************************************
+ Function name:  flush_rx
+
+ Function Description:
+ @brief    Discards the bytes waiting in the RX FIFO.
+
+ @param  void
+
+ @return void
+ ******************************************************************************/
+
+static void flush_rx(void)
+{
+    uint8_t             discard[FRAME_MAX_SIZE];
+    uint32_t            count;
+
+    while(0 != (count = wiced_hal_pspi_slave_get_rx_fifo_count(SPI)))
+    {
+        if(count > sizeof(discard))
+        {
+            count = sizeof(discard);
+        }
+        wiced_hal_pspi_slave_rx_data(SPI, count, discard);
+    }
+}
+
+/*******************************************************************************
+ Function name:  add_stats_record
+
+ Function Description:
+ @brief    Answers the statistics command with the statistics of the slave,
+           which are also dumped on the trace output.
+
+ @param  *reply          Reply frame to add the record to.
+ @param  *request        Request record.
+
+ @return void
+ ******************************************************************************/
+
+static void add_stats_record(spi_frame *reply, const frame_record *request)
+{
+    uint8_t         data[SPI_STATS_WIRE_SIZE];
+
+    spi_log_write(SPI_LOG_COMMAND, request->cmd, 0);
+    spi_stats_dump("slave", &slave_stats);
+    WICED_BT_TRACE("SPI thread stack: %d of %d bytes used\n\r",
+                   (int)spi_stack_used(&spi_thread_stack),
+                   (int)SPI_THREAD_STACK_SIZE);
+    spi_stats_pack(&slave_stats, data);
+    if(!spi_frame_add(reply, request->cmd, sizeof(data), data))
+    {
+        spi_frame_add(reply, request->cmd | RECORD_ERROR, 0, NULL);
+    }
+}
+
+/*******************************************************************************
+ Function name:  add_samples_record
+
+ Function Description:
+ @brief    Answers a burst read with as many buffered temperature samples,
+           oldest first, as were asked for and fit into the reply frame.
+           Samples that do not fit stay buffered for the next burst read.
+
+ @param  *reply          Reply frame to add the record to.
+ @param  *request        Request record, its data byte is the sample count.
+
+ @return void
+ ******************************************************************************/
+
+static void add_samples_record(spi_frame *reply, const frame_record *request)
+{
+    int16_t         samples[SAMPLES_MAX_PER_RECORD];
+    uint32_t        max_samples;
+    uint32_t        count;
+
+    /* Room left in the reply for the samples*/
+    max_samples = (FRAME_MAX_PAYLOAD - reply->hdr.length) > sizeof(frame_record) ?
+                  (FRAME_MAX_PAYLOAD - reply->hdr.length - sizeof(frame_record)) /
+                  sizeof(int16_t) : 0;
+    if((request->length >= 1) && (request->data[0] < max_samples))
+    {
+        max_samples = request->data[0];
+    }
+
+    count = temperature_sampler_read(samples, max_samples);
+    spi_log_write(SPI_LOG_SAMPLES, request->cmd, count);
+    spi_frame_add(reply, request->cmd, count * sizeof(int16_t), samples);
+}
+
+/*******************************************************************************
+ Function name:  add_packed_samples_record
+
+ Function Description:
+ @brief    Answers a packed burst read with as many buffered temperature
+           samples, oldest first, as were asked for and whose encoding fits
+           into the reply frame, behind the number of samples left buffered.
+
+ @param  *reply          Reply frame to add the record to.
+ @param  *request        Request record, its data byte is the sample count.
+
+ @return void
+ ******************************************************************************/
+
+static void add_packed_samples_record(spi_frame *reply,
+                                      const frame_record *request)
+{
+    int16_t         samples[PACKED_SAMPLES_MAX];
+    uint8_t         data[FRAME_MAX_PAYLOAD];
+    uint32_t        room;
+    uint32_t        max_samples;
+    uint32_t        count;
+    uint32_t        length;
+
+    /* Room left in the reply for the encoding*/
+    room = (FRAME_MAX_PAYLOAD - reply->hdr.length) > (sizeof(frame_record) + 1) ?
+           (FRAME_MAX_PAYLOAD - reply->hdr.length - sizeof(frame_record) - 1) : 0;
+    max_samples = MIN(room, PACKED_SAMPLES_MAX);
+    if((request->length >= 1) && (request->data[0] < max_samples))
+    {
+        max_samples = request->data[0];
+    }
+
+    /* Samples whose encoding does not fit stay buffered*/
+    count = temperature_sampler_peek(samples, max_samples);
+    length = spi_delta_encode(samples, count, &data[1], room, &count);
+    temperature_sampler_consume(count);
+    data[0] = (uint8_t)MIN(temperature_sampler_pending(), 0xFF);
+
+    spi_log_write(SPI_LOG_SAMPLES, request->cmd, count);
+    if(!spi_frame_add(reply, request->cmd, 1 + length, data))
+    {
+        spi_frame_add(reply, request->cmd | RECORD_ERROR, 0, NULL);
+    }
+}
+
+/*******************************************************************************
+ Function name:  add_timed_samples_record
+
+ Function Description:
+ @brief    Answers a timed burst read with as many buffered temperature
+           samples, oldest first, as were asked for and fit into the reply
+           frame, each with the time it was taken. Samples that do not fit
+           stay buffered for the next burst read.
+
+ @param  *reply          Reply frame to add the record to.
+ @param  *request        Request record, its data byte is the sample count.
+
+ @return void
+ ******************************************************************************/
+
+static void add_timed_samples_record(spi_frame *reply,
+                                     const frame_record *request)
+{
+    int16_t         samples[TIMED_SAMPLES_MAX_PER_RECORD];
+    uint32_t        times_ms[TIMED_SAMPLES_MAX_PER_RECORD];
+    uint8_t         data[FRAME_MAX_PAYLOAD];
+    uint32_t        max_samples;
+    uint32_t        count;
+    uint32_t        length;
+
+    /* Room left in the reply for the samples*/
+    max_samples = (FRAME_MAX_PAYLOAD - reply->hdr.length) >
+                  (sizeof(frame_record) + TIMED_SAMPLES_HEADER_SIZE) ?
+                  (FRAME_MAX_PAYLOAD - reply->hdr.length - sizeof(frame_record) -
+                   TIMED_SAMPLES_HEADER_SIZE) / TIMED_SAMPLE_WIRE_SIZE : 0;
+    max_samples = MIN(max_samples, TIMED_SAMPLES_MAX_PER_RECORD);
+    if((request->length >= 1) && (request->data[0] < max_samples))
+    {
+        max_samples = request->data[0];
+    }
+
+    /* Samples after a long gap stay buffered for the next read*/
+    count = temperature_sampler_peek_timed(samples, times_ms, max_samples);
+    length = spi_timed_samples_pack(samples, times_ms, count, data, &count);
+    temperature_sampler_consume(count);
+
+    spi_log_write(SPI_LOG_SAMPLES, request->cmd, count);
+    if(!spi_frame_add(reply, request->cmd, length, data))
+    {
+        spi_frame_add(reply, request->cmd | RECORD_ERROR, 0, NULL);
+    }
+}
+
+/*******************************************************************************
+ Function name:  add_time_record
+
+ Function Description:
+ @brief    Answers the time command with the current time of the clock the
+           buffered samples are timed with.
+
+ @param  *reply          Reply frame to add the record to.
+ @param  *request        Request record.
+
+ @return void
+ ******************************************************************************/
+
+static void add_time_record(spi_frame *reply, const frame_record *request)
+{
+    uint64_t        now_us = clock_SystemTimeMicroseconds64();
+    slave_time      time;
+    uint8_t         data[SLAVE_TIME_WIRE_SIZE];
+
+    time.ms = (uint32_t)(now_us / 1000);
+    time.us = (uint16_t)(now_us % 1000);
+    spi_slave_time_pack(&time, data);
+    spi_log_write(SPI_LOG_COMMAND, request->cmd, 0);
+    if(!spi_frame_add(reply, request->cmd, sizeof(data), data))
+    {
+        spi_frame_add(reply, request->cmd | RECORD_ERROR, 0, NULL);
+    }
+}
+
+/*******************************************************************************
+ Function name:  add_adc_scan_record
+
+ Function Description:
+ @brief    Answers the scan command with the channels of the last ADC scan
+           the request selects, as many as fit into the reply frame, or with
+           an empty record before the first scan is complete.
+
+ @param  *reply          Reply frame to add the record to.
+ @param  *request        Request record, its data is an optional channel
+                         mask.
+
+ @return void
+ ******************************************************************************/
+
+static void add_adc_scan_record(spi_frame *reply, const frame_record *request)
+{
+    adc_scan        scan;
+    uint8_t         data[FRAME_MAX_PAYLOAD];
+    uint32_t        mask = 0;
+    uint32_t        room;
+    uint32_t        length;
+
+    spi_log_write(SPI_LOG_COMMAND, request->cmd, 0);
+    if(ADC_SCAN_MASK_WIRE_SIZE == request->length)
+    {
+        mask = (uint32_t)request->data[0] | ((uint32_t)request->data[1] << 8) |
+               ((uint32_t)request->data[2] << 16) | ((uint32_t)request->data[3] << 24);
+    }
+    else if(0 != request->length)
+    {
+        spi_frame_add(reply, request->cmd | RECORD_ERROR, 0, NULL);
+        return;
+    }
+    if(!temperature_sampler_scan(&scan))
+    {
+        spi_frame_add(reply, request->cmd, 0, NULL);
+        return;
+    }
+
+    /* Room left in the reply for the scan*/
+    room = (FRAME_MAX_PAYLOAD - reply->hdr.length) > sizeof(frame_record) ?
+           (FRAME_MAX_PAYLOAD - reply->hdr.length - sizeof(frame_record)) : 0;
+    length = spi_adc_scan_pack(&scan, mask, data, room);
+    if((0 == length) || !spi_frame_add(reply, request->cmd, length, data))
+    {
+        spi_frame_add(reply, request->cmd | RECORD_ERROR, 0, NULL);
+    }
+}
+
+/*******************************************************************************
+ Function name:  add_summary_record
+
+ Function Description:
+ @brief    Answers the summary command with the summary of the last complete
+           summary window, or with an empty record before the first window
+           is complete.
+
+ @param  *reply          Reply frame to add the record to.
+ @param  *request        Request record.
+
+ @return void
+ ******************************************************************************/
+
+static void add_summary_record(spi_frame *reply, const frame_record *request)
+{
+    temperature_summary summary;
+    uint8_t             data[SUMMARY_WIRE_SIZE];
+
+    spi_log_write(SPI_LOG_COMMAND, request->cmd, 0);
+    if(!temperature_sampler_summary(&summary))
+    {
+        spi_frame_add(reply, request->cmd, 0, NULL);
+        return;
+    }
+    spi_summary_pack(&summary, data);
+    if(!spi_frame_add(reply, request->cmd, sizeof(data), data))
+    {
+        spi_frame_add(reply, request->cmd | RECORD_ERROR, 0, NULL);
+    }
+}
+
+/*******************************************************************************
+ Function name:  add_report_record
+
+ Function Description:
+ @brief    Answers the report command with the latest temperature reading
+           and sets up change reporting relative to it with the
+           report_config of the request.
+
+ @param  *reply          Reply frame to add the record to.
+ @param  *request        Request record, its data is a report_config.
+
+ @return void
+ ******************************************************************************/
+
+static void add_report_record(spi_frame *reply, const frame_record *request)
+{
+    report_config   config;
+    int16_t         reading;
+
+    spi_log_write(SPI_LOG_COMMAND, request->cmd, 0);
+    if(REPORT_CONFIG_WIRE_SIZE != request->length)
+    {
+        spi_frame_add(reply, request->cmd | RECORD_ERROR, 0, NULL);
+        return;
+    }
+    spi_report_config_unpack(&config, request->data);
+    report_setup = config;
+    reading = temperature_sampler_report(&config);
+    /* A change signaled before is answered by this reading*/
+    change_pending = WICED_FALSE;
+    if(!spi_frame_add(reply, request->cmd, sizeof(reading), &reading))
+    {
+        spi_frame_add(reply, request->cmd | RECORD_ERROR, 0, NULL);
+    }
+}
+
+/*******************************************************************************
+ Function name:  add_registers_record
+
+ Function Description:
+ @brief    Answers a register read with the contents of the registers from
+           the start address on, two bytes each, and with buffered samples
+           for the bytes that fall into the sample window. The read is cut
+           short where the reply has no more room or no sample is left.
+
+ @param  *reply          Reply frame to add the record to.
+ @param  *request        Request record: start address and number of bytes.
+
+ @return void
+ ******************************************************************************/
+
+static void add_registers_record(spi_frame *reply, const frame_record *request)
+{
+    uint8_t                 data[FRAME_MAX_PAYLOAD];
+    int16_t                 samples[FRAME_MAX_PAYLOAD / sizeof(int16_t)];
+    const slave_register   *reg;
+    uint32_t                room;
+    uint32_t                address;
+    uint32_t                length  = 0;
+    uint32_t                count;
+    uint32_t                i;
+    uint16_t                value;
+
+    if((REGISTER_READ_WIRE_SIZE != request->length) ||
+       (request->data[0] & 1) || (request->data[1] & 1))
+    {
+        spi_frame_add(reply, request->cmd | RECORD_ERROR, 0, NULL);
+        return;
+    }
+
+    /* Room left in the reply, in whole registers*/
+    room = (FRAME_MAX_PAYLOAD - reply->hdr.length) > sizeof(frame_record) ?
+           (FRAME_MAX_PAYLOAD - reply->hdr.length - sizeof(frame_record)) : 0;
+    room = MIN(room, request->data[1]) & ~1u;
+
+    /* Registers are read before any sample is taken, so a read of an
+       unmapped register loses no samples*/
+    for(address = request->data[0];
+        (length < room) && (address < REG_SAMPLES);
+        address += sizeof(uint16_t))
+    {
+        if(NULL == (reg = find_register(address)))
+        {
+            spi_frame_add(reply, request->cmd | RECORD_ERROR, 0, NULL);
+            return;
+        }
+        value = (NULL != reg->get_value) ? reg->get_value() : reg->value;
+        data[length++] = (uint8_t)value;
+        data[length++] = (uint8_t)(value >> 8);
+    }
+    count = temperature_sampler_read(samples,
+                                     (room - length) / sizeof(int16_t));
+    for(i = 0; i < count; i++)
+    {
+        data[length++] = (uint8_t)samples[i];
+        data[length++] = (uint8_t)((uint16_t)samples[i] >> 8);
+    }
+
+    spi_log_write(SPI_LOG_REGISTERS_READ, request->data[0], length);
+    spi_frame_add(reply, request->cmd, length, data);
+}
+
+/*******************************************************************************
+ Function name:  store_registers_record
+
+ Function Description:
+ @brief    Writes the registers from the start address on, two bytes each,
+           and answers with a record without data. Nothing is written if
+           any of the registers is read only or unmapped.
+
+ @param  *reply          Reply frame to add the record to.
+ @param  *request        Request record: start address and the bytes to
+                         write.
+
+ @return void
+ ******************************************************************************/
+
+static void store_registers_record(spi_frame *reply,
+                                   const frame_record *request)
+{
+    const slave_register   *reg;
+    uint32_t                offset;
+
+    if((request->length < 1) || ((request->length - 1) & 1) ||
+       (request->data[0] & 1))
+    {
+        spi_frame_add(reply, request->cmd | RECORD_ERROR, 0, NULL);
+        return;
+    }
+    for(offset = 1; offset < request->length; offset += sizeof(uint16_t))
+    {
+        reg = find_register(request->data[0] + offset - 1);
+        if((NULL == reg) || (NULL == reg->set_value))
+        {
+            spi_frame_add(reply, request->cmd | RECORD_ERROR, 0, NULL);
+            return;
+        }
+    }
+    for(offset = 1; offset < request->length; offset += sizeof(uint16_t))
+    {
+        reg = find_register(request->data[0] + offset - 1);
+        reg->set_value((uint16_t)(request->data[offset] |
+                                  (request->data[offset + 1] << 8)));
+    }
+
+    spi_log_write(SPI_LOG_REGISTERS_WROTE, request->data[0],
+                  request->length - 1);
+    spi_frame_add(reply, request->cmd, 0, NULL);
+}
+
+/*******************************************************************************
+ Function name:  get_report_threshold, set_report_threshold,
+                 get_report_hysteresis, set_report_hysteresis
+
+ Function Description:
+ @brief    Read and write the report registers. A write sets up change
+           reporting again relative to the latest reading, as the report
+           command does.
+
+ @param  value           Value written by the master.
+
+ @return uint16_t        Contents of the register.
+ ******************************************************************************/
+
+static uint16_t get_report_threshold(void)
+{
+    return report_setup.threshold;
+}
+
+static void set_report_threshold(uint16_t value)
+{
+    report_setup.threshold = value;
+    temperature_sampler_report(&report_setup);
+}
+
+static uint16_t get_report_hysteresis(void)
+{
+    return report_setup.hysteresis;
+}
+
+static void set_report_hysteresis(uint16_t value)
+{
+    report_setup.hysteresis = value;
+    temperature_sampler_report(&report_setup);
+}
+
+/*******************************************************************************
+ Function name:  get_samples_pending, get_samples_dropped
+
+ Function Description:
+ @brief    Read the status registers of the sample buffer.
+
+ @return uint16_t        Samples buffered, or samples lost to a full buffer
+                         modulo 2^16.
+ ******************************************************************************/
+
+static uint16_t get_samples_pending(void)
+{
+    return (uint16_t)MIN(temperature_sampler_pending(), 0xFFFF);
+}
+
+static uint16_t get_samples_dropped(void)
+{
+    return (uint16_t)temperature_sampler_dropped();
+}
+
+/*******************************************************************************
+ Function name:  temperature_changed
+
+ Function Description:
+ @brief    Change callback of the sampler, called from the sampling timer
+           for every reading that changed enough since the last report.
+           Leaves signaling the master to spi_slave_thread, which knows
+           whether a transaction is going on.
+
+ @param  reading         Temperature in hundredths of a degree Celsius.
+
+ @return void
+ ******************************************************************************/
+
+static void temperature_changed(int16_t reading)
+{
+#if ( SPI_SLAVE_MODE == SPI_SLAVE_EVENT_DRIVEN )
+    uint32_t        event = SPI_EVENT_CHANGED;
+#endif
+
+    change_reading = reading;
+    change_pending = WICED_TRUE;
+#if ( SPI_SLAVE_MODE == SPI_SLAVE_EVENT_DRIVEN )
+    /* If the queue is full, the next reading tries again*/
+    wiced_rtos_push_to_queue(spi_events, &event, WICED_NO_WAIT);
+#endif
+}
+
+/*******************************************************************************
+ Function name:  signal_change
+
+ Function Description:
+ @brief    Pulses SPI_DRDY to tell the master of a pending change, but only
+           between transactions, where the edge cannot be taken for a
+           response. A change that cannot be signaled now is signaled with
+           the next reading.
+
+ @param  void
+
+ @return void
+ ******************************************************************************/
+
+static void signal_change(void)
+{
+#if ( SPI_SLAVE_MODE == SPI_SLAVE_EVENT_DRIVEN )
+    uint32_t        pending = 0;
+
+    /* Chip select events waiting mean a transaction has started*/
+    wiced_rtos_get_queue_occupancy(spi_events, &pending);
+    if((0 != pending) || !wiced_hal_gpio_get_pin_input_status(SPI_CS_SENSE))
+    {
+        return;
+    }
+#endif
+    if(!change_pending || response_preloaded ||
+       (0 != wiced_hal_pspi_slave_get_tx_fifo_count(SPI)) ||
+       (0 != wiced_hal_pspi_slave_get_rx_fifo_count(SPI)))
+    {
+        return;
+    }
+    change_pending = WICED_FALSE;
+    wiced_hal_gpio_set_pin_output(SPI_DRDY, GPIO_PIN_OUTPUT_HIGH);
+    wiced_rtos_delay_microseconds(CHANGE_PULSE_US);
+    wiced_hal_gpio_set_pin_output(SPI_DRDY, GPIO_PIN_OUTPUT_LOW);
+    spi_log_write(SPI_LOG_CHANGE_SIGNALED, change_reading / NORM_FACTOR,
+                  ABS(change_reading % NORM_FACTOR));
 }
 
 /*******************************************************************************
  Function name:  get_ambient_temperature
 
  Function Description:
- @brief    Obtains ambient temperature from the thermistor.
+ @brief    Obtains the latest ambient temperature sampled from the
+           thermistor.
 
  @param  void
 
- @return int16_t         Temperature reading from the thermistor.
+ @return uint16_t        Temperature reading from the thermistor, in
+                         hundredths of a degree Celsius as a two's complement
+                         16 bit value.
  ******************************************************************************/
 
-static int16_t get_ambient_temperature(void)
+static uint16_t get_ambient_temperature(void)
 {
     volatile int16_t  temperature = 0;
     /*
      * Temperature values might vary to +/-2 degree Celsius
      */
-    temperature = thermistor_read(&thermistor_cfg);
-    WICED_BT_TRACE("Temperature (in degree Celsius) \t\t%d.%02d \n\r",
-                  (temperature / NORM_FACTOR),
+    temperature = temperature_sampler_latest();
+    spi_log_write(SPI_LOG_SAMPLED, temperature / NORM_FACTOR,
                   ABS(temperature % NORM_FACTOR));
-    return temperature;
+    return (uint16_t)temperature;
 }
@@ -0,0 +1,605 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file temperature_sampler.c
+ *
+ * @brief
+ * Background sampling of the thermistor for the SPI slave.
+ *
+ * The timer callback is the only writer of the ring buffer and the SPI thread
+ * the only reader, so each side owns one index and no lock is needed. When
+ * the buffer is full new readings are dropped and counted, the buffered ones
+ * are kept until the master reads them.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include "wiced_timer.h"
+#include "temperature_sampler.h"
+#if ( SAMPLER_CONVERSION == SAMPLER_CONVERSION_LUT )
+#include "thermistor_lut.h"
+#endif
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+#define SAMPLER_RING_MASK                   (SAMPLER_RING_SIZE - 1)
+
+#if ( SAMPLER_RING_SIZE & SAMPLER_RING_MASK )
+#error "SAMPLER_RING_SIZE must be a power of two"
+#endif
+#if ( SAMPLER_AVERAGE < 1 ) || ( SAMPLER_DECIMATION < 1 ) || \
+    ( SAMPLER_SUMMARY_WINDOW < 1 ) || ( SAMPLER_SUMMARY_WINDOW > 0xFFFF )
+#error "Sampler filter settings must be positive, the window at most 0xFFFF"
+#endif
+
+/******************************************************************************
+ *                          Variables Definitions
+ ******************************************************************************/
+static wiced_timer_t        sampler_timer;
+static thermistor_cfg_t    *sampler_cfg;
+
+/* Readings and the time each was taken in ms of the slave clock; head and
+   tail run freely and are masked on access*/
+static volatile int16_t     sampler_ring[SAMPLER_RING_SIZE];
+static volatile uint32_t    sampler_times[SAMPLER_RING_SIZE];
+static volatile uint32_t    sampler_head;
+static volatile uint32_t    sampler_tail;
+static volatile uint32_t    sampler_drops;
+static volatile int16_t     sampler_last;
+
+/* Last conversions and their sum, for the moving average*/
+static int16_t              sampler_average_ring[SAMPLER_AVERAGE];
+static int32_t              sampler_average_sum;
+static uint32_t             sampler_average_count;
+static uint32_t             sampler_average_index;
+
+/* Readings since the last one stored in the ring*/
+static uint32_t             sampler_decimation_count;
+
+/* Summary window being filled and the sum of its readings*/
+static temperature_summary  sampler_window;
+static int32_t              sampler_window_sum;
+/* Complete windows, the last one in sampler_summaries[(windows - 1) & 1].
+   The timer fills the other slot, so the SPI thread reads a slot that is
+   not written for a whole window.*/
+static temperature_summary  sampler_summaries[2];
+static volatile uint32_t    sampler_windows;
+
+/* Change reporting: the configuration, the last reading reported with it,
+   the direction of the last change signaled, -1, 0 or 1, and whom to tell*/
+static volatile report_config sampler_report;
+static volatile int16_t     sampler_report_reference;
+static volatile int8_t      sampler_report_direction;
+static temperature_sampler_change_cback sampler_change_cback;
+
+/* ADC channels scanned with the next reading once a scan was asked for.
+   Complete scans, the last one in sampler_scans[(scans - 1) & 1]; the timer
+   fills the other slot, so the SPI thread reads a slot that is not written
+   for a whole period.*/
+static const ADC_INPUT_CHANNEL_SEL *sampler_scan_list;
+static uint32_t             sampler_scan_length;
+static adc_scan             sampler_scans[2];
+static volatile uint32_t    sampler_scan_count;
+static volatile wiced_bool_t sampler_scan_requested;
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+extern int16_t      thermistor_read(thermistor_cfg_t *p_thermistor_cfg);
+
+static int16_t      temperature_sampler_convert(void);
+
+static int16_t      temperature_sampler_filter(int16_t conversion);
+
+static void         temperature_sampler_summarize(int16_t reading);
+
+static wiced_bool_t temperature_sampler_changed(int16_t reading);
+
+static void         temperature_sampler_scan_adc(uint32_t now_ms);
+
+static void         temperature_sampler_take(TIMER_PARAM_TYPE arg);
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ Function name:  temperature_sampler_start
+
+ Function Description:
+ @brief    Takes a first reading and starts sampling every SAMPLER_PERIOD_MS.
+           Must be called from the application thread, before the readings
+           are used.
+
+ @param  *p_thermistor_cfg  thermistor to sample
+
+ @return void
+ ******************************************************************************/
+
+void temperature_sampler_start(thermistor_cfg_t *p_thermistor_cfg)
+{
+    sampler_cfg = p_thermistor_cfg;
+    temperature_sampler_take(0);
+
+    wiced_init_timer(&sampler_timer, temperature_sampler_take, 0,
+                     WICED_MILLI_SECONDS_PERIODIC_TIMER);
+    wiced_start_timer(&sampler_timer, SAMPLER_PERIOD_MS);
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_latest
+
+ Function Description:
+ @brief    Most recent reading, whether or not it has been read from the ring.
+
+ @param  void
+
+ @return int16_t         Temperature in hundredths of a degree Celsius.
+ ******************************************************************************/
+
+int16_t temperature_sampler_latest(void)
+{
+    return sampler_last;
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_read
+
+ Function Description:
+ @brief    Removes the oldest buffered readings from the ring.
+
+ @param  *samples        buffer for the readings, oldest first
+ @param  max_samples     capacity of samples
+
+ @return uint32_t        number of readings copied
+ ******************************************************************************/
+
+uint32_t temperature_sampler_read(int16_t *samples, uint32_t max_samples)
+{
+    uint32_t count = temperature_sampler_peek(samples, max_samples);
+
+    temperature_sampler_consume(count);
+    return count;
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_peek
+
+ Function Description:
+ @brief    Copies the oldest buffered readings without removing them, for a
+           reader that only knows afterwards how many it can use.
+
+ @param  *samples        buffer for the readings, oldest first
+ @param  max_samples     capacity of samples
+
+ @return uint32_t        number of readings copied
+ ******************************************************************************/
+
+uint32_t temperature_sampler_peek(int16_t *samples, uint32_t max_samples)
+{
+    return temperature_sampler_peek_timed(samples, NULL, max_samples);
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_peek_timed
+
+ Function Description:
+ @brief    Copies the oldest buffered readings and the times they were taken
+           without removing them.
+
+ @param  *samples        buffer for the readings, oldest first
+ @param  *times_ms       buffer for the time of each reading in milliseconds
+                         of clock_SystemTimeMicroseconds64(), or NULL
+ @param  max_samples     capacity of samples and times_ms
+
+ @return uint32_t        number of readings copied
+ ******************************************************************************/
+
+uint32_t temperature_sampler_peek_timed(int16_t *samples, uint32_t *times_ms,
+                                        uint32_t max_samples)
+{
+    uint32_t tail   = sampler_tail;
+    uint32_t count  = sampler_head - tail;
+    uint32_t i;
+
+    if(count > max_samples)
+    {
+        count = max_samples;
+    }
+    for(i = 0; i < count; i++)
+    {
+        samples[i] = sampler_ring[(tail + i) & SAMPLER_RING_MASK];
+        if(NULL != times_ms)
+        {
+            times_ms[i] = sampler_times[(tail + i) & SAMPLER_RING_MASK];
+        }
+    }
+    return count;
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_consume
+
+ Function Description:
+ @brief    Removes readings returned by temperature_sampler_peek().
+
+ @param  count           number of readings, at most the number peeked
+
+ @return void
+ ******************************************************************************/
+
+void temperature_sampler_consume(uint32_t count)
+{
+    /* Only now may the timer reuse the slots*/
+    sampler_tail += count;
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_pending
+
+ Function Description:
+ @brief    Number of readings buffered in the ring.
+
+ @param  void
+
+ @return uint32_t        buffered readings
+ ******************************************************************************/
+
+uint32_t temperature_sampler_pending(void)
+{
+    return sampler_head - sampler_tail;
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_dropped
+
+ Function Description:
+ @brief    Number of readings lost because the ring was full.
+
+ @param  void
+
+ @return uint32_t        dropped readings since start
+ ******************************************************************************/
+
+uint32_t temperature_sampler_dropped(void)
+{
+    return sampler_drops;
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_summary
+
+ Function Description:
+ @brief    Summary of the last complete summary window.
+
+ @param  *summary        summary of the window
+
+ @return wiced_bool_t    WICED_FALSE if no window is complete yet
+ ******************************************************************************/
+
+wiced_bool_t temperature_sampler_summary(temperature_summary *summary)
+{
+    uint32_t windows = sampler_windows;
+
+    if(0 == windows)
+    {
+        return WICED_FALSE;
+    }
+    *summary = sampler_summaries[(windows - 1) & 1];
+    return WICED_TRUE;
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_on_change
+
+ Function Description:
+ @brief    Sets the callback told of readings that changed enough to be
+           reported. Must be called before change reporting is set up.
+
+ @param  cback           change callback, run on the application thread
+
+ @return void
+ ******************************************************************************/
+
+void temperature_sampler_on_change(temperature_sampler_change_cback cback)
+{
+    sampler_change_cback = cback;
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_report
+
+ Function Description:
+ @brief    Reports the latest reading and sets up change reporting relative
+           to it, see report_config. Called for every report, so a slave
+           that restarted picks the configuration up again.
+
+ @param  *config         change reporting, a threshold of 0 turns it off
+
+ @return int16_t         Temperature in hundredths of a degree Celsius.
+ ******************************************************************************/
+
+int16_t temperature_sampler_report(const report_config *config)
+{
+    int16_t reading = sampler_last;
+
+    /* The hysteresis applies against the direction of a signaled change*/
+    if(temperature_sampler_changed(reading))
+    {
+        sampler_report_direction = (reading > sampler_report_reference) ? 1 : -1;
+    }
+    sampler_report_reference = reading;
+    sampler_report = *config;
+    return reading;
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_scan_channels
+
+ Function Description:
+ @brief    Sets the ADC channels of a scan, at most ADC_SCAN_MAX_CHANNELS.
+           Must be called before sampling starts.
+
+ @param  *channels       ADC inputs in scan order, kept by reference
+ @param  count           number of channels, 0 for no scan
+
+ @return void
+ ******************************************************************************/
+
+void temperature_sampler_scan_channels(const ADC_INPUT_CHANNEL_SEL *channels,
+                                       uint32_t count)
+{
+    sampler_scan_list   = channels;
+    sampler_scan_length = MIN(count, ADC_SCAN_MAX_CHANNELS);
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_scan
+
+ Function Description:
+ @brief    Last complete scan of the ADC channels. Also asks for the next
+           one, which the timer takes with the next reading, so the channels
+           are only converted while someone reads the scans.
+
+ @param  *scan           the scan
+
+ @return wiced_bool_t    WICED_FALSE if no scan is complete yet
+ ******************************************************************************/
+
+wiced_bool_t temperature_sampler_scan(adc_scan *scan)
+{
+    uint32_t scans = sampler_scan_count;
+
+    sampler_scan_requested = WICED_TRUE;
+    if(0 == scans)
+    {
+        return WICED_FALSE;
+    }
+    *scan = sampler_scans[(scans - 1) & 1];
+    return WICED_TRUE;
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_convert
+
+ Function Description:
+ @brief    Reads the thermistor with the conversion chosen by
+           SAMPLER_CONVERSION.
+
+ @param  void
+
+ @return int16_t         Temperature in hundredths of a degree Celsius.
+ ******************************************************************************/
+
+static int16_t temperature_sampler_convert(void)
+{
+#if ( SAMPLER_CONVERSION == SAMPLER_CONVERSION_LUT )
+    return thermistor_lut_convert(wiced_hal_adc_read_voltage(sampler_cfg->high_pin),
+                                  wiced_hal_adc_read_voltage(ADC_INPUT_VDDIO));
+#else
+    return thermistor_read(sampler_cfg);
+#endif
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_filter
+
+ Function Description:
+ @brief    Moving average of the last SAMPLER_AVERAGE conversions, or of all
+           of them until there are that many.
+
+ @param  conversion      latest conversion
+
+ @return int16_t         Temperature in hundredths of a degree Celsius.
+ ******************************************************************************/
+
+static int16_t temperature_sampler_filter(int16_t conversion)
+{
+    if(sampler_average_count < SAMPLER_AVERAGE)
+    {
+        sampler_average_count++;
+    }
+    else
+    {
+        sampler_average_sum -= sampler_average_ring[sampler_average_index];
+    }
+    sampler_average_ring[sampler_average_index] = conversion;
+    sampler_average_sum += conversion;
+    sampler_average_index = (sampler_average_index + 1) % SAMPLER_AVERAGE;
+    return (int16_t)(sampler_average_sum / (int32_t)sampler_average_count);
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_summarize
+
+ Function Description:
+ @brief    Adds a reading to the summary window and publishes the window once
+           it holds SAMPLER_SUMMARY_WINDOW readings.
+
+ @param  reading         filtered reading
+
+ @return void
+ ******************************************************************************/
+
+static void temperature_sampler_summarize(int16_t reading)
+{
+    if(0 == sampler_window.count)
+    {
+        sampler_window.min = reading;
+        sampler_window.max = reading;
+        sampler_window_sum = 0;
+    }
+    sampler_window.min = MIN(sampler_window.min, reading);
+    sampler_window.max = MAX(sampler_window.max, reading);
+    sampler_window_sum += reading;
+    if(++sampler_window.count < SAMPLER_SUMMARY_WINDOW)
+    {
+        return;
+    }
+
+    sampler_window.window = (uint16_t)sampler_windows;
+    sampler_window.mean   = (int16_t)(sampler_window_sum / sampler_window.count);
+    sampler_summaries[sampler_windows & 1] = sampler_window;
+    /* Publish the slot only after it has been written*/
+    sampler_windows++;
+    sampler_window.count = 0;
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_changed
+
+ Function Description:
+ @brief    Whether a reading has moved from the last reported one by the
+           report threshold, plus the hysteresis if it turned back against
+           the last signaled change.
+
+ @param  reading         filtered reading
+
+ @return wiced_bool_t    WICED_TRUE if the reading is to be reported
+ ******************************************************************************/
+
+static wiced_bool_t temperature_sampler_changed(int16_t reading)
+{
+    int32_t change = reading - sampler_report_reference;
+    int32_t needed = sampler_report.threshold;
+
+    if(0 == needed)
+    {
+        return WICED_FALSE;
+    }
+    if(((change < 0) && (sampler_report_direction > 0)) ||
+       ((change > 0) && (sampler_report_direction < 0)))
+    {
+        needed += sampler_report.hysteresis;
+    }
+    return (ABS(change) >= needed) ? WICED_TRUE : WICED_FALSE;
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_scan_adc
+
+ Function Description:
+ @brief    Reads every ADC channel of the scan list and publishes the scan.
+
+ @param  now_ms          slave time of the scan
+
+ @return void
+ ******************************************************************************/
+
+static void temperature_sampler_scan_adc(uint32_t now_ms)
+{
+    adc_scan *scan = &sampler_scans[sampler_scan_count & 1];
+    uint32_t  i;
+
+    scan->time_ms = now_ms;
+    scan->count   = (uint8_t)sampler_scan_length;
+    for(i = 0; i < sampler_scan_length; i++)
+    {
+        scan->channel[i] = (uint8_t)sampler_scan_list[i];
+        scan->mv[i]      = (uint16_t)MIN(wiced_hal_adc_read_voltage(sampler_scan_list[i]),
+                                         0xFFFF);
+    }
+    /* Publish the slot only after it has been written*/
+    sampler_scan_count++;
+}
+
+/*******************************************************************************
+ Function name:  temperature_sampler_take
+
+ Function Description:
+ @brief    Timer callback, reads the thermistor and, if one was asked for,
+           scans the ADC channels, filters the reading, adds it to the summary window, passes it on
+           if it changed enough to be reported and buffers every
+           SAMPLER_DECIMATION-th reading with the time of its last
+           conversion.
+
+ @param  arg             unused
+
+ @return void
+ ******************************************************************************/
+
+static void temperature_sampler_take(TIMER_PARAM_TYPE arg)
+{
+    uint32_t head   = sampler_head;
+    int16_t  sample = temperature_sampler_filter(temperature_sampler_convert());
+    uint32_t now_ms = (uint32_t)(clock_SystemTimeMicroseconds64() / 1000);
+
+    if((0 != sampler_scan_length) && sampler_scan_requested)
+    {
+        sampler_scan_requested = WICED_FALSE;
+        temperature_sampler_scan_adc(now_ms);
+    }
+    sampler_last = sample;
+    temperature_sampler_summarize(sample);
+    if((NULL != sampler_change_cback) && temperature_sampler_changed(sample))
+    {
+        sampler_change_cback(sample);
+    }
+    if(++sampler_decimation_count < SAMPLER_DECIMATION)
+    {
+        return;
+    }
+    sampler_decimation_count = 0;
+    if((head - sampler_tail) >= SAMPLER_RING_SIZE)
+    {
+        sampler_drops++;
+        return;
+    }
+    sampler_ring[head & SAMPLER_RING_MASK] = sample;
+    sampler_times[head & SAMPLER_RING_MASK] = now_ms;
+    /* Publish the slot only after it has been written*/
+    sampler_head = head + 1;
+}
@@ -0,0 +1,137 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file temperature_sampler.h
+ *
+ * @brief
+ * Background sampling of the thermistor for the SPI slave.
+ *
+ * The thermistor is read every SAMPLER_PERIOD_MS from an application timer
+ * and each reading is stored in a ring buffer. The SPI thread answers
+ * temperature commands from the latest reading and drains the ring buffer for
+ * burst reads, so no ADC conversion sits in the SPI response path. Each
+ * buffered reading keeps the time it was taken on the slave clock, so a
+ * master can tell when it was taken however late it reads it.
+ *
+ * The master polls far less often than the thermistor is read, so readings
+ * are filtered on the slave: each is the moving average of the last
+ * SAMPLER_AVERAGE conversions, and only every SAMPLER_DECIMATION-th goes
+ * into the ring buffer. The filtered readings of each SAMPLER_SUMMARY_WINDOW
+ * are also summed up into a temperature_summary, which the master can read
+ * once per window instead of reading every value.
+ *
+ * Once the master has set up change reporting with
+ * temperature_sampler_report(), every reading that has moved by the report
+ * threshold from the last reported one is passed to the change callback, so
+ * the slave can signal the master instead of being polled.
+ *
+ * The same timer also reads a list of ADC channels set with
+ * temperature_sampler_scan_channels(), one after the other right after the
+ * thermistor, and keeps the last complete scan for the scan command. It
+ * scans only with the reading after the last scan was read, so the channels
+ * are not converted while nobody asks for them.
+ ******************************************************************************/
+
+#ifndef TEMPERATURE_SAMPLER_H
+#define TEMPERATURE_SAMPLER_H
+
+#include "wiced.h"
+#include "wiced_thermistor.h"
+#include "wiced_hal_adc.h"
+#include "spi_protocol.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+
+/* Interval between two thermistor readings*/
+#define SAMPLER_PERIOD_MS                   (100)
+
+/* Number of readings buffered for burst reads, must be a power of two*/
+#define SAMPLER_RING_SIZE                   (64)
+
+/* Conversions averaged into each reading, 1 for no averaging*/
+#ifndef SAMPLER_AVERAGE
+#define SAMPLER_AVERAGE                     (4)
+#endif
+
+/* Readings per reading stored in the ring buffer, 1 stores all of them*/
+#ifndef SAMPLER_DECIMATION
+#define SAMPLER_DECIMATION                  (1)
+#endif
+
+/* Readings per summary window, 5 s at the default period*/
+#ifndef SAMPLER_SUMMARY_WINDOW
+#define SAMPLER_SUMMARY_WINDOW              (50)
+#endif
+
+/* Conversion of the thermistor voltage to a temperature
+ * SAMPLER_CONVERSION_LIBRARY: thermistor_read() of the thermistor library.
+ * SAMPLER_CONVERSION_LUT:     one ADC reading of the divider and of VDDIO,
+ *                             converted by thermistor_lut_convert().*/
+#define SAMPLER_CONVERSION_LIBRARY          (0)
+#define SAMPLER_CONVERSION_LUT              (1)
+#ifndef SAMPLER_CONVERSION
+#define SAMPLER_CONVERSION                  SAMPLER_CONVERSION_LIBRARY
+#endif
+
+/******************************************************************************
+ *                                Structures
+ ******************************************************************************/
+
+/* Called from the sampling timer with every reading that differs from the
+ * last reported one by the report threshold, until the next report*/
+typedef void (*temperature_sampler_change_cback)(int16_t reading);
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+void        temperature_sampler_start(thermistor_cfg_t *p_thermistor_cfg);
+int16_t     temperature_sampler_latest(void);
+uint32_t    temperature_sampler_read(int16_t *samples, uint32_t max_samples);
+uint32_t    temperature_sampler_peek(int16_t *samples, uint32_t max_samples);
+uint32_t    temperature_sampler_peek_timed(int16_t *samples, uint32_t *times_ms,
+                                           uint32_t max_samples);
+void        temperature_sampler_consume(uint32_t count);
+uint32_t    temperature_sampler_pending(void);
+uint32_t    temperature_sampler_dropped(void);
+wiced_bool_t temperature_sampler_summary(temperature_summary *summary);
+void        temperature_sampler_on_change(temperature_sampler_change_cback cback);
+int16_t     temperature_sampler_report(const report_config *config);
+void        temperature_sampler_scan_channels(const ADC_INPUT_CHANNEL_SEL *channels,
+                                              uint32_t count);
+wiced_bool_t temperature_sampler_scan(adc_scan *scan);
+
+#endif /* TEMPERATURE_SAMPLER_H */
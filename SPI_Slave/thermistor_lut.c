@@ -0,0 +1,98 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file thermistor_lut.c
+ *
+ * @brief
+ * Table lookup conversion of thermistor readings, see thermistor_lut.h.
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                Includes
+ ******************************************************************************/
+#include "thermistor_lut.h"
+#include "thermistor_lut_table.h"
+
+/******************************************************************************
+ *                                Macros
+ ******************************************************************************/
+#define THERMISTOR_LUT_STEP_MASK            ((1u << THERMISTOR_LUT_STEP_BITS) - 1)
+
+/******************************************************************************
+ *                                Function Definitions
+ ******************************************************************************/
+
+/*******************************************************************************
+ Function name:  thermistor_lut_convert
+
+ Function Description:
+ @brief    Converts the voltage of the thermistor divider to a temperature.
+           Readings outside the table give the temperature at its nearest
+           end.
+
+ @param  input_mv        voltage at the thermistor, below 65.5 V
+ @param  vddio_mv        voltage at the top of the divider
+
+ @return int16_t         Temperature in hundredths of a degree Celsius.
+ ******************************************************************************/
+
+int16_t thermistor_lut_convert(uint32_t input_mv, uint32_t vddio_mv)
+{
+    uint32_t ratio;
+    uint32_t index;
+    uint32_t fraction;
+
+    /* An open thermistor reads as the full supply*/
+    if(input_mv >= vddio_mv)
+    {
+        return thermistor_lut[THERMISTOR_LUT_SIZE - 1];
+    }
+    ratio = (input_mv << THERMISTOR_LUT_RATIO_BITS) / vddio_mv;
+    if(ratio <= THERMISTOR_LUT_FIRST)
+    {
+        return thermistor_lut[0];
+    }
+    ratio   -= THERMISTOR_LUT_FIRST;
+    index    = ratio >> THERMISTOR_LUT_STEP_BITS;
+    fraction = ratio & THERMISTOR_LUT_STEP_MASK;
+    if(index >= THERMISTOR_LUT_SIZE - 1)
+    {
+        return thermistor_lut[THERMISTOR_LUT_SIZE - 1];
+    }
+
+    /* The entries fall as the ratio rises*/
+    return thermistor_lut[index] -
+           (int16_t)(((uint32_t)(thermistor_lut[index] - thermistor_lut[index + 1]) *
+                      fraction) >> THERMISTOR_LUT_STEP_BITS);
+}
@@ -0,0 +1,58 @@
+/*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ * @file thermistor_lut.h
+ *
+ * @brief
+ * Integer conversion of thermistor readings through a lookup table.
+ *
+ * The table is generated before the build by scripts/thermistor_lut.py from
+ * the beta parameters of the thermistor. It maps the voltage of the
+ * thermistor divider relative to VDDIO to hundredths of a degree Celsius, and
+ * a reading between two entries is interpolated linearly. A conversion takes
+ * one division and one table access, and needs no floating point.
+ ******************************************************************************/
+
+#ifndef THERMISTOR_LUT_H
+#define THERMISTOR_LUT_H
+
+#include "wiced.h"
+
+/******************************************************************************
+ *                                Function Prototypes
+ ******************************************************************************/
+
+int16_t     thermistor_lut_convert(uint32_t input_mv, uint32_t vddio_mv);
+
+#endif /* THERMISTOR_LUT_H */